@@ -0,0 +1,106 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "../bitset.h"
+
+namespace ds {
+using namespace ::testing;
+
+TEST(DynamicBitsetTest, SetTestCount) {
+  DynamicBitset b(130);
+  ASSERT_EQ(b.Size(), 130);
+  ASSERT_EQ(b.WordCount(), 3);
+  ASSERT_TRUE(b.None());
+
+  b.Set(0);
+  b.Set(64);
+  b.Set(129);
+  ASSERT_TRUE(b.Test(64));
+  ASSERT_FALSE(b.Test(63));
+  ASSERT_TRUE(b[129]);
+  ASSERT_EQ(b.Count(), 3);
+
+  b.Reset(64);
+  b.Flip(1);
+  ASSERT_FALSE(b.Test(64));
+  ASSERT_TRUE(b.Test(1));
+
+  ASSERT_FALSE(b.TestAndSet(70));
+  ASSERT_TRUE(b.TestAndSet(70));
+  ASSERT_EQ(b.Count(), 4);
+
+  b.SetAll();
+  ASSERT_EQ(b.Count(), 130);
+  b.ResetAll();
+  ASSERT_EQ(b.Count(), 0);
+
+  DynamicBitset full(70, true);
+  ASSERT_EQ(full.Count(), 70);
+  ASSERT_EQ(full.Word(1), 0x3f);
+}
+
+TEST(DynamicBitsetTest, FindNext) {
+  DynamicBitset b(300);
+  ASSERT_EQ(b.FindFirst(), DynamicBitset::NPOS);
+
+  for (size_t i : { 3, 63, 64, 200, 299 }) {
+    b.Set(i);
+  }
+
+  ArrayList<size_t> found;
+  for (size_t i = b.FindFirst(); i != DynamicBitset::NPOS; i = b.FindNext(i)) {
+    found.Append(i);
+  }
+  ASSERT_THAT(found, ElementsAreArray({ 3, 63, 64, 200, 299 }));
+
+  ArrayList<size_t> each;
+  b.ForEachSet([&each](size_t i) { each.Append(i); });
+  ASSERT_THAT(each, ElementsAreArray({ 3, 63, 64, 200, 299 }));
+}
+
+TEST(DynamicBitsetTest, WordOperations) {
+  DynamicBitset a(100);
+  DynamicBitset b(100);
+  for (size_t i = 0; i < 100; i += 2) a.Set(i);
+  for (size_t i = 0; i < 100; i += 3) b.Set(i);
+
+  DynamicBitset both(a);
+  both &= b;
+  ASSERT_EQ(both.Count(), 17);
+  ASSERT_TRUE(both.Test(6));
+  ASSERT_FALSE(both.Test(4));
+
+  DynamicBitset either(a);
+  either |= b;
+  ASSERT_EQ(either.Count(), 50 + 34 - 17);
+
+  DynamicBitset odd(a);
+  odd ^= b;
+  ASSERT_EQ(odd.Count(), 50 + 34 - 2 * 17);
+
+  DynamicBitset onlyA(a);
+  onlyA.Subtract(b);
+  ASSERT_EQ(onlyA.Count(), 50 - 17);
+  ASSERT_TRUE(onlyA == (odd &= a));
+}
+
+TEST(DynamicBitsetTest, Resize) {
+  DynamicBitset b(10);
+  b.Set(9);
+
+  b.Resize(100, true);
+  ASSERT_EQ(b.Count(), 91);
+  ASSERT_FALSE(b.Test(0));
+  ASSERT_TRUE(b.Test(10));
+
+  b.Resize(5);
+  ASSERT_EQ(b.Size(), 5);
+  ASSERT_EQ(b.Count(), 0);
+
+  b.Resize(64, true);
+  ASSERT_EQ(b.Count(), 59);
+}
+
+} // namespace ds
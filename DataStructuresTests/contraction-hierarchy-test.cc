@@ -0,0 +1,223 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "../contraction-hierarchy.h"
+#include "test-util.h"
+
+namespace ds {
+using namespace ::testing;
+
+namespace {
+
+// A side x side street grid with weights in [1, 10]. About one street in
+// eight is one-way, and every fourth row and column is a faster arterial.
+AdjacencyListGraph<int, uint32_t> road_grid(size_t side, uint64_t seed) {
+  AdjacencyListGraph<int, uint32_t> g;
+  g.Reserve(side * side, 4 * side * side);
+  uint64_t x = seed;
+
+  for (size_t i = 0; i < side * side; ++i) {
+    g.AddNode();
+  }
+
+  auto street = [&](size_t a, size_t b, bool arterial) {
+    double w = static_cast<double>(arterial ? 1 + next_random(x) % 3 : 4 + next_random(x) % 7);
+    switch (next_random(x) % 16) {
+    case 0:  g.AddEdge(a, b, w); break;
+    case 1:  g.AddEdge(b, a, w); break;
+    default: g.AddEdge(a, b, w); g.AddEdge(b, a, w); break;
+    }
+  };
+
+  for (size_t r = 0; r < side; ++r) {
+    for (size_t c = 0; c < side; ++c) {
+      size_t n = r * side + c;
+      if (c + 1 < side) street(n, n + 1, r % 4 == 0);
+      if (r + 1 < side) street(n, n + side, c % 4 == 0);
+    }
+  }
+
+  return g;
+}
+
+} // namespace
+
+TEST(ContractionHierarchyTest, Small) {
+  AdjacencyListGraph<int> g(5, { 0, 10, 20, 30, 40 },
+    { {0, 1, 4}, {0, 2, 1}, {2, 1, 1}, {1, 3, 1}, {2, 3, 5}, {3, 0, 2} }
+  );
+  ContractionHierarchy<> ch(g);
+  ContractionHierarchy<>::Query query(ch);
+
+  ASSERT_EQ(ch.NodeCount(), 5);
+  ASSERT_GE(ch.ArcCount(), g.EdgeCount());
+
+  auto path = query.ShortestPath(0, 3);
+  ASSERT_THAT(path.first, ElementsAreArray<size_t>({ 0, 2, 1, 3 }));
+  ASSERT_EQ(path.second, 3);
+  ASSERT_EQ(query.Distance(3, 1), 4);
+
+  auto self = query.ShortestPath(2, 2);
+  ASSERT_TRUE(self.first.isEmpty());
+  ASSERT_EQ(self.second, 0);
+
+  auto unreachable = query.ShortestPath(0, 4);
+  ASSERT_TRUE(unreachable.first.isEmpty());
+  ASSERT_EQ(unreachable.second, std::numeric_limits<double>::max());
+  ASSERT_EQ(query.Distance(4, 0), std::numeric_limits<double>::max());
+}
+
+TEST(ContractionHierarchyTest, MatchesDikstras) {
+  constexpr size_t SIDE = 40;
+  auto g = road_grid(SIDE, 88172645463325252u);
+  ContractionHierarchy<uint32_t> ch(g);
+  ContractionHierarchy<uint32_t>::Query query(ch);
+
+  uint64_t x = 2463534242u;
+  for (int i = 0; i < 300; ++i) {
+    size_t start = next_random(x) % (SIDE * SIDE);
+    size_t end = next_random(x) % (SIDE * SIDE);
+
+    auto expected = g.Dikstras(start, end);
+    auto path = query.ShortestPath(start, end);
+
+    ASSERT_EQ(query.Distance(start, end), expected.second);
+    ASSERT_EQ(path.second, expected.second);
+    if (!expected.first.isEmpty()) {
+      ASSERT_EQ(path.first[0], start);
+      ASSERT_EQ(path.first[path.first.Size() - 1], end);
+      ASSERT_EQ(path_length(g, path.first), expected.second);
+    }
+    else {
+      ASSERT_TRUE(path.first.isEmpty());
+    }
+  }
+}
+
+TEST(ContractionHierarchyTest, SaveLoad) {
+  constexpr size_t SIDE = 20;
+  auto g = road_grid(SIDE, 11400714819323198485u);
+  ContractionHierarchy<uint32_t> ch(g);
+  auto path = std::filesystem::temp_directory_path() / "ds-ch.bin";
+
+  ASSERT_TRUE(ch.Save(path));
+
+  ContractionHierarchy<uint32_t> loaded;
+  ASSERT_TRUE(loaded.Load(path));
+  ASSERT_EQ(loaded.NodeCount(), ch.NodeCount());
+  ASSERT_EQ(loaded.ArcCount(), ch.ArcCount());
+
+  // Another index width is rejected.
+  ContractionHierarchy<uint64_t> wide;
+  ASSERT_FALSE(wide.Load(path));
+
+  // So is a header whose counts overrun the file, before anything is
+  // allocated from them.
+  {
+    std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(24);
+    uint64_t huge = uint64_t(1) << 60;
+    f.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+  }
+  ASSERT_FALSE(loaded.Load(path));
+  ASSERT_TRUE(ch.Save(path));
+
+  // And a truncated file, leaving the hierarchy as it was.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+  ASSERT_FALSE(loaded.Load(path));
+  std::filesystem::remove(path);
+  ASSERT_FALSE(loaded.Load(path));
+
+  ContractionHierarchy<uint32_t>::Query original(ch);
+  ContractionHierarchy<uint32_t>::Query query(loaded);
+  for (size_t start = 0; start < SIDE * SIDE; start += 37) {
+    for (size_t end = 0; end < SIDE * SIDE; end += 23) {
+      auto expected = original.ShortestPath(start, end);
+      auto actual = query.ShortestPath(start, end);
+      ASSERT_EQ(actual.second, expected.second);
+      ASSERT_TRUE(actual.first.isEqual(expected.first));
+    }
+  }
+}
+
+TEST(ContractionHierarchyTest, QueryOutlivesLoad) {
+  auto small = road_grid(5, 2463534242u);
+  auto large = road_grid(20, 88172645463325252u);
+  ContractionHierarchy<uint32_t> ch(small);
+  ContractionHierarchy<uint32_t> expected(large);
+  auto path = std::filesystem::temp_directory_path() / "ds-ch-grow.bin";
+  ASSERT_TRUE(expected.Save(path));
+
+  ContractionHierarchy<uint32_t>::Query query(ch);
+  ASSERT_EQ(query.Distance(0, 24), small.Dikstras(0, 24).second);
+
+  // The query was sized for 25 nodes; the hierarchy now has 400.
+  ASSERT_TRUE(ch.Load(path));
+  std::filesystem::remove(path);
+  for (size_t end = 0; end < 400; end += 19) {
+    ASSERT_EQ(query.Distance(399, end), large.Dikstras(399, end).second);
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(ContractionHierarchyBenchmark, DISABLED_QueryLatency) {
+  constexpr size_t SIDE = 500;
+  constexpr size_t DIKSTRAS_QUERIES = 50;
+  constexpr size_t QUERIES = 100000;
+  using Clock = std::chrono::steady_clock;
+
+  auto g = road_grid(SIDE, 88172645463325252u);
+
+  auto begin = Clock::now();
+  ContractionHierarchy<uint32_t> ch(g);
+  double buildSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+  std::cout << SIDE * SIDE << " nodes, " << g.EdgeCount() << " edges; preprocessing "
+            << buildSeconds << " s, " << ch.ShortcutCount() << " shortcuts" << std::endl;
+
+  ArrayList<std::pair<size_t, size_t>> pairs;
+  uint64_t x = 2463534242u;
+  for (size_t i = 0; i < QUERIES; ++i) {
+    size_t start = next_random(x) % (SIDE * SIDE);
+    pairs.Append(std::make_pair(start, next_random(x) % (SIDE * SIDE)));
+  }
+
+  ArrayList<double> expected;
+  begin = Clock::now();
+  for (size_t i = 0; i < DIKSTRAS_QUERIES; ++i) {
+    expected.Append(g.Dikstras(pairs[i].first, pairs[i].second).second);
+  }
+  double dikstrasUs = std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / DIKSTRAS_QUERIES;
+
+  ContractionHierarchy<uint32_t>::Query query(ch);
+  double checksum = 0;
+  begin = Clock::now();
+  for (auto& p : pairs) {
+    double d = query.Distance(p.first, p.second);
+    checksum += d < std::numeric_limits<double>::max() ? d : 0;
+  }
+  double distanceUs = std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / QUERIES;
+
+  begin = Clock::now();
+  for (auto& p : pairs) {
+    double d = query.ShortestPath(p.first, p.second).second;
+    checksum -= d < std::numeric_limits<double>::max() ? d : 0;
+  }
+  double pathUs = std::chrono::duration<double, std::micro>(Clock::now() - begin).count() / QUERIES;
+
+  std::cout << "Dikstras: " << dikstrasUs << " us/query" << std::endl;
+  std::cout << "ContractionHierarchy Distance: " << distanceUs << " us/query, ShortestPath: "
+            << pathUs << " us/query (" << dikstrasUs / distanceUs << "x)" << std::endl;
+
+  ASSERT_EQ(checksum, 0);
+  for (size_t i = 0; i < DIKSTRAS_QUERIES; ++i) {
+    ASSERT_EQ(query.Distance(pairs[i].first, pairs[i].second), expected[i]);
+  }
+}
+
+} // namespace ds
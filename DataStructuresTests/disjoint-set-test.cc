@@ -0,0 +1,90 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "../disjoint-set.h"
+#include "../thread-pool.h"
+
+namespace ds {
+using namespace ::testing;
+
+TEST(DisjointSetTest, Union) {
+  DisjointSet<uint32_t> sets(6);
+  ASSERT_EQ(sets.Size(), 6);
+  ASSERT_EQ(sets.SetCount(), 6);
+
+  ASSERT_TRUE(sets.Union(0, 1));
+  ASSERT_TRUE(sets.Union(2, 3));
+  ASSERT_TRUE(sets.Union(1, 3));
+  ASSERT_FALSE(sets.Union(0, 2));
+  ASSERT_EQ(sets.SetCount(), 3);
+
+  ASSERT_TRUE(sets.isConnected(0, 3));
+  ASSERT_FALSE(sets.isConnected(0, 4));
+  ASSERT_EQ(sets.Find(0), sets.Find(2));
+  ASSERT_EQ(sets.SetSize(1), 4);
+  ASSERT_EQ(sets.SetSize(5), 1);
+
+  ASSERT_EQ(sets.Add(), 6);
+  ASSERT_TRUE(sets.Union(6, 5));
+  ASSERT_EQ(sets.SetCount(), 3);
+  ASSERT_EQ(sets.SetSize(6), 2);
+}
+
+TEST(DisjointSetTest, LongChain) {
+  constexpr size_t COUNT = 100000;
+  DisjointSet<> sets(COUNT);
+
+  for (size_t i = 1; i < COUNT; ++i) {
+    ASSERT_TRUE(sets.Union(i - 1, i));
+  }
+
+  ASSERT_EQ(sets.SetCount(), 1);
+  ASSERT_EQ(sets.SetSize(COUNT / 2), COUNT);
+  for (size_t i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(sets.Find(i), sets.Find(0));
+  }
+}
+
+TEST(ConcurrentDisjointSetTest, Union) {
+  ConcurrentDisjointSet sets(5);
+  ASSERT_EQ(sets.Size(), 5);
+
+  ASSERT_TRUE(sets.Union(3, 4));
+  ASSERT_TRUE(sets.Union(0, 4));
+  ASSERT_FALSE(sets.Union(3, 0));
+
+  ASSERT_EQ(sets.Find(4), 0);
+  ASSERT_TRUE(sets.isConnected(0, 3));
+  ASSERT_FALSE(sets.isConnected(1, 2));
+}
+
+TEST(ConcurrentDisjointSetTest, ParallelUnions) {
+  constexpr size_t COUNT = 50000;
+  constexpr size_t MODULUS = 7;
+
+  // Every thread joins each i with i + MODULUS, so all unions race and
+  // exactly COUNT - MODULUS of them succeed, leaving the residues mod 7.
+  ConcurrentDisjointSet sets(COUNT);
+  ThreadPool pool(4);
+  std::atomic<size_t> joined(0);
+
+  pool.Run([&](size_t worker) {
+    for (size_t k = 0; k + MODULUS < COUNT; ++k) {
+      size_t i = (k * 7919 + worker * 104729) % (COUNT - MODULUS);
+      if (sets.Union(i + MODULUS, i)) {
+        ++joined;
+      }
+    }
+  });
+
+  ASSERT_EQ(joined, COUNT - MODULUS);
+  for (size_t i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(sets.Find(i), i % MODULUS);
+    ASSERT_TRUE(sets.isConnected(i, i % MODULUS));
+    ASSERT_FALSE(sets.isConnected(i, (i + 1) % MODULUS));
+  }
+}
+
+} // namespace ds
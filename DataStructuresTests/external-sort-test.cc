@@ -0,0 +1,252 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "../external-sort.h"
+#include "test-util.h"
+
+namespace ds {
+using namespace ::testing;
+
+class ExternalSortTest : public Test {
+protected:
+  std::filesystem::path in_;
+  std::filesystem::path out_;
+
+  void SetUp() override {
+    auto dir = std::filesystem::temp_directory_path();
+    auto name = std::string(UnitTest::GetInstance()->current_test_info()->name());
+    in_ = dir / ("ds-external-sort-" + name + ".in");
+    out_ = dir / ("ds-external-sort-" + name + ".out");
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    std::filesystem::remove(in_, ec);
+    std::filesystem::remove(out_, ec);
+  }
+
+  template <class T>
+  void WriteRecords(const ArrayList<T>& records) {
+    std::ofstream f(in_, std::ios::binary);
+    f.write(reinterpret_cast<const char*>(records.begin()), records.Size() * sizeof(T));
+  }
+
+  template <class T>
+  ArrayList<T> ReadRecords() {
+    std::ifstream f(out_, std::ios::binary);
+    ArrayList<T> records;
+    T val;
+    while (f.read(reinterpret_cast<char*>(&val), sizeof(T))) {
+      records.Append(val);
+    }
+    return records;
+  }
+};
+
+TEST_F(ExternalSortTest, SingleRun) {
+  WriteRecords(ArrayList<int>{ 5, 3, 9, 1, 7 });
+
+  auto stats = external_sort_records<int>(in_, out_);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->runs, 1);
+  EXPECT_EQ(stats->records, 5);
+  EXPECT_EQ(stats->bytes, 5 * sizeof(int));
+  ASSERT_THAT(ReadRecords<int>(), ElementsAreArray({ 1, 3, 5, 7, 9 }));
+}
+
+TEST_F(ExternalSortTest, ManyRuns) {
+  ArrayList<uint64_t> in;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    in.Append((i * 7919) % 10000);
+  }
+  WriteRecords(in);
+
+  ExternalSortOptions options;
+  options.memory_bytes = 1000 * sizeof(uint64_t);
+  options.buffer_bytes = 4096;
+
+  auto stats = external_sort_records<uint64_t>(in_, out_, descending, options);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->runs, 10);
+  EXPECT_EQ(stats->records, 10000);
+
+  auto out = ReadRecords<uint64_t>();
+  ASSERT_EQ(out.Size(), 10000);
+  for (size_t i = 0; i < out.Size(); ++i) {
+    ASSERT_EQ(out[i], 9999 - i);
+  }
+}
+
+TEST_F(ExternalSortTest, Lines) {
+  {
+    std::ofstream f(in_, std::ios::binary);
+    f << "pear\napple\ncherry\nbanana\napple\n";
+  }
+
+  ExternalSortOptions options;
+  options.memory_bytes = 1;
+
+  auto stats = external_sort_lines(in_, out_, ascending, options);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->runs, 5);
+
+  std::ifstream f(out_, std::ios::binary);
+  ArrayList<std::string> lines;
+  std::string line;
+  while (std::getline(f, line)) {
+    lines.Append(line);
+  }
+  ASSERT_THAT(lines, ElementsAreArray({ "apple", "apple", "banana", "cherry", "pear" }));
+}
+
+TEST_F(ExternalSortTest, TemporaryComparators) {
+  struct Record {
+    int key_;
+    int id_;
+  };
+
+  ArrayList<Record> in;
+  for (int i = 0; i < 3000; ++i) {
+    in.Append(Record{ (i * 37) % 10, i });
+  }
+  WriteRecords(in);
+
+  ExternalSortOptions options;
+  options.memory_bytes = 500 * sizeof(Record);
+
+  // Equal keys keep their input order across runs.
+  ASSERT_TRUE((external_sort_records<Record>(in_, out_, by_key(&Record::key_), options).has_value()));
+  auto out = ReadRecords<Record>();
+  ASSERT_EQ(out.Size(), in.Size());
+  for (size_t i = 1; i < out.Size(); ++i) {
+    ASSERT_TRUE(out[i - 1].key_ < out[i].key_ || (out[i - 1].key_ == out[i].key_ && out[i - 1].id_ < out[i].id_));
+  }
+
+  {
+    std::ofstream f(in_, std::ios::binary);
+    f << "ccc\na\nbb\n";
+  }
+  auto shorter = [](const std::string& lhs, const std::string& rhs) { return lhs.size() < rhs.size(); };
+  ASSERT_TRUE(external_sort_lines(in_, out_, shorter).has_value());
+  ASSERT_TRUE(external_sort_lines(in_, out_, [](const std::string& lhs, const std::string& rhs) {
+    return lhs.size() > rhs.size();
+  }).has_value());
+
+  std::ifstream f(out_, std::ios::binary);
+  std::string line;
+  ASSERT_TRUE(std::getline(f, line));
+  ASSERT_EQ(line, "ccc");
+}
+
+TEST_F(ExternalSortTest, MergePasses) {
+  struct Record {
+    uint32_t key_;
+    uint32_t id_;
+  };
+
+  ArrayList<Record> in;
+  uint64_t x = 88172645463325252u;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    in.Append(Record{ static_cast<uint32_t>(next_random(x) % 50), i });
+  }
+  WriteRecords(in);
+
+  auto dir = std::filesystem::temp_directory_path() / "ds-external-sort-MergePasses";
+  std::filesystem::create_directories(dir);
+
+  // 50 runs with room for only 3 open at once: 50 -> 17 -> 6 -> 2 -> 1.
+  ExternalSortOptions options;
+  options.memory_bytes = 100 * sizeof(Record);
+  options.buffer_bytes = options.memory_bytes / 3;
+  options.temp_dir = dir;
+
+  auto stats = external_sort_records<Record>(in_, out_, by_key(&Record::key_), options);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->runs, 50);
+  EXPECT_EQ(stats->merge_passes, 4);
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+  std::filesystem::remove(dir);
+
+  // Equal keys keep their input order through every pass.
+  auto out = ReadRecords<Record>();
+  ASSERT_EQ(out.Size(), in.Size());
+  for (size_t i = 1; i < out.Size(); ++i) {
+    ASSERT_TRUE(out[i - 1].key_ < out[i].key_ || (out[i - 1].key_ == out[i].key_ && out[i - 1].id_ < out[i].id_));
+  }
+}
+
+TEST_F(ExternalSortTest, MissingInput) {
+  ASSERT_FALSE(external_sort_lines(in_, out_).has_value());
+}
+
+TEST_F(ExternalSortTest, SameFile) {
+  WriteRecords(ArrayList<int>{ 5, 3, 9 });
+
+  ASSERT_FALSE(external_sort_records<int>(in_, in_).has_value());
+  ASSERT_EQ(std::filesystem::file_size(in_), 3 * sizeof(int));
+}
+
+TEST_F(ExternalSortTest, PartialRecord) {
+  WriteRecords(ArrayList<int>{ 5, 3, 9 });
+  {
+    std::ofstream f(in_, std::ios::binary | std::ios::app);
+    f.put('x');
+  }
+
+  ASSERT_FALSE(external_sort_records<int>(in_, out_).has_value());
+  ASSERT_FALSE(std::filesystem::exists(out_));
+
+  // The same across several runs.
+  ExternalSortOptions options;
+  options.memory_bytes = sizeof(int);
+  ASSERT_FALSE(external_sort_records<int>(in_, out_, ascending, options).has_value());
+  ASSERT_FALSE(std::filesystem::exists(out_));
+}
+
+TEST_F(ExternalSortTest, EmptyInput) {
+  WriteRecords(ArrayList<int>{});
+
+  auto stats = external_sort_records<int>(in_, out_);
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->records, 0);
+  ASSERT_TRUE(ReadRecords<int>().isEmpty());
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(ExternalSortBenchmark, DISABLED_Throughput) {
+  auto dir = std::filesystem::temp_directory_path();
+  auto in = dir / "ds-external-sort-bench.in";
+  auto out = dir / "ds-external-sort-bench.out";
+
+  ExternalSortOptions options;
+  options.memory_bytes = size_t(16) << 20;
+
+  for (size_t megabytes : { 8, 64, 256 }) {
+    size_t count = (megabytes << 20) / sizeof(uint64_t);
+    {
+      ArrayList<uint64_t> records(count);
+      uint64_t x = 88172645463325252u;
+      for (size_t i = 0; i < count; ++i) {
+        records.Append(next_random(x));
+      }
+      std::ofstream f(in, std::ios::binary);
+      f.write(reinterpret_cast<const char*>(records.begin()), count * sizeof(uint64_t));
+    }
+
+    auto stats = external_sort_records<uint64_t>(in, out, ascending, options);
+    ASSERT_TRUE(stats.has_value());
+    ASSERT_EQ(stats->records, count);
+    std::cout << megabytes << " MB in " << stats->runs << " runs: " << stats->seconds * 1000 << " ms, "
+              << stats->MegabytesPerSecond() << " MB/s" << std::endl;
+  }
+
+  std::filesystem::remove(in);
+  std::filesystem::remove(out);
+}
+
+} // namespace ds
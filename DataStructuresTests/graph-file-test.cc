@@ -0,0 +1,242 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "../graph-file.h"
+#include "test-util.h"
+
+namespace ds {
+using namespace ::testing;
+
+namespace {
+
+// Whether g has the same values and edges, in the same order, as expected.
+template <class Graph, class Expected>
+bool same_graph(const Graph& g, const Expected& expected) {
+  if (g.NodeCount() != expected.NodeCount() || g.EdgeCount() != expected.EdgeCount()) {
+    return false;
+  }
+
+  for (size_t n = 0; n < g.NodeCount(); ++n) {
+    ArrayList<GraphEdge> edges;
+    expected.ForEachEdge(n, [&](size_t dest, double weight) { edges.Append(GraphEdge(n, dest, weight)); });
+
+    size_t i = 0;
+    bool same = g.Value(n) == expected.Value(n) && g.Degree(n) == edges.Size();
+    g.ForEachEdge(n, [&](size_t dest, double weight) {
+      same = same && i < edges.Size() && edges[i].dest_ == dest && edges[i].weight_ == weight;
+      ++i;
+    });
+    if (!same) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+TEST(GraphFileTest, SaveAndMap) {
+  AdjacencyListGraph<int, uint32_t> g(5, { 10, 11, 12, 13, 14 },
+    { {0, 1, 4}, {0, 2, 1}, {2, 1, 1}, {1, 3, 1}, {2, 3, 5}, {3, 0, 2.5} }
+  );
+  auto path = std::filesystem::temp_directory_path() / "ds-graph.bin";
+  ASSERT_TRUE(save_graph<uint32_t>(g, path));
+
+  MappedGraph<int, uint32_t> mapped;
+  ASSERT_TRUE(mapped.Open(path));
+  ASSERT_TRUE(same_graph(mapped, g));
+  ASSERT_EQ(mapped.Value(4), 14);
+  ASSERT_EQ(mapped.Degree(4), 0);
+
+  auto path03 = mapped.Dikstras(0, 3);
+  ASSERT_THAT(path03.first, ElementsAreArray<size_t>({ 0, 2, 1, 3 }));
+  ASSERT_EQ(path03.second, 3);
+
+  ArrayList<size_t> visited;
+  auto visit = [&visited](size_t node) { visited.Append(node); };
+  mapped.DFS(0, visit);
+  ASSERT_EQ(visited.Size(), 4);
+
+  ThreadPool pool(2);
+  ASSERT_EQ(mapped.ConnectedComponents(pool).count_, 2);
+  ASSERT_TRUE(same_graph(mapped.ToCSR(), g));
+
+  // Another value or index type, a truncated file and a missing one are
+  // all rejected, leaving the graph empty.
+  ASSERT_FALSE((MappedGraph<double, uint32_t>().Open(path)));
+  ASSERT_FALSE((MappedGraph<int, uint64_t>().Open(path)));
+
+  mapped.Close();
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+  ASSERT_FALSE(mapped.Open(path));
+  ASSERT_EQ(mapped.NodeCount(), 0);
+  std::filesystem::remove(path);
+  ASSERT_FALSE(mapped.Open(path));
+}
+
+TEST(GraphFileTest, Writer) {
+  auto path = std::filesystem::temp_directory_path() / "ds-graph-writer.bin";
+  {
+    GraphWriter<double> writer(path);
+    writer.AddNode(0.5);
+    writer.AddEdge(2, 3);
+    writer.AddEdge(1);
+    writer.AddNode(1.5);
+    writer.AddNode(2.5);
+    writer.AddEdge(0, 7);
+    ASSERT_EQ(writer.NodeCount(), 3);
+    ASSERT_EQ(writer.EdgeCount(), 3);
+    ASSERT_TRUE(writer.Close());
+  }
+
+  MappedGraph<double> mapped;
+  ASSERT_TRUE(mapped.Open(path));
+  CSRGraph<double> expected({ 0.5, 1.5, 2.5 }, { {0, 2, 3}, {0, 1, 1}, {2, 0, 7} });
+  ASSERT_TRUE(same_graph(mapped, expected));
+  mapped.Close();
+
+  // An edge to a node never added fails the file.
+  {
+    GraphWriter<double> writer(path);
+    writer.AddNode();
+    writer.AddEdge(1);
+    ASSERT_FALSE(writer.Close());
+  }
+  ASSERT_FALSE(std::filesystem::exists(path));
+
+  // An empty graph is still a file.
+  ASSERT_TRUE(GraphWriter<double>(path).Close());
+  ASSERT_TRUE(mapped.Open(path));
+  ASSERT_EQ(mapped.NodeCount(), 0);
+  ASSERT_EQ(mapped.EdgeCount(), 0);
+  mapped.Close();
+  std::filesystem::remove(path);
+}
+
+TEST(GraphFileTest, ConvertEdgeList) {
+  auto text = std::filesystem::temp_directory_path() / "ds-graph-edges.txt";
+  auto path = std::filesystem::temp_directory_path() / "ds-graph-edges.bin";
+  ThreadPool pool(3);
+
+  // SNAP style, against LoadEdgeList.
+  {
+    std::ofstream f(text, std::ios::binary);
+    f << "# comment\n0 1\n1\t2 2.5\r\n\n0 3 4\n% another\n3 2";
+  }
+  auto edges = convert_edge_list(text, path, pool);
+  ASSERT_TRUE(edges.has_value());
+  ASSERT_EQ(*edges, 4);
+
+  AdjacencyListGraph<int> expected;
+  ASSERT_TRUE(expected.LoadEdgeList(text).has_value());
+  MappedGraph<int> mapped;
+  ASSERT_TRUE(mapped.Open(path));
+  ASSERT_TRUE(same_graph(mapped, expected));
+  mapped.Close();
+
+  // DIMACS, 1-based, with a declared node count beyond the last edge.
+  {
+    std::ofstream f(text, std::ios::binary);
+    f << "c road network\np sp 6 3\na 1 2 7\na 2 3 1\na 3 1 2\n";
+  }
+  ASSERT_EQ(convert_edge_list(text, path, pool), 3);
+  ASSERT_TRUE(mapped.Open(path));
+  ASSERT_TRUE(same_graph(mapped, CSRGraph<int>({ 0, 0, 0, 0, 0, 0 }, { {0, 1, 7}, {1, 2, 1}, {2, 0, 2} })));
+  mapped.Close();
+
+  // Big enough to be parsed in several chunks.
+  constexpr size_t NODES = 100000;
+  AdjacencyListGraph<int> big;
+  for (size_t n = 0; n < NODES; ++n) {
+    big.AddNode();
+  }
+  {
+    std::ofstream f(text, std::ios::binary);
+    uint64_t x = 88172645463325252u;
+    for (size_t i = 0; i < 1000000; ++i) {
+      size_t src = next_random(x) % NODES;
+      size_t dest = next_random(x) % NODES;
+      double weight = static_cast<double>(next_random(x) % 100);
+      f << src << ' ' << dest << ' ' << weight << '\n';
+      big.AddEdge(src, dest, weight);
+    }
+  }
+  ASSERT_GT(std::filesystem::file_size(text), size_t(3) << 22);
+  ASSERT_EQ((convert_edge_list<int, uint32_t>(text, path, pool)), 1000000);
+  MappedGraph<int, uint32_t> mappedBig;
+  ASSERT_TRUE(mappedBig.Open(path));
+  ASSERT_EQ(mappedBig.NodeCount(), NODES);
+  ASSERT_TRUE(same_graph(mappedBig, big));
+  mappedBig.Close();
+
+  // Malformed lines and missing files fail.
+  {
+    std::ofstream f(text, std::ios::binary);
+    f << "0 1\n1 x\n";
+  }
+  ASSERT_FALSE(convert_edge_list(text, path, pool).has_value());
+  std::filesystem::remove(text);
+  ASSERT_FALSE(convert_edge_list(text, path, pool).has_value());
+  std::filesystem::remove(path);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(GraphFileBenchmark, DISABLED_Load) {
+  constexpr size_t NODES = 1 << 20;
+  constexpr size_t EDGES = NODES * 16;
+  using Clock = std::chrono::steady_clock;
+
+  auto text = std::filesystem::temp_directory_path() / "ds-graph-bench.txt";
+  auto path = std::filesystem::temp_directory_path() / "ds-graph-bench.bin";
+  {
+    std::ofstream f(text, std::ios::binary);
+    uint64_t x = 88172645463325252u;
+    for (size_t i = 0; i < EDGES; ++i) {
+      size_t src = next_random(x) % NODES;
+      f << src << ' ' << next_random(x) % NODES << ' ' << next_random(x) % 100 << '\n';
+    }
+  }
+
+  auto ms = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+
+  ThreadPool pool;
+  auto start = Clock::now();
+  AdjacencyListGraph<int, uint32_t> g;
+  ASSERT_EQ(g.LoadEdgeList(text), EDGES);
+  double parse = ms(start);
+
+  start = Clock::now();
+  ASSERT_EQ((convert_edge_list<int, uint32_t>(text, path, pool)), EDGES);
+  double convert = ms(start);
+
+  start = Clock::now();
+  MappedGraph<int, uint32_t> mapped;
+  ASSERT_TRUE(mapped.Open(path));
+  double open = ms(start);
+
+  start = Clock::now();
+  auto tree = mapped.DeltaStepping(0, pool);
+  double search = ms(start);
+
+  std::cout << NODES << " nodes, " << EDGES << " edges, " << std::filesystem::file_size(text) / (1 << 20)
+            << " MB of text, " << std::filesystem::file_size(path) / (1 << 20) << " MB binary, "
+            << pool.Size() << " threads" << std::endl;
+  std::cout << "LoadEdgeList: " << parse << " ms, convert_edge_list: " << convert << " ms, MappedGraph::Open: "
+            << open << " ms, then DeltaStepping over the mapping: " << search << " ms" << std::endl;
+
+  ASSERT_EQ(tree.distance_[0], 0);
+  mapped.Close();
+  std::filesystem::remove(text);
+  std::filesystem::remove(path);
+}
+
+} // namespace ds
@@ -3,11 +3,188 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+#include "../common.h"
 #include "../graph.h"
+#include "test-util.h"
 
 namespace ds {
 using namespace ::testing;
 
+namespace {
+
+// A random directed graph with a few hubs, so the BFS both grows its frontier
+// fast enough to go bottom-up and leaves a long tail to go top-down again.
+CSRGraph<int> random_graph(size_t nodes, size_t degree, uint64_t seed) {
+  ArrayList<GraphEdge> edges;
+  uint64_t x = seed;
+
+  for (size_t i = 0; i < nodes * degree; ++i) {
+    next_random(x);
+    size_t src = (x >> 8) % 10 == 0 ? x % 16 : i / degree;
+    edges.Append(GraphEdge(src, (x >> 20) % nodes));
+  }
+
+  return CSRGraph<int>(ArrayList<int>(nodes, 0), edges.begin(), edges.end());
+}
+
+// A side x side grid with two-way edges of random integer weight in [1, 10],
+// a stand-in for a road network. Node (x, y) is y * side + x.
+AdjacencyListGraph<int> grid_graph(size_t side, uint64_t seed) {
+  AdjacencyListGraph<int> g;
+  g.Reserve(side * side, 4 * side * side);
+  uint64_t x = seed;
+
+  auto weight = [&x]() {
+    return static_cast<double>(1 + next_random(x) % 10);
+  };
+
+  for (size_t i = 0; i < side * side; ++i) {
+    g.AddNode();
+  }
+  for (size_t r = 0; r < side; ++r) {
+    for (size_t c = 0; c < side; ++c) {
+      size_t n = r * side + c;
+      if (c + 1 < side) {
+        double w = weight();
+        g.AddEdge(n, n + 1, w);
+        g.AddEdge(n + 1, n, w);
+      }
+      if (r + 1 < side) {
+        double w = weight();
+        g.AddEdge(n, n + side, w);
+        g.AddEdge(n + side, n, w);
+      }
+    }
+  }
+
+  return g;
+}
+
+// Random directed edges among nodes, sparse enough to leave many
+// components of every size.
+ArrayList<GraphEdge> sparse_edges(size_t nodes, size_t edges, uint64_t seed) {
+  ArrayList<GraphEdge> list;
+  uint64_t x = seed;
+
+  for (size_t i = 0; i < edges; ++i) {
+    next_random(x);
+    list.Append(GraphEdge(x % nodes, (x >> 24) % nodes));
+  }
+
+  return list;
+}
+
+// Renumbers labels in order of first appearance, so two labelings of the
+// same partition compare equal.
+ArrayList<size_t> first_seen(const ArrayList<size_t>& labels) {
+  ArrayList<size_t> number(labels.Size(), labels.Size());
+  ArrayList<size_t> result;
+  size_t count = 0;
+
+  for (auto label : labels) {
+    if (number[label] == labels.Size()) {
+      number[label] = count++;
+    }
+    result.Append(number[label]);
+  }
+
+  return result;
+}
+
+// PageRank straight from its definition, one dense pass per iteration.
+ArrayList<double> reference_pagerank(size_t nodes, const ArrayList<GraphEdge>& edges,
+                                     const ArrayList<double>& teleport, size_t iterations) {
+  ArrayList<size_t> degree(nodes, 0);
+  for (auto& e : edges) {
+    ++degree[e.src_];
+  }
+
+  ArrayList<double> rank = teleport;
+  for (size_t i = 0; i < iterations; ++i) {
+    ArrayList<double> next(nodes, 0);
+    double stuck = 0;
+    for (size_t n = 0; n < nodes; ++n) {
+      stuck += degree[n] ? 0 : rank[n];
+    }
+    for (auto& e : edges) {
+      next[e.dest_] += rank[e.src_] / degree[e.src_];
+    }
+    for (size_t n = 0; n < nodes; ++n) {
+      next[n] = 0.15 * teleport[n] + 0.85 * (next[n] + stuck * teleport[n]);
+    }
+    rank = next;
+  }
+
+  return rank;
+}
+
+// Directed edges whose ends both follow a power law, as in web and social
+// graphs: node k in popularity order is picked with probability falling off
+// like k^(-2/3). Ids are scattered by an odd multiplier, so nodes must be a
+// power of two.
+ArrayList<GraphEdge> power_law_edges(size_t nodes, size_t edges, uint64_t seed) {
+  ArrayList<GraphEdge> list(edges);
+  uint64_t x = seed;
+
+  auto pick = [&]() {
+    next_random(x);
+    double u = static_cast<double>(x >> 11) / static_cast<double>(uint64_t(1) << 53);
+    size_t k = static_cast<size_t>(u * u * u * nodes);
+    return (k * 0x9E3779B1) & (nodes - 1);
+  };
+
+  for (size_t i = 0; i < edges; ++i) {
+    size_t src = pick();
+    list.Append(GraphEdge(src, pick()));
+  }
+
+  return list;
+}
+
+// The graph with node n renumbered id[n], edges listed in the same order.
+AdjacencyListGraph<int> renumbered(const AdjacencyListGraph<int>& g, const ArrayList<size_t>& id) {
+  AdjacencyListGraph<int> result;
+  for (size_t n = 0; n < g.NodeCount(); ++n) {
+    result.AddNode();
+  }
+  for (size_t n = 0; n < g.NodeCount(); ++n) {
+    g.ForEachEdge(n, [&](size_t dest, double weight) {
+      result.AddEdge(id[n], id[dest], weight);
+    });
+  }
+  return result;
+}
+
+// A random permutation of 0 to count - 1.
+ArrayList<size_t> shuffled(size_t count, uint64_t seed) {
+  ArrayList<size_t> id(count, 0);
+  std::iota(id.begin(), id.end(), size_t(0));
+  uint64_t x = seed;
+  for (size_t i = count - 1; i > 0; --i) {
+    std::swap(id[i], id[next_random(x) % (i + 1)]);
+  }
+  return id;
+}
+
+// Largest difference between the ids at the two ends of an edge.
+template <class Graph>
+size_t bandwidth(const Graph& g) {
+  size_t widest = 0;
+  for (size_t n = 0; n < g.NodeCount(); ++n) {
+    g.ForEachEdge(n, [&](size_t dest, double) {
+      widest = std::max(widest, abs_diff(n, dest));
+    });
+  }
+  return widest;
+}
+
+} // namespace
+
 TEST(GraphTest, Constructor) {
   AdjacencyListGraph<int> g(3, { 0, 10, 20 },
     { {0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 0, 1} }
@@ -70,4 +247,1142 @@ TEST(GraphTest, Dikstras) {
   }
 }
 
-} // namespace ds
\ No newline at end of file
+TEST(GraphTest, DikstrasQueues) {
+  AdjacencyListGraph<int> g(6, { 0, 0, 0, 0, 0, 0 }, {
+    {0, 1, 2}, {0, 2, 3}, {2, 4, 5}, {2, 3, 10}, {4, 3, 1 }, {1, 4, 7}
+  });
+
+  auto check = [](const std::pair<ArrayList<size_t>, double>& path) {
+    ASSERT_THAT(path.first, ElementsAreArray({ 0, 2, 4, 3 }));
+    EXPECT_NEAR(path.second, 9.0, 0.1);
+  };
+
+  check(g.Dikstras<IndexedHeap<double, MinHeap>>(0, 3));
+  check(g.Dikstras<PairingHeap<std::pair<double, size_t>>>(0, 3));
+  check(g.Dikstras<BinHeap<std::pair<double, size_t>, MinHeap, 4>>(0, 3));
+  check(g.Dikstras<RadixHeap<uint64_t, size_t>>(0, 3));
+}
+
+TEST(GraphTest, DikstrasContext) {
+  constexpr size_t SIDE = 30;
+  auto g = grid_graph(SIDE, 88172645463325252u);
+  CSRGraph<int> csr(g);
+  PathContext context;
+  ArrayList<size_t> path;
+
+  uint64_t x = 2463534242u;
+  for (int query = 0; query < 60; ++query) {
+    next_random(x);
+    size_t start = query == 0 ? 0 : x % (SIDE * SIDE);
+    size_t end = query == 0 ? 0 : (x >> 20) % (SIDE * SIDE);
+
+    auto expected = g.Dikstras(start, end);
+    ASSERT_EQ(g.Dikstras(start, end, context, path), expected.second);
+    ASSERT_TRUE(std::equal(path.begin(), path.end(), expected.first.begin(), expected.first.end()));
+    ASSERT_EQ(context.Distance(end), expected.second);
+    ASSERT_EQ(csr.Dikstras(start, end, context, path), expected.second);
+    ASSERT_EQ(path_length(g, path), expected.second);
+  }
+
+  // Once path has room for the longest route, it keeps its storage.
+  g.Dikstras(0, SIDE * SIDE - 1, context, path);
+  path.Reserve(2 * SIDE * SIDE);
+  auto storage = path.begin();
+  for (size_t end = 0; end < SIDE * SIDE; end += 7) {
+    g.Dikstras(SIDE * SIDE - 1, end, context, path);
+    ASSERT_EQ(path.begin(), storage);
+  }
+
+  // The same context on a smaller graph, with an unreachable node.
+  AdjacencyListGraph<int> small(4, { 0, 0, 0, 0 }, { {0, 1, 2}, {1, 2, 3} });
+  ASSERT_EQ(small.Dikstras(0, 2, context, path), 5);
+  ASSERT_THAT(path, ElementsAreArray<size_t>({ 0, 1, 2 }));
+  ASSERT_EQ(small.Dikstras(0, 3, context, path), std::numeric_limits<double>::max());
+  ASSERT_TRUE(path.isEmpty());
+  ASSERT_EQ(context.Distance(3), std::numeric_limits<double>::max());
+  ASSERT_EQ(context.Distance(2), 5);
+}
+
+TEST(GraphTest, DFSPrePost) {
+  AdjacencyListGraph<int> g(5, { 0, 10, 20, 30, 40 },
+    { {0, 1, 1}, {0, 3, 1}, {1, 2, 1}, {3, 2, 1}, {3, 4, 1} }
+  );
+  TraversalContext context;
+  ArrayListAppendFunctor<size_t> pre;
+  ArrayListAppendFunctor<size_t> post;
+
+  ASSERT_TRUE(g.DFS(0, context, pre, post));
+  ASSERT_THAT(pre.vec_, ElementsAreArray({ 0, 1, 2, 3, 4 }));
+  ASSERT_THAT(post.vec_, ElementsAreArray({ 2, 1, 4, 3, 0 }));
+
+  // Stop as soon as 3 is entered; prune below 1.
+  ArrayList<size_t> seen;
+  auto visit = [&seen](size_t node) {
+    seen.Append(node);
+    if (node == 1) return TraversalAction::Prune;
+    if (node == 3) return TraversalAction::Stop;
+    return TraversalAction::Continue;
+  };
+
+  ASSERT_FALSE(g.DFS(0, context, visit));
+  ASSERT_THAT(seen, ElementsAreArray({ 0, 1, 3 }));
+}
+
+TEST(GraphTest, DFSContextReuse) {
+  AdjacencyListGraph<int> g(5, { 0, 10, 20, 30, 40 },
+    { {0, 1, 1}, {2, 3, 1}, {3, 2, 1} }
+  );
+  TraversalContext context;
+
+  // Sweep the components without resetting between starts.
+  context.Reset(g.NodeCount());
+  size_t components = 0;
+  auto nothing = [](size_t) {};
+  for (size_t n = 0; n < g.NodeCount(); ++n) {
+    if (!context.isVisited(n)) {
+      g.DFSFrom(n, context, nothing);
+      ++components;
+    }
+  }
+  ASSERT_EQ(components, 3);
+
+  // DFS resets, so everything is reachable again.
+  ArrayListAppendFunctor<size_t> v;
+  g.DFS(2, context, v);
+  ASSERT_THAT(v.vec_, ElementsAreArray({ 2, 3 }));
+}
+
+TEST(GraphTest, DFSDeepPath) {
+  constexpr size_t NODES = 500000;
+  AdjacencyListGraph<int> g;
+  g.Reserve(NODES, NODES);
+
+  for (size_t i = 0; i < NODES; ++i) {
+    g.AddNode();
+    if (i > 0) {
+      g.AddEdge(i - 1, i);
+    }
+  }
+
+  size_t count = 0;
+  size_t last = 0;
+  auto visit = [&](size_t node) {
+    ++count;
+    last = node;
+  };
+  g.DFS(0, visit);
+
+  ASSERT_EQ(count, NODES);
+  ASSERT_EQ(last, NODES - 1);
+}
+
+TEST(GraphTest, CompactIndex) {
+  AdjacencyListGraph<int, uint32_t> g(6, { 0, 10, 20, 30, 40, 50 },
+    { {0, 1, 2}, {0, 2, 3}, {2, 4, 5}, {2, 3, 10}, {4, 3, 1}, {4, 5, 1} }
+  );
+
+  ArrayListAppendFunctor<size_t> v;
+  ASSERT_THAT(g.BFS(0, 5, v), ElementsAreArray({ 0, 2, 4, 5 }));
+
+  auto path = g.Dikstras(0, 3);
+  ASSERT_THAT(path.first, ElementsAreArray({ 0, 2, 4, 3 }));
+  EXPECT_NEAR(path.second, 9.0, 0.1);
+
+  CSRGraph<int, uint32_t> csr(g);
+  ASSERT_EQ(sizeof(csr.Targets().begin()[0]), sizeof(uint32_t));
+  ASSERT_THAT(csr.Dikstras(0, 3).first, ElementsAreArray({ 0, 2, 4, 3 }));
+  ASSERT_THAT(csr.ParallelBFS(0).distance_, ElementsAreArray<size_t>({ 0, 1, 1, 2, 2, 3 }));
+}
+
+TEST(GraphTest, PointToPointVariants) {
+  constexpr size_t SIDE = 30;
+  auto g = grid_graph(SIDE, 88172645463325252u);
+  auto reverse = g.Transpose();
+  CSRGraph<int> csr(g);
+  auto csrReverse = csr.Transpose();
+  ThreadPool pool(3);
+
+  auto manhattan = [](size_t end) {
+    return [end](size_t n) {
+      auto dx = static_cast<double>(abs_diff(n % SIDE, end % SIDE));
+      auto dy = static_cast<double>(abs_diff(n / SIDE, end / SIDE));
+      return dx + dy;  // every weight is at least 1
+    };
+  };
+
+  auto tree = g.DeltaStepping(0, pool, 3);
+  auto csrTree = csr.DeltaStepping(0, pool);
+
+  uint64_t x = 2463534242u;
+  for (int query = 0; query < 40; ++query) {
+    next_random(x);
+    size_t start = query == 0 ? 0 : x % (SIDE * SIDE);
+    size_t end = (x >> 20) % (SIDE * SIDE);
+
+    auto expected = g.Dikstras(start, end);
+
+    for (auto result : { g.BidirectionalDikstras(start, end, reverse),
+                         csr.BidirectionalDikstras(start, end, csrReverse),
+                         g.AStar(start, end, manhattan(end)),
+                         csr.AStar(start, end, manhattan(end)),
+                         g.DeltaStepping(start, end, pool) }) {
+      ASSERT_EQ(result.second, expected.second);
+      if (start != end) {
+        ASSERT_EQ(result.first[0], start);
+        ASSERT_EQ(result.first[result.first.Size() - 1], end);
+      }
+      ASSERT_EQ(path_length(g, result.first), start == end ? 0 : expected.second);
+    }
+
+    if (start == 0) {
+      ASSERT_EQ(tree.distance_[end], expected.second);
+      ASSERT_EQ(csrTree.distance_[end], expected.second);
+      ASSERT_EQ(path_length(g, tree.PathTo(end).first), end == 0 ? 0 : expected.second);
+    }
+  }
+}
+
+TEST(GraphTest, PointToPointUnreachable) {
+  AdjacencyListGraph<int> g(4, { 0, 10, 20, 30 },
+    { {0, 1, 1}, {1, 2, 1}, {3, 2, 1} }
+  );
+  ThreadPool pool(2);
+  constexpr double INF = std::numeric_limits<double>::max();
+
+  auto bidirectional = g.BidirectionalDikstras(0, 3, g.Transpose());
+  ASSERT_TRUE(bidirectional.first.isEmpty());
+  ASSERT_EQ(bidirectional.second, INF);
+
+  auto delta = g.DeltaStepping(0, 3, pool);
+  ASSERT_TRUE(delta.first.isEmpty());
+  ASSERT_EQ(delta.second, INF);
+
+  auto tree = g.DeltaStepping(0, pool);
+  ASSERT_THAT(tree.distance_, ElementsAreArray({ 0.0, 1.0, 2.0, INF }));
+  ASSERT_THAT(tree.parent_, ElementsAreArray<size_t>({ 0, 0, 1, ShortestPathTree::UNREACHED }));
+  ASSERT_TRUE(tree.PathTo(0).first.isEmpty());
+}
+
+TEST(GraphTest, DeltaSteppingSparseBuckets) {
+  // A long chain of heavy steps leaves a thousand empty buckets between
+  // each pair of settled ones, and one much heavier edge would need
+  // billions of buckets at this delta.
+  constexpr size_t NODES = 500;
+  AdjacencyListGraph<int> g;
+  for (size_t n = 0; n <= NODES; ++n) {
+    g.AddNode();
+  }
+  for (size_t n = 0; n + 1 < NODES; ++n) {
+    g.AddEdge(n, n + 1, 1000);
+  }
+  g.AddEdge(0, NODES, 1e9);
+
+  ThreadPool pool(2);
+  auto tree = g.DeltaStepping(0, pool, 1);
+  for (size_t n = 0; n <= NODES; ++n) {
+    ASSERT_EQ(tree.distance_[n], n == NODES ? 1e9 : 1000.0 * n);
+  }
+
+  auto path = g.DeltaStepping(0, NODES - 1, pool);
+  ASSERT_EQ(path.first.Size(), NODES);
+  ASSERT_EQ(path.second, 1000.0 * (NODES - 1));
+}
+
+TEST(GraphTest, PathToOutOfRange) {
+  ShortestPathTree tree{ ArrayList<double>{ 0.0, 1.0 }, ArrayList<size_t>{ 0, 0 } };
+  ASSERT_THAT(tree.PathTo(1).first, ElementsAreArray<size_t>({ 0, 1 }));
+  ASSERT_DEATH({ tree.PathTo(2); }, "out of bounds");
+}
+
+TEST(GraphTest, AddNodesAndEdges) {
+  AdjacencyListGraph<int> g;
+  g.Reserve(4, 8);
+
+  ASSERT_EQ(g.AddNode(10), 0);
+  ASSERT_EQ(g.AddNode(20), 1);
+  ASSERT_EQ(g.AddNode(30), 2);
+  g.AddEdge(0, 1, 2);
+  g.AddEdges({ {1, 2, 1}, {0, 2, 5} });
+
+  ASSERT_EQ(g.NodeCount(), 3);
+  ASSERT_EQ(g.EdgeCount(), 3);
+  ASSERT_EQ(g.Value(1), 20);
+  ASSERT_EQ(g.Degree(0), 2);
+
+  auto path = g.Dikstras(0, 2);
+  ASSERT_THAT(path.first, ElementsAreArray({ 0, 1, 2 }));
+  EXPECT_NEAR(path.second, 3.0, 0.1);
+
+  ASSERT_TRUE(g.RemoveEdge(1, 2));
+  ASSERT_FALSE(g.RemoveEdge(1, 2));
+  ASSERT_EQ(g.EdgeCount(), 2);
+
+  path = g.Dikstras(0, 2);
+  ASSERT_THAT(path.first, ElementsAreArray({ 0, 2 }));
+  EXPECT_NEAR(path.second, 5.0, 0.1);
+}
+
+TEST(GraphTest, RemoveNode) {
+  AdjacencyListGraph<int> g(4, { 0, 10, 20, 30 },
+    { {0, 1, 1}, {1, 2, 1}, {2, 3, 1}, {3, 0, 1}, {3, 1, 1}, {0, 3, 1} }
+  );
+
+  // Node 3 moves into index 1.
+  g.RemoveNode(1);
+
+  ASSERT_EQ(g.NodeCount(), 3);
+  ASSERT_EQ(g.EdgeCount(), 3);
+  ASSERT_EQ(g.Value(1), 30);
+
+  ArrayListAppendFunctor<size_t> v;
+  g.DFS(2, v);
+  ASSERT_THAT(v.vec_, ElementsAreArray({ 2, 1, 0 }));
+  ASSERT_EQ(g.Degree(0), 1);
+}
+
+TEST(GraphTest, LoadEdgeList) {
+  auto path = std::filesystem::temp_directory_path() / "ds-graph-edges.txt";
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "# comment\n0 1\n1\t2 2.5\r\n\n0 3 4\n3 2";
+  }
+
+  AdjacencyListGraph<int> g;
+  auto added = g.LoadEdgeList(path);
+  std::filesystem::remove(path);
+
+  ASSERT_TRUE(added.has_value());
+  ASSERT_EQ(*added, 4);
+  ASSERT_EQ(g.NodeCount(), 4);
+  ASSERT_EQ(g.EdgeCount(), 4);
+
+  auto shortest = g.Dikstras(0, 2);
+  ASSERT_THAT(shortest.first, ElementsAreArray({ 0, 1, 2 }));
+  EXPECT_NEAR(shortest.second, 3.5, 0.01);
+
+  ASSERT_FALSE(g.LoadEdgeList(path).has_value());
+}
+
+TEST(GraphTest, LoadMatrixMarket) {
+  auto path = std::filesystem::temp_directory_path() / "ds-graph-edges.mtx";
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "%%MatrixMarket matrix coordinate pattern symmetric\n"
+         "%-------------------------------------------------------------------------------\n"
+         "% UF Sparse Matrix Collection, Tim Davis\n"
+         "%-------------------------------------------------------------------------------\n"
+         "6 6 4\n"
+         "2 1\n"
+         "3 2\n"
+         "5 3\n"
+         "4 4\n";
+  }
+
+  // The size line adds node 6 though no entry names it, and each
+  // off-diagonal entry goes both ways.
+  AdjacencyListGraph<int> g;
+  ASSERT_EQ(g.LoadEdgeList(path), 7);
+  ASSERT_EQ(g.NodeCount(), 6);
+  ASSERT_THAT(g.Dikstras(0, 4).first, ElementsAreArray({ 0, 1, 2, 4 }));
+  ASSERT_THAT(g.Dikstras(4, 0).first, ElementsAreArray({ 4, 2, 1, 0 }));
+  ASSERT_EQ(g.Dikstras(3, 0).second, std::numeric_limits<double>::max());
+
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "%%MatrixMarket matrix coordinate real general\r\n"
+         "3 4 2\r\n"
+         "1 2 0.5\r\n"
+         "3 4 2.0\r\n";
+  }
+  AdjacencyListGraph<int> general;
+  ASSERT_EQ(general.LoadEdgeList(path), 2);
+  ASSERT_EQ(general.NodeCount(), 4);
+  ASSERT_EQ(general.Dikstras(0, 1).second, 0.5);
+  ASSERT_EQ(general.Dikstras(2, 3).second, 2.0);
+
+  // Ids are 1-based, and dense array files are not edge lists.
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "%%MatrixMarket matrix coordinate real general\n2 2 1\n0 1 1\n";
+  }
+  ASSERT_FALSE(AdjacencyListGraph<int>().LoadEdgeList(path).has_value());
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << "%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n";
+  }
+  ASSERT_FALSE(AdjacencyListGraph<int>().LoadEdgeList(path).has_value());
+  std::filesystem::remove(path);
+}
+
+TEST(CSRGraphTest, FromEdgeList) {
+  CSRGraph<int> g({ 0, 10, 20, 30 },
+    { {0, 1, 1}, {2, 1, 4}, {0, 3, 2}, {3, 2, 1}, {1, 3, 1} }
+  );
+
+  ASSERT_EQ(g.NodeCount(), 4);
+  ASSERT_EQ(g.EdgeCount(), 5);
+  ASSERT_EQ(g.Value(2), 20);
+  ASSERT_EQ(g.Degree(0), 2);
+  ASSERT_EQ(g.Degree(1), 1);
+  ASSERT_THAT(g.Offsets(), ElementsAreArray({ 0, 2, 3, 4, 5 }));
+  ASSERT_THAT(g.Targets(), ElementsAreArray({ 1, 3, 3, 1, 2 }));
+  ASSERT_THAT(g.Weights(), ElementsAreArray({ 1.0, 2.0, 1.0, 4.0, 1.0 }));
+}
+
+TEST(CSRGraphTest, FromAdjacencyList) {
+  AdjacencyListGraph<int> a(4, { 0, 10, 20, 30 },
+    { {0, 1, 1}, {0, 3, 1}, {3, 2, 1}, {2, 1, 1}, {1, 3, 1}
+  });
+  CSRGraph<int> g(a);
+
+  ASSERT_EQ(g.NodeCount(), a.NodeCount());
+  ASSERT_EQ(g.EdgeCount(), a.EdgeCount());
+  ASSERT_EQ(g.Value(3), 30);
+
+  ArrayListAppendFunctor<size_t> v;
+  g.DFS(0, v);
+  ASSERT_THAT(v.vec_, ElementsAreArray({ 0, 1, 3, 2 }));
+
+  TraversalContext context;
+  ArrayListAppendFunctor<size_t> pre;
+  ArrayListAppendFunctor<size_t> post;
+  ASSERT_TRUE(g.DFS(0, context, pre, post));
+  ASSERT_THAT(pre.vec_, ElementsAreArray({ 0, 1, 3, 2 }));
+  ASSERT_THAT(post.vec_, ElementsAreArray({ 2, 3, 1, 0 }));
+}
+
+TEST(CSRGraphTest, BFS) {
+  CSRGraph<int> g({ 0, 10, 20, 30, 40, 50 },
+    { {0, 1, 1}, {0, 2, 1}, {2, 4, 1}, {4, 5, 1}, {4, 3, 1} }
+  );
+  ArrayListAppendFunctor<size_t> v;
+
+  auto path = g.BFS(0, 5, v);
+  ASSERT_THAT(v.vec_, ElementsAreArray({ 0, 1, 2, 4, 5 }));
+  ASSERT_THAT(path, ElementsAreArray({ 0, 2, 4, 5 }));
+
+  ArrayListAppendFunctor<size_t> none;
+  ASSERT_TRUE(g.BFS(3, 0, none).isEmpty());
+  ASSERT_THAT(none.vec_, ElementsAreArray({ 3 }));
+}
+
+TEST(CSRGraphTest, Dikstras) {
+  CSRGraph<int> g({ 0, 0, 0, 0, 0, 0 },
+    { {0, 1, 2}, {0, 2, 3}, {2, 4, 5}, {2, 3, 10}, {4, 3, 1} }
+  );
+
+  auto path = g.Dikstras(0, 3);
+  ASSERT_THAT(path.first, ElementsAreArray({ 0, 2, 4, 3 }));
+  EXPECT_NEAR(path.second, 9.0, 0.1);
+
+  auto radix = g.Dikstras<RadixHeap<uint64_t, size_t>>(0, 3);
+  ASSERT_THAT(radix.first, ElementsAreArray({ 0, 2, 4, 3 }));
+
+  EXPECT_TRUE(g.Dikstras(0, 5).first.isEmpty());
+}
+
+TEST(CSRGraphTest, ParallelBFS) {
+  auto g = random_graph(20000, 4, 88172645463325252u);
+  auto transpose = g.Transpose();
+  ASSERT_EQ(transpose.EdgeCount(), g.EdgeCount());
+
+  // Serial reference distances.
+  ArrayList<size_t> expected(g.NodeCount(), BFSResult::UNREACHED);
+  ArrayList<size_t> queue;
+  expected[0] = 0;
+  queue.Append(0);
+  for (size_t head = 0; head < queue.Size(); ++head) {
+    size_t u = queue[head];
+    g.ForEachEdge(u, [&](size_t v, double) {
+      if (expected[v] == BFSResult::UNREACHED) {
+        expected[v] = expected[u] + 1;
+        queue.Append(v);
+      }
+    });
+  }
+
+  for (size_t threads : { 1, 4 }) {
+    ThreadPool pool(threads);
+    auto result = g.ParallelBFS(0, transpose, pool);
+
+    ASSERT_THAT(result.distance_, ElementsAreArray(expected.begin(), expected.end()));
+    ASSERT_EQ(result.parent_[0], 0);
+
+    for (size_t v = 1; v < g.NodeCount(); ++v) {
+      if (expected[v] == BFSResult::UNREACHED) {
+        ASSERT_EQ(result.parent_[v], BFSResult::UNREACHED);
+        continue;
+      }
+
+      size_t u = result.parent_[v];
+      ASSERT_EQ(expected[u] + 1, expected[v]);
+
+      bool edge = false;
+      g.ForEachEdge(u, [&](size_t dest, double) { edge = edge || dest == v; });
+      ASSERT_TRUE(edge);
+    }
+  }
+}
+
+TEST(CSRGraphTest, ParallelBFSOneOff) {
+  CSRGraph<int> g({ 0, 10, 20, 30, 40, 50 },
+    { {0, 1, 1}, {0, 2, 1}, {2, 4, 1}, {4, 5, 1}, {4, 3, 1} }
+  );
+
+  constexpr size_t NONE = BFSResult::UNREACHED;
+
+  auto result = g.ParallelBFS(2);
+  ASSERT_THAT(result.distance_, ElementsAreArray<size_t>({ NONE, NONE, 0, 2, 1, 2 }));
+  ASSERT_THAT(result.parent_, ElementsAreArray<size_t>({ NONE, NONE, 2, 4, 2, 4 }));
+}
+
+TEST(GraphTest, ConnectedComponents) {
+  AdjacencyListGraph<int> g(7, { 0, 1, 2, 3, 4, 5, 6 },
+    { {1, 0, 1}, {2, 1, 1}, {3, 4, 1}, {6, 4, 1} }
+  );
+  ThreadPool pool(3);
+
+  auto cc = g.ConnectedComponents(pool);
+  ASSERT_EQ(cc.count_, 3);
+  ASSERT_THAT(cc.label_, ElementsAreArray<size_t>({ 0, 0, 0, 1, 1, 2, 1 }));
+
+  // Against Tarjan on the same edges made two-way.
+  constexpr size_t NODES = 20000;
+  auto edges = sparse_edges(NODES, NODES * 6 / 10, 88172645463325252u);
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  AdjacencyListGraph<int> both;
+  for (size_t n = 0; n < NODES; ++n) {
+    both.AddNode();
+  }
+  for (auto& e : edges) {
+    both.AddEdge(e.src_, e.dest_);
+    both.AddEdge(e.dest_, e.src_);
+  }
+
+  auto expected = both.StronglyConnectedComponents();
+  auto actual = csr.ConnectedComponents(pool);
+  ASSERT_EQ(actual.count_, expected.count_);
+  ASSERT_TRUE(actual.label_.isEqual(first_seen(expected.label_)));
+}
+
+TEST(GraphTest, StronglyConnectedComponents) {
+  // 0 -> 1 -> 2 -> 0 and 3 <-> 4, joined by 2 -> 3, with 5 on its own.
+  AdjacencyListGraph<int> g(6, { 0, 1, 2, 3, 4, 5 },
+    { {0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {2, 3, 1}, {3, 4, 1}, {4, 3, 1}, {5, 5, 1} }
+  );
+  ThreadPool pool(2);
+
+  auto tarjan = g.StronglyConnectedComponents();
+  ASSERT_EQ(tarjan.count_, 3);
+  ASSERT_THAT(tarjan.label_, ElementsAreArray<size_t>({ 1, 1, 1, 0, 0, 2 }));
+
+  auto parallel = g.StronglyConnectedComponents(g.Transpose(), pool);
+  ASSERT_EQ(parallel.count_, 3);
+  ASSERT_THAT(parallel.label_, ElementsAreArray<size_t>({ 0, 0, 0, 1, 1, 2 }));
+
+  // A giant component, a long tail of small ones, and chains the trimming
+  // does not finish off.
+  constexpr size_t NODES = 20000;
+  auto edges = sparse_edges(NODES, NODES * 12 / 10, 2463534242u);
+  for (size_t n = 0; n + 1 < 50; ++n) {
+    edges.Append(GraphEdge(NODES - 50 + n, NODES - 49 + n));
+  }
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  auto transpose = csr.Transpose();
+
+  auto expected = csr.StronglyConnectedComponents();
+  for (size_t n = 0; n < NODES; ++n) {
+    csr.ForEachEdge(n, [&](size_t dest, double) {
+      ASSERT_GE(expected.label_[n], expected.label_[dest]);
+    });
+  }
+
+  for (size_t threads : { 1, 4 }) {
+    ThreadPool workers(threads);
+    auto actual = csr.StronglyConnectedComponents(transpose, workers);
+    ASSERT_EQ(actual.count_, expected.count_);
+    ASSERT_TRUE(actual.label_.isEqual(first_seen(expected.label_)));
+  }
+}
+
+TEST(GraphTest, TopologicalSort) {
+  AdjacencyListGraph<int> g(5, { 0, 1, 2, 3, 4 },
+    { {3, 1, 1}, {1, 0, 1}, {3, 0, 1}, {4, 2, 1} }
+  );
+
+  auto order = g.TopologicalSort();
+  ASSERT_TRUE(order.has_value());
+  ASSERT_THAT(*order, ElementsAreArray<size_t>({ 3, 4, 1, 2, 0 }));
+
+  g.AddEdge(0, 3);
+  ASSERT_FALSE(g.TopologicalSort().has_value());
+
+  // Edges only run from lower to higher scrambled ids, so the graph is a DAG.
+  constexpr size_t NODES = 20000;
+  auto id = shuffled(NODES, 88172645463325252u);
+
+  ArrayList<GraphEdge> edges;
+  for (auto& e : sparse_edges(NODES, NODES * 3, 2463534242u)) {
+    if (e.src_ < e.dest_) {
+      edges.Append(GraphEdge(id[e.src_], id[e.dest_]));
+    }
+  }
+  CSRGraph<int> dag(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+
+  for (size_t threads : { 1, 4 }) {
+    ThreadPool pool(threads);
+    auto sorted = dag.TopologicalSort(pool);
+    ASSERT_TRUE(sorted.has_value());
+    ASSERT_EQ(sorted->Size(), NODES);
+
+    ArrayList<size_t> position(NODES, NODES);
+    for (size_t i = 0; i < NODES; ++i) {
+      position[(*sorted)[i]] = i;
+    }
+    for (auto& e : edges) {
+      ASSERT_LT(position[e.src_], position[e.dest_]);
+    }
+  }
+
+  edges.Append(GraphEdge(id[NODES - 1], id[0]));
+  edges.Append(GraphEdge(id[0], id[NODES - 1]));
+  CSRGraph<int> cyclic(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  ThreadPool pool(4);
+  ASSERT_FALSE(cyclic.TopologicalSort(pool).has_value());
+}
+
+TEST(GraphTest, MinimumSpanningForest) {
+  // Two trees, 0-1-2-3 and 4-5, with 6 on its own.
+  AdjacencyListGraph<int> g(7, { 0, 1, 2, 3, 4, 5, 6 },
+    { {0, 1, 4}, {1, 2, 1}, {0, 2, 2}, {2, 3, 7}, {3, 1, 5}, {4, 5, 3}, {5, 4, 1}, {6, 6, 1} }
+  );
+  ThreadPool pool(2);
+
+  auto kruskal = g.KruskalMST();
+  ASSERT_EQ(kruskal.weight_, 9);
+  ASSERT_EQ(kruskal.edges_.Size(), 4);
+
+  auto boruvka = g.BoruvkaMST(pool);
+  ASSERT_EQ(boruvka.weight_, 9);
+  ASSERT_EQ(boruvka.edges_.Size(), 4);
+
+  // Whether two forests hold the same edges, in any order.
+  auto same = [](ArrayList<GraphEdge> a, ArrayList<GraphEdge> b) {
+    auto key = [](const GraphEdge& e) { return std::make_tuple(e.src_, e.dest_, e.weight_); };
+    auto less = [&key](const GraphEdge& l, const GraphEdge& r) { return key(l) < key(r); };
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+      [&key](const GraphEdge& l, const GraphEdge& r) { return key(l) == key(r); });
+  };
+
+  // A grid with many equal weights, and a forest of many components.
+  auto grid = grid_graph(60, 88172645463325252u);
+  auto expected = grid.KruskalMST();
+  ASSERT_EQ(expected.edges_.Size(), 60 * 60 - 1);
+
+  constexpr size_t NODES = 20000;
+  ArrayList<GraphEdge> edges;
+  uint64_t x = 2463534242u;
+  for (auto& e : sparse_edges(NODES, NODES * 8 / 10, 11400714819323198485u)) {
+    edges.Append(GraphEdge(e.src_, e.dest_, static_cast<double>(next_random(x) % 100)));
+  }
+  CSRGraph<int> sparse(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  auto sparseExpected = sparse.KruskalMST();
+  ASSERT_EQ(sparseExpected.edges_.Size(), NODES - sparse.ConnectedComponents(pool).count_);
+
+  for (size_t threads : { 1, 4 }) {
+    ThreadPool workers(threads);
+
+    auto actual = grid.BoruvkaMST(workers);
+    ASSERT_EQ(actual.weight_, expected.weight_);
+    ASSERT_TRUE(same(actual.edges_, expected.edges_));
+
+    actual = sparse.BoruvkaMST(workers);
+    ASSERT_EQ(actual.weight_, sparseExpected.weight_);
+    ASSERT_TRUE(same(actual.edges_, sparseExpected.edges_));
+  }
+}
+
+TEST(GraphTest, PageRank) {
+  // A three-cycle shares rank evenly.
+  AdjacencyListGraph<int> cycle(3, { 0, 1, 2 }, { {0, 1, 1}, {1, 2, 1}, {2, 0, 1} });
+  ThreadPool pool(2);
+  auto even = cycle.PageRank(cycle.Transpose(), pool);
+  ASSERT_LT(even.iterations_, 100);
+  for (auto r : even.rank_) {
+    ASSERT_NEAR(r, 1.0 / 3, 1e-12);
+  }
+
+  // A graph with dangling nodes, against the definition.
+  constexpr size_t NODES = 20000;
+  auto edges = sparse_edges(NODES, NODES * 3, 88172645463325252u);
+  auto expected = reference_pagerank(NODES, edges, ArrayList<double>(NODES, 1.0 / NODES), 60);
+
+  AdjacencyListGraph<int, uint32_t> g;
+  for (size_t n = 0; n < NODES; ++n) {
+    g.AddNode();
+  }
+  g.AddEdges(edges.begin(), edges.end());
+  auto transpose = g.Transpose();
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  auto csrTranspose = csr.Transpose();
+
+  for (size_t threads : { 1, 4 }) {
+    ThreadPool workers(threads);
+    RankResult results[] = {
+      g.PageRank(transpose, workers, 0.85, 0, 60),
+      g.PageRank(workers, 0.85, 0, 60),
+      csr.PageRank(csrTranspose, workers, 0.85, 0, 60),
+      csr.PageRank(workers, 0.85, 0, 60)
+    };
+
+    for (auto& result : results) {
+      ASSERT_EQ(result.iterations_, 60);
+      ASSERT_NEAR(std::accumulate(result.rank_.begin(), result.rank_.end(), 0.0), 1, 1e-9);
+      for (size_t n = 0; n < NODES; ++n) {
+        ASSERT_NEAR(result.rank_[n], expected[n], 1e-12);
+      }
+    }
+  }
+
+  auto converged = csr.PageRank(pool);
+  ASSERT_LT(converged.delta_, 1e-6);
+  ASSERT_LT(converged.iterations_, 100);
+}
+
+TEST(GraphTest, PersonalizedPageRank) {
+  // 3 and 4 cannot be reached from the seeds.
+  AdjacencyListGraph<int> g(5, { 0, 1, 2, 3, 4 },
+    { {0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {3, 0, 1}, {4, 3, 1} }
+  );
+  ThreadPool pool(2);
+
+  auto result = g.PersonalizedPageRank({ 0 }, g.Transpose(), pool);
+  ASSERT_GT(result.rank_[0], result.rank_[1]);
+  ASSERT_GT(result.rank_[1], result.rank_[2]);
+  ASSERT_EQ(result.rank_[3], 0);
+  ASSERT_EQ(result.rank_[4], 0);
+
+  constexpr size_t NODES = 5000;
+  auto edges = sparse_edges(NODES, NODES * 4, 2463534242u);
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  ArrayList<size_t> seeds{ 17, 4000, 17 };
+  ArrayList<double> teleport(NODES, 0);
+  teleport[17] = 2.0 / 3;
+  teleport[4000] = 1.0 / 3;
+
+  auto expected = reference_pagerank(NODES, edges, teleport, 50);
+  auto actual = csr.PersonalizedPageRank(seeds, csr.Transpose(), pool, 0.85, 0, 50);
+  for (size_t n = 0; n < NODES; ++n) {
+    ASSERT_NEAR(actual.rank_[n], expected[n], 1e-12);
+  }
+}
+
+TEST(GraphTest, LabelPropagation) {
+  // Two five-cliques joined by one edge, and a node on its own.
+  AdjacencyListGraph<int> g;
+  for (size_t n = 0; n < 11; ++n) {
+    g.AddNode();
+  }
+  for (size_t base : { 0, 5 }) {
+    for (size_t a = base; a < base + 5; ++a) {
+      for (size_t b = a + 1; b < base + 5; ++b) {
+        g.AddEdge(a, b);
+      }
+    }
+  }
+  g.AddEdge(4, 5);
+  auto transpose = g.Transpose();
+
+  for (size_t threads : { 1, 3 }) {
+    ThreadPool pool(threads);
+    auto communities = g.LabelPropagation(transpose, pool);
+    ASSERT_EQ(communities.count_, 3);
+    ASSERT_THAT(communities.label_, ElementsAreArray<size_t>({ 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2 }));
+  }
+
+  // Communities never span two connected components.
+  constexpr size_t NODES = 20000;
+  auto edges = sparse_edges(NODES, NODES, 11400714819323198485u);
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  ThreadPool pool(4);
+  auto components = csr.ConnectedComponents(pool);
+  auto communities = csr.LabelPropagation(csr.Transpose(), pool);
+  ASSERT_GE(communities.count_, components.count_);
+
+  ArrayList<size_t> component(communities.count_, NODES);
+  for (size_t n = 0; n < NODES; ++n) {
+    size_t& c = component[communities.label_[n]];
+    if (c == NODES) {
+      c = components.label_[n];
+    }
+    ASSERT_EQ(c, components.label_[n]);
+  }
+}
+
+TEST(GraphTest, Reorder) {
+  constexpr size_t SIDE = 30;
+  auto grid = renumbered(grid_graph(SIDE, 88172645463325252u), shuffled(SIDE * SIDE, 2463534242u));
+  ASSERT_GT(bandwidth(grid), SIDE * SIDE / 2);
+
+  auto isPermutation = [](ArrayList<size_t> permutation) {
+    std::sort(permutation.begin(), permutation.end());
+    for (size_t i = 0; i < permutation.Size(); ++i) {
+      if (permutation[i] != i) return false;
+    }
+    return true;
+  };
+
+  auto rcm = grid.ReverseCuthillMcKeeOrder();
+  ASSERT_TRUE(isPermutation(rcm));
+  auto relabelled = grid.Relabel(rcm);
+  ASSERT_LE(bandwidth(relabelled), 2 * SIDE);
+
+  // Relabel keeps values, edges and weights.
+  AdjacencyListGraph<int> g(4, { 10, 11, 12, 13 }, { {0, 1, 5}, {1, 2, 6}, {3, 0, 7} });
+  auto moved = g.Relabel({ 2, 0, 3, 1 });
+  ASSERT_THAT(ArrayList<int>({ moved.Value(0), moved.Value(1), moved.Value(2), moved.Value(3) }),
+              ElementsAreArray({ 11, 13, 10, 12 }));
+  ASSERT_EQ(moved.Dikstras(1, 3).second, 18);
+  ASSERT_EQ(moved.EdgeCount(), 3);
+
+  auto degree = grid.DegreeOrder();
+  ASSERT_TRUE(isPermutation(degree));
+  auto byDegree = grid.Relabel(degree);
+  for (size_t n = 1; n < byDegree.NodeCount(); ++n) {
+    ASSERT_GE(byDegree.Degree(n - 1), byDegree.Degree(n));
+  }
+
+  // Two scrambled cliques: Gorder numbers each in one run.
+  AdjacencyListGraph<int> cliques;
+  auto id = shuffled(12, 11400714819323198485u);
+  for (size_t n = 0; n < 12; ++n) {
+    cliques.AddNode();
+  }
+  for (size_t a = 0; a < 12; ++a) {
+    for (size_t b = 0; b < 12; ++b) {
+      if (a != b && a / 6 == b / 6) {
+        cliques.AddEdge(id[a], id[b]);
+      }
+    }
+  }
+
+  auto gorder = cliques.GorderOrder();
+  ASSERT_TRUE(isPermutation(gorder));
+  for (size_t a = 0; a < 12; ++a) {
+    ASSERT_EQ(gorder[id[a]] / 6, gorder[id[a - a % 6]] / 6);
+  }
+
+  CSRGraph<int> csr(grid);
+  ASSERT_TRUE(csr.GorderOrder().isEqual(grid.GorderOrder()));
+  ASSERT_TRUE(csr.ReverseCuthillMcKeeOrder().isEqual(rcm));
+  ASSERT_EQ(bandwidth(csr.Relabel(rcm)), bandwidth(relabelled));
+}
+
+TEST(GraphTest, RelabelWrongSize) {
+  AdjacencyListGraph<int> g(3, { 10, 11, 12 }, { {0, 1, 5}, {1, 2, 6} });
+  CSRGraph<int> csr(g);
+  ASSERT_DEATH({ g.Relabel({ 1, 0 }); }, "out of bounds");
+  ASSERT_DEATH({ g.Relabel({ 1, 0, 2, 3 }); }, "out of bounds");
+  ASSERT_DEATH({ csr.Relabel({ 1, 0 }); }, "out of bounds");
+}
+
+TEST(GraphTest, Partition) {
+  constexpr size_t SIDE = 40;
+  auto grid = renumbered(grid_graph(SIDE, 88172645463325252u), shuffled(SIDE * SIDE, 2463534242u));
+
+  for (size_t parts : { 1, 2, 4, 7 }) {
+    auto partition = grid.Partition(parts);
+    ASSERT_EQ(partition.parts_, parts);
+
+    ArrayList<size_t> size(parts, 0);
+    for (auto part : partition.part_) {
+      ASSERT_LT(part, parts);
+      ++size[part];
+    }
+    for (auto s : size) {
+      ASSERT_GT(s, 0);
+      ASSERT_LE(s, std::ceil(SIDE * SIDE / parts * 1.03) + 1);
+    }
+
+    size_t cut = 0;
+    for (size_t n = 0; n < grid.NodeCount(); ++n) {
+      grid.ForEachEdge(n, [&](size_t dest, double) { cut += partition.part_[n] != partition.part_[dest]; });
+    }
+    ASSERT_EQ(partition.cut_, cut);
+
+    // A random split would cut most edges.
+    ASSERT_LT(cut * 8, grid.EdgeCount());
+  }
+
+  ASSERT_EQ(grid.Partition(1).cut_, 0);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(GraphBenchmark, DISABLED_CSRvsAdjacencyList) {
+  constexpr size_t NODES = 1 << 18;
+  constexpr size_t DEGREE = 16;
+
+  ArrayList<GraphEdge> edges;
+  uint64_t x = 88172645463325252u;
+  for (size_t i = 0; i < NODES * DEGREE; ++i) {
+    next_random(x);
+    edges.Append(GraphEdge(i / DEGREE, x % NODES, 1.0 + (x >> 40) % 100));
+  }
+
+  AdjacencyListGraph<int> adjacency;
+  adjacency.Reserve(NODES, NODES * DEGREE);
+  for (size_t i = 0; i < NODES; ++i) {
+    adjacency.AddNode();
+  }
+  adjacency.AddEdges(edges.begin(), edges.end());
+
+  CSRGraph<int> csr(adjacency);
+
+  auto time = [](auto&& f) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = f();
+    std::cout << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms";
+    return result;
+  };
+
+  std::cout << "Dikstras over " << NODES * DEGREE << " edges: adjacency list ";
+  auto a = time([&]() { return adjacency.Dikstras(0, NODES - 1).second; });
+  std::cout << ", CSR ";
+  auto c = time([&]() { return csr.Dikstras(0, NODES - 1).second; });
+  std::cout << std::endl;
+
+  ASSERT_EQ(a, c);
+}
+
+TEST(GraphBenchmark, DISABLED_ParallelBFS) {
+  auto g = random_graph(1 << 21, 16, 88172645463325252u);
+  auto transpose = g.Transpose();
+
+  for (size_t threads = 1; threads <= std::thread::hardware_concurrency(); threads *= 2) {
+    ThreadPool pool(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = g.ParallelBFS(0, transpose, pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << threads << " threads: " << seconds * 1000 << " ms, "
+              << g.EdgeCount() / seconds / 1e6 << " MTEPS" << std::endl;
+    ASSERT_EQ(result.distance_[0], 0);
+  }
+}
+
+TEST(GraphBenchmark, DISABLED_PointToPoint) {
+  constexpr size_t SIDE = 700;
+  constexpr size_t QUERIES = 100;
+  auto g = grid_graph(SIDE, 88172645463325252u);
+  auto reverse = g.Transpose();
+  ThreadPool pool;
+
+  ArrayList<std::pair<size_t, size_t>> queries;
+  uint64_t x = 2463534242u;
+  for (size_t i = 0; i < QUERIES; ++i) {
+    next_random(x);
+    queries.Append(std::make_pair(x % (SIDE * SIDE), (x >> 24) % (SIDE * SIDE)));
+  }
+
+  auto run = [&](const char* name, auto&& query) {
+    double total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& q : queries) {
+      total += query(q.first, q.second).second;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << ms / QUERIES << " ms/query" << std::endl;
+    return total;
+  };
+
+  auto a = run("Dikstras", [&](size_t s, size_t t) { return g.Dikstras(s, t); });
+  auto b = run("BidirectionalDikstras", [&](size_t s, size_t t) { return g.BidirectionalDikstras(s, t, reverse); });
+  auto c = run("AStar", [&](size_t s, size_t t) {
+    return g.AStar(s, t, [t](size_t n) {
+      return static_cast<double>(abs_diff(n % SIDE, t % SIDE) + abs_diff(n / SIDE, t / SIDE));
+    });
+  });
+
+  PathContext context;
+  ArrayList<size_t> path;
+  auto d = run("Dikstras, reused PathContext", [&](size_t s, size_t t) {
+    return std::make_pair(0, g.Dikstras(s, t, context, path));
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  auto tree = g.DeltaStepping(0, pool);
+  std::cout << "DeltaStepping, all " << SIDE * SIDE << " nodes: "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+  ASSERT_EQ(a, b);
+  ASSERT_EQ(a, c);
+  ASSERT_EQ(a, d);
+  ASSERT_EQ(tree.distance_[0], 0);
+}
+
+TEST(GraphBenchmark, DISABLED_Components) {
+  constexpr size_t NODES = 1 << 21;
+  using Clock = std::chrono::steady_clock;
+
+  auto edges = sparse_edges(NODES, NODES * 4, 88172645463325252u);
+  AdjacencyListGraph<int> g;
+  g.Reserve(NODES, edges.Size());
+  for (size_t n = 0; n < NODES; ++n) {
+    g.AddNode();
+  }
+  g.AddEdges(edges.begin(), edges.end());
+  auto transpose = g.Transpose();
+  ThreadPool pool;
+
+  auto time = [](const char* name, auto&& run) {
+    auto start = Clock::now();
+    auto result = run();
+    std::cout << name << ": " << std::chrono::duration<double, std::milli>(Clock::now() - start).count()
+              << " ms, " << result.count_ << " components" << std::endl;
+    return result;
+  };
+
+  std::cout << NODES << " nodes, " << edges.Size() << " edges, " << pool.Size() << " threads" << std::endl;
+  time("ConnectedComponents", [&]() { return g.ConnectedComponents(pool); });
+  auto serial = time("StronglyConnectedComponents (Tarjan)", [&]() { return g.StronglyConnectedComponents(); });
+  auto parallel = time("StronglyConnectedComponents (parallel)", [&]() {
+    return g.StronglyConnectedComponents(transpose, pool);
+  });
+
+  auto start = Clock::now();
+  ASSERT_FALSE(g.TopologicalSort(pool).has_value());
+  std::cout << "TopologicalSort: " << std::chrono::duration<double, std::milli>(Clock::now() - start).count()
+            << " ms" << std::endl;
+
+  ASSERT_EQ(parallel.count_, serial.count_);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(GraphBenchmark, DISABLED_MinimumSpanningForest) {
+  constexpr size_t SIDE = 1000;
+  using Clock = std::chrono::steady_clock;
+
+  auto g = grid_graph(SIDE, 88172645463325252u);
+  ThreadPool pool;
+
+  auto start = Clock::now();
+  auto kruskal = g.KruskalMST();
+  double kruskalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  auto boruvka = g.BoruvkaMST(pool);
+  double boruvkaMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  std::cout << g.NodeCount() << " nodes, " << g.EdgeCount() << " edges, " << pool.Size() << " threads" << std::endl;
+  std::cout << "KruskalMST: " << kruskalMs << " ms, BoruvkaMST: " << boruvkaMs << " ms ("
+            << kruskalMs / boruvkaMs << "x)" << std::endl;
+
+  ASSERT_EQ(boruvka.weight_, kruskal.weight_);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(GraphBenchmark, DISABLED_LinkAnalysis) {
+  constexpr size_t NODES = 1 << 21;
+  constexpr size_t ITERATIONS = 20;
+  using Clock = std::chrono::steady_clock;
+
+  auto edges = power_law_edges(NODES, NODES * 8, 88172645463325252u);
+  AdjacencyListGraph<int, uint32_t> g;
+  g.Reserve(NODES, edges.Size());
+  for (size_t n = 0; n < NODES; ++n) {
+    g.AddNode();
+  }
+  g.AddEdges(edges.begin(), edges.end());
+  auto transpose = g.Transpose();
+  ThreadPool pool;
+
+  std::cout << NODES << " nodes, " << edges.Size() << " power-law edges, " << pool.Size() << " threads" << std::endl;
+  auto report = [](const char* name, size_t iterations, Clock::time_point start) {
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << name << ": " << iterations / seconds << " iterations/s" << std::endl;
+  };
+
+  auto start = Clock::now();
+  auto pull = g.PageRank(transpose, pool, 0.85, 0, ITERATIONS);
+  report("PageRank (pull)", pull.iterations_, start);
+
+  start = Clock::now();
+  auto push = g.PageRank(pool, 0.85, 0, ITERATIONS);
+  report("PageRank (push, blocked)", push.iterations_, start);
+
+  start = Clock::now();
+  auto personal = g.PersonalizedPageRank({ 0, 1, 2 }, transpose, pool, 0.85, 0, ITERATIONS);
+  report("PersonalizedPageRank", personal.iterations_, start);
+
+  start = Clock::now();
+  auto communities = g.LabelPropagation(transpose, pool, ITERATIONS);
+  report("LabelPropagation (passes)", ITERATIONS, start);
+  std::cout << communities.count_ << " communities" << std::endl;
+
+  for (size_t n = 0; n < NODES; n += 4099) {
+    ASSERT_NEAR(push.rank_[n], pull.rank_[n], 1e-12);
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(GraphBenchmark, DISABLED_Reorder) {
+  using Clock = std::chrono::steady_clock;
+  constexpr size_t SIDE = 1000;
+  constexpr size_t NODES = 1 << 20;
+
+  ThreadPool pool;
+  auto grid = renumbered(grid_graph(SIDE, 88172645463325252u), shuffled(SIDE * SIDE, 2463534242u));
+  auto edges = power_law_edges(NODES, NODES * 8, 88172645463325252u);
+  AdjacencyListGraph<int> web;
+  web.Reserve(NODES, edges.Size());
+  for (size_t n = 0; n < NODES; ++n) {
+    web.AddNode();
+  }
+  web.AddEdges(edges.begin(), edges.end());
+
+  auto ms = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+
+  // A full BFS and five PageRank iterations over g.
+  auto traverse = [&](const AdjacencyListGraph<int>& g) {
+    auto start = Clock::now();
+    size_t seen = 0;
+    auto count = [&seen](size_t) { ++seen; };
+    g.BFS(0, std::numeric_limits<size_t>::max(), count);
+    g.PageRank(g.Transpose(), pool, 0.85, 0, 5);
+    return std::make_pair(ms(start), seen);
+  };
+
+  for (auto graph : { &grid, &web }) {
+    auto& g = *graph;
+    auto base = traverse(g);
+    std::cout << (graph == &grid ? "scrambled grid" : "power law") << ", " << g.NodeCount() << " nodes: "
+              << base.first << " ms for BFS and PageRank as loaded" << std::endl;
+
+    auto report = [&](const char* name, auto&& order) {
+      auto start = Clock::now();
+      auto permutation = order();
+      double orderMs = ms(start);
+      auto relabelled = g.Relabel(permutation);
+      auto after = traverse(relabelled);
+      std::cout << "  " << name << ": " << orderMs << " ms to order, " << after.first << " ms ("
+                << base.first / after.first << "x)" << std::endl;
+      ASSERT_GT(after.second, 0);
+    };
+
+    report("ReverseCuthillMcKeeOrder", [&]() { return g.ReverseCuthillMcKeeOrder(); });
+    report("DegreeOrder", [&]() { return g.DegreeOrder(); });
+    report("GorderOrder", [&]() { return g.GorderOrder(); });
+
+    auto start = Clock::now();
+    auto partition = g.Partition(8);
+    std::cout << "  Partition(8): " << ms(start) << " ms, " << partition.cut_ << " of " << g.EdgeCount()
+              << " edges cut" << std::endl;
+  }
+}
+
+} // namespace ds
@@ -1,7 +1,13 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <tuple>
+
 #include "../heap.h"
+#include "test-util.h"
 
 namespace ds {
 using namespace ::testing;
@@ -42,4 +48,414 @@ TEST(HeapTest, Pop) {
   ASSERT_THAT(a, ElementsAreArray({ 0, 1, 2, 3, 4, 7, 9, 11 }));
 }
 
+TEST(HeapTest, Arity) {
+  BinHeap<int, MinHeap, 4> h{ 7, 9, 4, 0, 11, 3, 1, 2, 8, 5, 6, 10 };
+  ArrayList<int> a;
+
+  while (!h.isEmpty()) {
+    a.Append(h.Pop());
+  }
+
+  ASSERT_THAT(a, ElementsAreArray({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }));
+
+  BinHeap<int, MaxHeap, 3> m{ 7, 9, 4, 0, 11, 3, 1, 2 };
+  ASSERT_EQ(m.Pop(), 11);
+  ASSERT_EQ(m.Pop(), 9);
+  ASSERT_EQ(m.Pop(), 7);
+}
+
+TEST(IndexedHeapTest, InsertPop) {
+  IndexedHeap<double, MinHeap> h(6);
+
+  h.Insert(3, 7.0);
+  h.Insert(0, 2.0);
+  h.Insert(5, 4.5);
+  h.Insert(1, 9.0);
+
+  ASSERT_EQ(h.Size(), 4);
+  ASSERT_TRUE(h.Contains(5));
+  ASSERT_FALSE(h.Contains(2));
+  ASSERT_EQ(h.Peek().first, 0);
+
+  ASSERT_EQ(h.Pop(), std::make_pair(size_t(0), 2.0));
+  ASSERT_EQ(h.Pop(), std::make_pair(size_t(5), 4.5));
+  ASSERT_FALSE(h.Contains(5));
+  ASSERT_EQ(h.Pop(), std::make_pair(size_t(3), 7.0));
+  ASSERT_EQ(h.Pop(), std::make_pair(size_t(1), 9.0));
+  ASSERT_TRUE(h.isEmpty());
+}
+
+TEST(IndexedHeapTest, UpdateErase) {
+  IndexedHeap<int, MinHeap, 2> h(10);
+
+  for (size_t i = 0; i < 10; ++i) {
+    h.Insert(i, static_cast<int>(100 + i));
+  }
+
+  h.DecreaseKey(7, 1);
+  ASSERT_EQ(h.Peek().first, 7);
+  ASSERT_EQ(h.Priority(7), 1);
+
+  h.IncreaseKey(7, 200);
+  ASSERT_EQ(h.Peek().first, 0);
+
+  h.Erase(0);
+  h.Erase(4);
+  ASSERT_FALSE(h.Contains(0));
+  ASSERT_EQ(h.Size(), 8);
+
+  ArrayList<size_t> order;
+  while (!h.isEmpty()) {
+    order.Append(h.Pop().first);
+  }
+  ASSERT_THAT(order, ElementsAreArray({ 1, 2, 3, 5, 6, 8, 9, 7 }));
+
+  h.Insert(4, 5);
+  h.Insert(0, 3);
+  h.Clear();
+  ASSERT_TRUE(h.isEmpty());
+  ASSERT_FALSE(h.Contains(4));
+  h.Insert(4, 1);
+  ASSERT_EQ(h.Pop().first, 4);
+}
+
+TEST(IndexedHeapTest, HandleOutOfRange) {
+  IndexedHeap<int, MinHeap> h(4);
+  h.Insert(1, 10);
+
+  ASSERT_DEATH({ h.Priority(4); }, "out of bounds");
+  ASSERT_DEATH({ h.Update(7, 1); }, "out of bounds");
+  ASSERT_DEATH({ h.Erase(100); }, "out of bounds");
+  ASSERT_DEATH({ h.Erase(2); }, "out of bounds");
+}
+
+TEST(IndexedHeapTest, MaxHeap) {
+  IndexedHeap<int, MaxHeap> h(4);
+
+  h.Insert(0, 5);
+  h.Insert(1, 8);
+  h.Insert(2, 1);
+  ASSERT_EQ(h.Peek().first, 1);
+
+  // In a MaxHeap a larger priority is towards the top.
+  h.DecreaseKey(2, 9);
+  ASSERT_EQ(h.Peek().first, 2);
+  h.IncreaseKey(2, 1);
+  h.Update(1, 0);
+  ASSERT_EQ(h.Pop().first, 0);
+  ASSERT_EQ(h.Pop().first, 2);
+  ASSERT_EQ(h.Pop().first, 1);
+}
+
+// The direction checks are asserts, compiled out of Release builds.
+#ifndef NDEBUG
+TEST(IndexedHeapTest, KeyDirection) {
+  IndexedHeap<int, MaxHeap> h(4);
+  h.Insert(0, 5);
+  h.Insert(1, 8);
+
+  ASSERT_DEATH({ h.DecreaseKey(1, 0); }, "");
+  ASSERT_DEATH({ h.IncreaseKey(0, 9); }, "");
+}
+#endif
+
+TEST(HeapTest, Heapify) {
+  ArrayList<int> in{ 7, 9, 4, 0, 11, 3, 1, 2, 8, 5, 6, 10 };
+  BinHeap<int, MaxHeap, 4> h(in.begin(), in.end());
+
+  ASSERT_EQ(h.Size(), 12);
+  ASSERT_EQ(h.Top(), 11);
+
+  h.Heapify(in.begin(), in.begin() + 3);
+  ArrayList<int> a;
+  while (!h.isEmpty()) {
+    a.Append(h.Pop());
+  }
+
+  ASSERT_THAT(a, ElementsAreArray({ 11, 10, 9, 9, 8, 7, 7, 6, 5, 4, 4, 3, 2, 1, 0 }));
+}
+
+TEST(HeapTest, PushPopReplace) {
+  BinHeap<int, MinHeap> h{ 5, 3, 8 };
+
+  ASSERT_EQ(h.PushPop(1), 1);
+  ASSERT_EQ(h.Size(), 3);
+  ASSERT_EQ(h.PushPop(6), 3);
+  ASSERT_EQ(h.Top(), 5);
+
+  ASSERT_EQ(h.Replace(0), 5);
+  ASSERT_EQ(h.Top(), 0);
+  ASSERT_EQ(h.Size(), 3);
+
+  ASSERT_EQ(h.Pop(), 0);
+  ASSERT_EQ(h.Pop(), 6);
+  ASSERT_EQ(h.Pop(), 8);
+}
+
+struct Job {
+  int priority_;
+  std::unique_ptr<std::string> payload_;
+
+  Job()
+      : priority_(0),
+        payload_() {
+
+  }
+
+  Job(int priority, const std::string& payload)
+      : priority_(priority),
+        payload_(std::make_unique<std::string>(payload)) {
+
+  }
+
+  bool operator<(const Job& other) const { return priority_ < other.priority_; }
+};
+
+TEST(HeapTest, MoveOnly) {
+  BinHeap<Job, MinHeap> h;
+
+  h.Emplace(3, "c");
+  h.Emplace(1, "a");
+  h.Insert(Job(2, "b"));
+
+  ASSERT_EQ(*h.Top().payload_, "a");
+
+  auto replaced = h.Replace(Job(4, "d"));
+  ASSERT_EQ(*replaced.payload_, "a");
+
+  ASSERT_EQ(*h.Pop().payload_, "b");
+  ASSERT_EQ(*h.Pop().payload_, "c");
+  ASSERT_EQ(*h.Pop().payload_, "d");
+  ASSERT_TRUE(h.isEmpty());
+}
+
+TEST(HeapTest, Comparator) {
+  static_assert(sizeof(BinHeap<int, MinHeap>) == sizeof(ArrayList<int>), "stateless comparators take no space");
+
+  using Task = std::tuple<int, int>;
+  BinHeap<Task, MinHeap> tasks{ { 5, 1 }, { 2, 7 }, { 5, 0 }, { 9, 3 } };
+  ASSERT_EQ(tasks.Pop(), Task(2, 7));
+  ASSERT_EQ(tasks.Pop(), Task(5, 0));
+  ASSERT_EQ(tasks.Pop(), Task(5, 1));
+
+  auto byId = by_key([](const Task& t) { return std::get<1>(t); }, descending);
+  BinHeap<Task, decltype(byId), 4> ids({ { 5, 1 }, { 2, 7 }, { 5, 0 }, { 9, 3 } }, byId);
+  ASSERT_EQ(std::get<1>(ids.Pop()), 7);
+  ASSERT_EQ(std::get<1>(ids.Pop()), 3);
+
+  auto parity = [](int lhs, int rhs) { return (lhs % 2) < (rhs % 2) || ((lhs % 2) == (rhs % 2) && lhs < rhs); };
+  BinHeap<int, decltype(parity)> evens({ 3, 8, 1, 4, 6 }, parity);
+  ASSERT_EQ(evens.Pop(), 4);
+  ASSERT_EQ(evens.Pop(), 6);
+  ASSERT_EQ(evens.Pop(), 8);
+  ASSERT_EQ(evens.Pop(), 1);
+}
+
+TEST(RadixHeapTest, Monotone) {
+  RadixHeap<uint32_t, char> h;
+  ASSERT_TRUE(h.isEmpty());
+
+  h.Insert(5, 'c');
+  h.Insert(1, 'a');
+  h.Insert(3, 'b');
+  h.Insert(1000, 'e');
+  ASSERT_EQ(h.Size(), 4);
+  ASSERT_EQ(h.Peek(), std::make_pair(1u, 'a'));
+  ASSERT_EQ(h.Pop().second, 'a');
+
+  // Keys may be inserted anywhere at or above the last one popped.
+  h.Insert(1, 'x');
+  h.Insert(7, 'd');
+  ASSERT_EQ(h.Pop().second, 'x');
+  ASSERT_EQ(h.Pop().second, 'b');
+  ASSERT_EQ(h.Pop().second, 'c');
+  ASSERT_EQ(h.Pop().second, 'd');
+  ASSERT_EQ(h.Pop().first, 1000);
+  ASSERT_TRUE(h.isEmpty());
+}
+
+TEST(RadixHeapTest, MatchesBinHeap) {
+  RadixHeap<uint64_t, size_t> radix;
+  BinHeap<uint64_t, MinHeap> bin;
+  uint64_t x = 88172645463325252u;
+  uint64_t last = 0;
+
+  for (size_t i = 0; i < 5000; ++i) {
+    next_random(x);
+
+    // Some runs of small steps, for many equal keys.
+    auto key = last + x % (i % 100 < 20 ? 4 : 100000);
+    radix.Insert(key, i);
+    bin.Insert(key);
+
+    // Peek names the very entry Pop takes.
+    if (x % 3 == 0) {
+      auto top = radix.Peek();
+      ASSERT_EQ(radix.Pop(), top);
+      last = top.first;
+      ASSERT_EQ(last, bin.Pop());
+    }
+  }
+
+  while (!bin.isEmpty()) {
+    auto top = radix.Peek();
+    ASSERT_EQ(radix.Pop(), top);
+    ASSERT_EQ(top.first, bin.Pop());
+  }
+  ASSERT_TRUE(radix.isEmpty());
+}
+
+TEST(PairingHeapTest, InsertPop) {
+  PairingHeap<int> h;
+  for (auto val : { 5, 3, 9, 1, 7, 3, 8 }) {
+    h.Insert(val);
+  }
+
+  ASSERT_EQ(h.Size(), 7);
+  ASSERT_EQ(h.Peek(), 1);
+
+  ArrayList<int> out;
+  while (!h.isEmpty()) {
+    out.Append(h.Pop());
+  }
+  ASSERT_THAT(out, ElementsAreArray({ 1, 3, 3, 5, 7, 8, 9 }));
+}
+
+TEST(PairingHeapTest, DecreaseKeyAndMeld) {
+  PairingHeap<int, MaxHeap> a;
+  PairingHeap<int, MaxHeap> b;
+
+  a.Insert(10);
+  auto four = a.Insert(4);
+  a.Insert(6);
+  auto two = b.Insert(2);
+  b.Insert(8);
+
+  a.DecreaseKey(four, 12);
+  ASSERT_EQ(a.Top(), 12);
+
+  a.Meld(b);
+  ASSERT_TRUE(b.isEmpty());
+  ASSERT_EQ(a.Size(), 5);
+
+  a.DecreaseKey(two, 11);
+
+  ArrayList<int> out;
+  while (!a.isEmpty()) {
+    out.Append(a.Pop());
+  }
+  ASSERT_THAT(out, ElementsAreArray({ 12, 11, 10, 8, 6 }));
+}
+
+TEST(MultiQueueTest, PushTryPop) {
+  MultiQueue<int> q(4);
+
+  ASSERT_EQ(q.ShardCount(), 4);
+  ASSERT_FALSE(q.TryPop().has_value());
+
+  for (int i = 0; i < 100; ++i) {
+    q.Push(i);
+  }
+  ASSERT_EQ(q.Size(), 100);
+
+  ArrayList<int> popped;
+  while (auto val = q.TryPop()) {
+    popped.Append(*val);
+  }
+
+  ASSERT_TRUE(q.isEmpty());
+  std::sort(popped.begin(), popped.end());
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(popped[i], i);
+  }
+}
+
+TEST(MultiQueueTest, Concurrent) {
+  constexpr int THREADS = 4;
+  constexpr int PER_THREAD = 5000;
+  MultiQueue<int, MaxHeap> q(2 * THREADS);
+  std::atomic<long long> sum(0);
+  std::atomic<int> count(0);
+
+  ArrayList<std::thread> workers;
+  for (int t = 0; t < THREADS; ++t) {
+    workers.Append(std::thread([&q, &sum, &count, t]() {
+      for (int i = 0; i < PER_THREAD; ++i) {
+        q.Push(t * PER_THREAD + i);
+        if (i % 2) {
+          if (auto val = q.TryPop()) {
+            sum += *val;
+            ++count;
+          }
+        }
+      }
+    }));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  while (auto val = q.TryPop()) {
+    sum += *val;
+    ++count;
+  }
+
+  long long n = THREADS * PER_THREAD;
+  ASSERT_EQ(count, n);
+  ASSERT_EQ(sum, n * (n - 1) / 2);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(HeapBenchmark, DISABLED_MultiQueueScaling) {
+  constexpr size_t OPS = 1 << 20;
+
+  for (size_t threads = 1; threads <= 64; threads *= 2) {
+    MultiQueue<uint64_t> q(2 * threads);
+
+    for (uint64_t i = 0; i < OPS / 4; ++i) {
+      q.Push(i * 2654435761u % OPS);
+    }
+
+    ArrayList<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+      workers.Append(std::thread([&q, threads, t]() {
+        uint64_t x = t;
+        for (size_t i = 0; i < OPS / threads; ++i) {
+          if (i % 2) {
+            q.TryPop();
+          }
+          else {
+            q.Push(x = x * 6364136223846793005u + 1442695040888963407u);
+          }
+        }
+      }));
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Rank error: pop a permutation of 0..n-1 and count, for each pop, the
+    // smaller values still queued (a Fenwick tree over what has gone).
+    constexpr size_t N = 1 << 16;
+    MultiQueue<size_t> r(2 * threads);
+    for (size_t i = 0; i < N; ++i) {
+      r.Push(i * 40503 % N);
+    }
+    ArrayList<size_t> fenwick(N + 1, 0);
+    double rankError = 0;
+    for (size_t popped = 0; popped < N; ++popped) {
+      size_t val = *r.TryPop();
+      size_t gone = 0;
+      for (size_t i = val; i > 0; i -= i & (~i + 1)) gone += fenwick[i];
+      rankError += static_cast<double>(val - gone);
+      for (size_t i = val + 1; i <= N; i += i & (~i + 1)) fenwick[i] += 1;
+    }
+
+    std::cout << threads << " threads: " << (OPS / seconds) / 1e6 << " Mops/s, mean rank error "
+              << rankError / N << std::endl;
+  }
+}
+
 } // namespace ds
\ No newline at end of file
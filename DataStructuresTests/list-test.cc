@@ -117,6 +117,28 @@ TEST(ArrayListTest, Add) {
   EXPECT_TRUE(a.isEqual({7, 1, 2, 0 }));
 }
 
+TEST(ArrayListTest, Reserve) {
+  ArrayList<int> a{ 1, 2 };
+
+  a.Reserve(16);
+  EXPECT_EQ(a.Capacity(), 16);
+  EXPECT_TRUE(a.isEqual({ 1, 2 }));
+
+  a.Append(3);
+  EXPECT_EQ(a.Capacity(), 16);
+
+  a.Reserve(4);
+  EXPECT_EQ(a.Capacity(), 16);
+  EXPECT_TRUE(a.isEqual({ 1, 2, 3 }));
+
+  a.Clear();
+  EXPECT_TRUE(a.isEmpty());
+  EXPECT_EQ(a.Capacity(), 16);
+
+  a.Append(4);
+  EXPECT_TRUE(a.isEqual({ 4 }));
+}
+
 TEST(ArrayListTest, Remove) {
   ArrayList<int> a{ 0, 1, 2, 3, 4 };
 
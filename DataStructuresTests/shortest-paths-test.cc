@@ -0,0 +1,198 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+#include "../shortest-paths.h"
+#include "test-util.h"
+
+namespace ds {
+using namespace ::testing;
+
+namespace {
+
+// Random directed edges; weight 0 gives every edge weight 1.
+ArrayList<GraphEdge> random_edges(size_t nodes, size_t edges, size_t weight, uint64_t seed) {
+  ArrayList<GraphEdge> list;
+  uint64_t x = seed;
+
+  for (size_t i = 0; i < edges; ++i) {
+    size_t src = next_random(x) % nodes;
+    size_t dest = next_random(x) % nodes;
+    double w = weight ? static_cast<double>(1 + next_random(x) % weight) : 1.0;
+    list.Append(GraphEdge(src, dest, w));
+  }
+
+  return list;
+}
+
+ArrayList<size_t> random_sources(size_t count, size_t nodes, uint64_t seed) {
+  ArrayList<size_t> sources;
+  uint64_t x = seed;
+  for (size_t i = 0; i < count; ++i) {
+    sources.Append(next_random(x) % nodes);
+  }
+  return sources;
+}
+
+} // namespace
+
+TEST(MultiSourceShortestPathsTest, WeightedMatchesDeltaStepping) {
+  constexpr size_t NODES = 2000;
+  auto edges = random_edges(NODES, 6000, 20, 88172645463325252u);
+  CSRGraph<int> g(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  ThreadPool pool(3);
+
+  MultiSourceShortestPaths<CSRGraph<int>> paths(g, pool);
+  ASSERT_FALSE(paths.isUnweighted());
+
+  auto sources = random_sources(40, NODES, 2463534242u);
+  auto matrix = paths.Matrix(sources);
+  ASSERT_EQ(matrix.rows_, sources.Size());
+  ASSERT_EQ(matrix.columns_, NODES);
+
+  std::mutex lock;
+  ArrayList<size_t> calls(sources.Size(), 0);
+
+  paths.ForEach(sources, [&](size_t i, const ArrayList<double>& distances) {
+    std::lock_guard<std::mutex> guard(lock);
+    ++calls[i];
+    ASSERT_TRUE(std::equal(distances.begin(), distances.end(), matrix.Row(i)));
+  });
+
+  for (size_t i = 0; i < sources.Size(); ++i) {
+    ASSERT_EQ(calls[i], 1);
+    auto tree = g.DeltaStepping(sources[i], pool);
+    for (size_t n = 0; n < NODES; ++n) {
+      ASSERT_EQ(matrix.At(i, n), tree.distance_[n]);
+    }
+  }
+}
+
+TEST(MultiSourceShortestPathsTest, UnweightedMatchesBFS) {
+  constexpr size_t NODES = 3000;
+  auto edges = random_edges(NODES, 4500, 0, 11400714819323198485u);
+  CSRGraph<int> csr(ArrayList<int>(NODES, 0), edges.begin(), edges.end());
+  AdjacencyListGraph<int> g;
+  for (size_t n = 0; n < NODES; ++n) {
+    g.AddNode();
+  }
+  g.AddEdges(edges.begin(), edges.end());
+
+  ThreadPool pool(2);
+  MultiSourceShortestPaths<AdjacencyListGraph<int>> paths(g, pool);
+  ASSERT_TRUE(paths.isUnweighted());
+
+  // Two full batches and a partial one, with a repeated source.
+  auto sources = random_sources(150, NODES, 2463534242u);
+  sources[7] = sources[3];
+  auto transpose = csr.Transpose();
+
+  for (int round = 0; round < 2; ++round) {
+    auto matrix = paths.Matrix(sources);
+
+    for (size_t i = 0; i < sources.Size(); ++i) {
+      auto bfs = csr.ParallelBFS(sources[i], transpose, pool);
+      for (size_t n = 0; n < NODES; ++n) {
+        double expected = bfs.distance_[n] == BFSResult::UNREACHED
+          ? DistanceMatrix::UNREACHED : static_cast<double>(bfs.distance_[n]);
+        ASSERT_EQ(matrix.At(i, n), expected);
+      }
+    }
+  }
+}
+
+TEST(MultiSourceShortestPathsTest, UniformWeight) {
+  AdjacencyListGraph<int> g(4, { 0, 1, 2, 3 },
+    { {0, 1, 2.5}, {1, 2, 2.5}, {0, 2, 2.5}, {2, 3, 2.5} }
+  );
+  ThreadPool pool(2);
+  MultiSourceShortestPaths<AdjacencyListGraph<int>> paths(g, pool);
+  ASSERT_TRUE(paths.isUnweighted());
+
+  ArrayList<size_t> sources{ 0, 3, 1 };
+  ArrayList<ArrayList<double>> rows(sources.Size(), ArrayList<double>());
+  paths.ForEach(sources, [&rows](size_t i, const ArrayList<double>& distances) {
+    rows[i] = distances;
+  });
+
+  constexpr double INF = DistanceMatrix::UNREACHED;
+  ASSERT_THAT(rows[0], ElementsAreArray({ 0.0, 2.5, 2.5, 5.0 }));
+  ASSERT_THAT(rows[1], ElementsAreArray({ INF, INF, INF, 0.0 }));
+  ASSERT_THAT(rows[2], ElementsAreArray({ INF, 0.0, 2.5, 5.0 }));
+}
+
+TEST(MultiSourceShortestPathsTest, GraphGrowsBetweenCalls) {
+  AdjacencyListGraph<int> g(3, { 0, 1, 2 }, { {0, 1, 1.0}, {1, 2, 1.0} });
+  ThreadPool pool(2);
+  MultiSourceShortestPaths<AdjacencyListGraph<int>> paths(g, pool);
+  ASSERT_TRUE(paths.isUnweighted());
+
+  ArrayList<size_t> sources{ 0, 1 };
+  DistanceMatrix before = paths.Matrix(sources);
+  ASSERT_EQ(before.columns_, 3);
+  ASSERT_EQ(before.At(0, 2), 2.0);
+
+  // A new node outgrows the workspaces and a heavier edge ends the BFS case.
+  size_t added = g.AddNode(3);
+  g.AddEdge(2, added, 1.0);
+  g.AddEdge(0, 2, 5.0);
+
+  DistanceMatrix after = paths.Matrix(sources);
+  ASSERT_FALSE(paths.isUnweighted());
+  ASSERT_EQ(after.columns_, 4);
+
+  constexpr double INF = DistanceMatrix::UNREACHED;
+  double expected[2][4] = { { 0.0, 1.0, 2.0, 3.0 }, { INF, 0.0, 1.0, 2.0 } };
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t n = 0; n < 4; ++n) {
+      ASSERT_EQ(after.At(i, n), expected[i][n]);
+    }
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(MultiSourceShortestPathsBenchmark, DISABLED_Batch) {
+  constexpr size_t NODES = 200000;
+  constexpr size_t SOURCES = 256;
+  using Clock = std::chrono::steady_clock;
+
+  ThreadPool pool;
+  auto sources = random_sources(SOURCES, NODES, 2463534242u);
+
+  for (size_t weight : { size_t(20), size_t(0) }) {
+    auto edges = random_edges(NODES, NODES * 8, weight, 88172645463325252u);
+    AdjacencyListGraph<int> g;
+    g.Reserve(NODES + 1, edges.Size());
+    for (size_t n = 0; n <= NODES; ++n) {
+      g.AddNode();
+    }
+    g.AddEdges(edges.begin(), edges.end());
+
+    // Node NODES has no edges, so a Dikstras call towards it searches
+    // everything a source reaches: the cost of one all-targets row done
+    // pair by pair, with its arrays and heap rebuilt each time.
+    constexpr size_t BASELINE = 8;
+    auto begin = Clock::now();
+    for (size_t i = 0; i < BASELINE; ++i) {
+      g.Dikstras(sources[i], NODES);
+    }
+    double perSource = std::chrono::duration<double, std::milli>(Clock::now() - begin).count() / BASELINE;
+
+    MultiSourceShortestPaths<AdjacencyListGraph<int>> paths(g, pool);
+    begin = Clock::now();
+    auto matrix = paths.Matrix(sources);
+    double batch = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    std::cout << (paths.isUnweighted() ? "unweighted" : "weighted") << ", " << pool.Size() << " threads: "
+              << perSource * SOURCES << " ms as " << SOURCES << " Dikstras calls, " << batch
+              << " ms batched (" << perSource * SOURCES / batch << "x)" << std::endl;
+    ASSERT_EQ(matrix.At(0, sources[0]), 0);
+  }
+}
+
+} // namespace ds
@@ -3,6 +3,9 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <chrono>
+#include <random>
+
 #include "../sort.h"
 #include "../list.h"
 namespace ds {
@@ -84,4 +87,221 @@ TEST(QuickSortTest, ArrayListDescending) {
   TEST_QSORT<std::string>({ "b", "a", "ab", "c", "cab" }, { "cab", "c", "b", "ab", "a" }, descending);
 }
 
+TEST(NthElementTest, ArrayList) {
+  ArrayList<int> a{ 0, 3, 1, 2, 7, 12, -2, 1, 2, 6 };
+  ArrayList<int> sorted{ -2, 0, 1, 1, 2, 2, 3, 6, 7, 12 };
+
+  for (size_t n = 0; n < a.Size(); ++n) {
+    ArrayList<int> b(a);
+    nth_element(b.begin(), b.begin() + n, b.end());
+    ASSERT_EQ(b[n], sorted[n]);
+    for (size_t i = 0; i < n; ++i) {
+      ASSERT_LE(b[i], b[n]);
+    }
+    for (size_t i = n + 1; i < b.Size(); ++i) {
+      ASSERT_GE(b[i], b[n]);
+    }
+  }
+}
+
+TEST(NthElementTest, Large) {
+  ArrayList<int> a;
+  for (int i = 0; i < 1000; ++i) {
+    a.Append((i * 7919) % 1000);
+  }
+
+  nth_element(a.begin(), a.begin() + 500, a.end());
+  ASSERT_EQ(a[500], 500);
+
+  nth_element(a.begin(), a.begin() + 10, a.end(), descending);
+  ASSERT_EQ(a[10], 989);
+}
+
+TEST(NthElementTest, Duplicates) {
+  ArrayList<int> a(1000, 4);
+  a[0] = 1;
+  a[999] = 9;
+
+  nth_element(a.begin(), a.begin() + 998, a.end());
+  ASSERT_EQ(a[998], 4);
+  ASSERT_EQ(a[999], 9);
+}
+
+TEST(PartialSortTest, ArrayList) {
+  ArrayList<int> a{ 0, 3, 1, 2, 7, 12, -2, 1, 2, 6 };
+  partial_sort(a.begin(), a.begin() + 4, a.end());
+  ASSERT_THAT(std::vector<int>(a.begin(), a.begin() + 4), ElementsAreArray({ -2, 0, 1, 1 }));
+
+  ArrayList<std::string> s{ "b", "a", "ab", "c", "cab" };
+  ds::partial_sort(s.begin(), s.begin() + 2, s.end(), descending);
+  ASSERT_THAT(std::vector<std::string>(s.begin(), s.begin() + 2), ElementsAreArray({ "cab", "c" }));
+}
+
+TEST(TopKTest, ArrayList) {
+  ArrayList<int> a{ 0, 3, 1, 2, 7, 12, -2, 1, 2, 6 };
+
+  ASSERT_THAT(top_k(a.begin(), a.end(), 3), ElementsAreArray({ -2, 0, 1 }));
+  ASSERT_THAT(top_k(a.begin(), a.end(), 3, descending), ElementsAreArray({ 12, 7, 6 }));
+  ASSERT_THAT(top_k(a.begin(), a.end(), 20), ElementsAreArray({ -2, 0, 1, 1, 2, 2, 3, 6, 7, 12 }));
+  ASSERT_TRUE(top_k(a.begin(), a.end(), 0).isEmpty());
+}
+
+TEST(TopKTest, Stream) {
+  TopK<int, decltype(descending)> selector(2, descending);
+
+  for (int val : { 4, 8, 1, 9, 3 }) {
+    selector.Push(val);
+  }
+
+  ASSERT_EQ(selector.Size(), 2);
+  ASSERT_THAT(selector.Result(), ElementsAreArray({ 9, 8 }));
+}
+
+TEST(TopKTest, TemporaryComparator) {
+  struct Score {
+    int value_ = 0;
+  };
+
+  TopK<Score, decltype(by_key(&Score::value_))> selector(2, by_key(&Score::value_));
+  for (int val : { 4, 8, 1, 9, 3 }) {
+    selector.Push(Score{ val });
+  }
+
+  auto best = selector.Result();
+  ASSERT_EQ(best.Size(), 2);
+  ASSERT_EQ(best[0].value_, 1);
+  ASSERT_EQ(best[1].value_, 3);
+
+  ArrayList<int> a{ 5, 2, 7, 1 };
+  ASSERT_THAT(top_k(a.begin(), a.end(), 2, _::descending_<>{}), ElementsAreArray({ 7, 5 }));
+}
+
+template <class T>
+void TEST_PRIMITIVE_SORTS() {
+  std::mt19937_64 rng(42);
+
+  for (size_t n = 0; n < 300; n += (n < 70) ? 1 : 37) {
+    ArrayList<T> in;
+    for (size_t i = 0; i < n; ++i) {
+      in.Append(static_cast<T>(rng() % 100));
+    }
+
+    std::vector<T> expected(in.begin(), in.end());
+    std::sort(expected.begin(), expected.end());
+
+    ArrayList<T> a(in);
+    merge_sort(a.begin(), a.end());
+    ASSERT_THAT(a, ElementsAreArray(expected)) << "merge_sort n=" << n;
+
+    ArrayList<T> b(in);
+    quick_sort(b.begin(), b.end());
+    ASSERT_THAT(b, ElementsAreArray(expected)) << "quick_sort n=" << n;
+
+    std::reverse(expected.begin(), expected.end());
+
+    ArrayList<T> c(in);
+    merge_sort(c.begin(), c.end(), descending);
+    ASSERT_THAT(c, ElementsAreArray(expected)) << "merge_sort descending n=" << n;
+
+    ArrayList<T> d(in);
+    quick_sort(d.begin(), d.end(), descending);
+    ASSERT_THAT(d, ElementsAreArray(expected)) << "quick_sort descending n=" << n;
+  }
+}
+
+TEST(MergeSortTest, PrimitiveBlocks) {
+  TEST_PRIMITIVE_SORTS<int32_t>();
+  TEST_PRIMITIVE_SORTS<float>();
+  TEST_PRIMITIVE_SORTS<uint64_t>();
+}
+
+#if defined(_MSC_VER) && defined(_M_X64)
+// The x64 configurations build with /arch:AVX2, so PrimitiveBlocks runs the
+// vector kernels there rather than the scalar fallback.
+TEST(MergeSortTest, VectorKernelsEnabled) {
+  ASSERT_EQ(_::simd_<int32_t>::LANES, 8);
+  ASSERT_EQ(_::simd_<float>::LANES, 8);
+}
+#endif
+
+struct Record {
+  int key_;
+  std::string name_;
+
+  int Key() const { return key_; }
+};
+
+TEST(MergeSortTest, ByKey) {
+  ArrayList<Record> a{ { 3, "c" }, { 1, "a" }, { 2, "b1" }, { 2, "b2" }, { 0, "z" } };
+  auto names = [&a]() {
+    std::vector<std::string> out;
+    std::for_each(a.begin(), a.end(), [&out](const Record& r) { out.push_back(r.name_); });
+    return out;
+  };
+
+  merge_sort(a.begin(), a.end(), by_key(&Record::key_));
+  ASSERT_THAT(names(), ElementsAreArray({ "z", "a", "b1", "b2", "c" }));
+
+  merge_sort(a.begin(), a.end(), by_key(&Record::Key, descending));
+  ASSERT_THAT(names(), ElementsAreArray({ "c", "b1", "b2", "a", "z" }));
+
+  quick_sort(a.begin(), a.end(), by_key([](const Record& r) { return r.name_; }));
+  ASSERT_EQ(a[0].name_, "a");
+  ASSERT_EQ(a[4].name_, "z");
+}
+
+TEST(MergeSortTest, Stable) {
+  ArrayList<std::pair<int, int>> a;
+  for (int i = 0; i < 100; ++i) {
+    a.Append(std::make_pair(i % 3, i));
+  }
+
+  merge_sort(a.begin(), a.end(), by_key(&std::pair<int, int>::first, descending));
+
+  for (size_t i = 1; i < a.Size(); ++i) {
+    ASSERT_GE(a[i - 1].first, a[i].first);
+    if (a[i - 1].first == a[i].first) {
+      ASSERT_LT(a[i - 1].second, a[i].second);
+    }
+  }
+}
+
+TEST(MergeSortTest, Comparators) {
+  EXPECT_TRUE(ascending(1, 2));
+  EXPECT_FALSE(ascending(2, 2));
+  EXPECT_TRUE(descending(2, 1));
+  EXPECT_FALSE(descending(2, 2));
+
+  int a = 1;
+  const int b = 2;
+  EXPECT_TRUE(ascending(a, b));
+  EXPECT_TRUE(_::ascending_<int>{}(a, b));
+  EXPECT_TRUE(ascending(1, 2.5));
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(SortBenchmark, DISABLED_BranchlessCompare) {
+  std::mt19937_64 rng(7);
+  ArrayList<double> in;
+  for (size_t i = 0; i < (1 << 21); ++i) {
+    in.Append(static_cast<double>(rng()));
+  }
+
+  auto time = [&in](const char* name, auto sort) {
+    ArrayList<double> a(in);
+    auto start = std::chrono::steady_clock::now();
+    sort(a);
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << ms << " ms" << std::endl;
+    ASSERT_TRUE(std::is_sorted(a.begin(), a.end()));
+  };
+
+  auto generic = [](double lhs, double rhs) { return lhs < rhs; };
+
+  time("merge_sort branchless", [](ArrayList<double>& a) { merge_sort(a.begin(), a.end(), ascending); });
+  time("merge_sort generic   ", [&generic](ArrayList<double>& a) { merge_sort(a.begin(), a.end(), generic); });
+  time("quick_sort branchless", [](ArrayList<double>& a) { quick_sort(a.begin(), a.end(), ascending); });
+  time("quick_sort generic   ", [&generic](ArrayList<double>& a) { quick_sort(a.begin(), a.end(), generic); });
+}
+
 } // namespace ds
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../common.h"
+#include "../list.h"
+
+namespace ds {
+
+// Deterministic test data: advances seed x, which must be nonzero, and
+// returns it.
+inline uint64_t next_random(uint64_t& x) {
+  return _::xorshift_(x);
+}
+
+// Sum of the path's edge weights, or -1 if a step is not an edge.
+template <class Graph>
+double path_length(const Graph& g, const ArrayList<size_t>& path) {
+  double length = 0;
+  for (size_t i = 1; i < path.Size(); ++i) {
+    double step = -1;
+    g.ForEachEdge(path[i - 1], [&](size_t dest, double weight) {
+      if (dest == path[i] && (step < 0 || weight < step)) step = weight;
+    });
+    if (step < 0) return -1;
+    length += step;
+  }
+  return length;
+}
+
+} // namespace ds
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "../thread-pool.h"
+
+namespace ds {
+using namespace ::testing;
+
+TEST(ThreadPoolTest, Run) {
+  ThreadPool pool(4);
+  ASSERT_EQ(pool.Size(), 4);
+
+  ArrayList<int> seen(4, 0);
+  for (int round = 0; round < 100; ++round) {
+    pool.Run([&seen](size_t worker) { ++seen[worker]; });
+  }
+
+  ASSERT_THAT(seen, ElementsAreArray({ 100, 100, 100, 100 }));
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+  ThreadPool pool(3);
+  ArrayList<int> hits(1000, 0);
+  std::atomic<size_t> calls(0);
+
+  pool.ParallelFor(0, hits.Size(), 7, [&](size_t lo, size_t hi, size_t worker) {
+    ASSERT_LT(worker, 3);
+    ++calls;
+    for (size_t i = lo; i < hi; ++i) {
+      ++hits[i];
+    }
+  });
+
+  ASSERT_EQ(calls, (1000 + 6) / 7);
+  for (auto hit : hits) {
+    ASSERT_EQ(hit, 1);
+  }
+
+  // An empty range runs nothing.
+  pool.ParallelFor(5, 5, 1, [&](size_t, size_t, size_t) { ++calls; });
+  ASSERT_EQ(calls, (1000 + 6) / 7);
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+  ThreadPool pool(1);
+  size_t sum = 0;
+
+  pool.ParallelFor(0, 10, 3, [&sum](size_t lo, size_t hi, size_t worker) {
+    sum += (hi - lo) * (worker + 1);
+  });
+
+  ASSERT_EQ(sum, 10);
+}
+
+} // namespace ds
@@ -3,8 +3,15 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+
 #include "../list.h"
+#include "../sort.h"
 #include "../tree.h"
+#include "test-util.h"
 
 
 namespace ds {
@@ -148,6 +155,466 @@ TEST(AVLTreeTest, PostorderTraversal) {
   EXPECT_TRUE(v.vec_.isEqual(expected));
 }
 
+TEST(FlatAVLTreeTest, Insert) {
+  FlatAVLTree<int> tree;
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_FALSE(tree.Root().has_value());
+  ASSERT_EQ(tree.Height(), 0);
+
+  ASSERT_TRUE(tree.Insert(5));
+  ASSERT_TRUE(tree.Insert(7));
+  ASSERT_FALSE(tree.Insert(5));
+  ASSERT_EQ(tree.Size(), 2);
+  ASSERT_EQ(tree.Height(), 2);
+
+  ASSERT_TRUE(tree.Insert(4));
+  ASSERT_EQ(tree.Value(*tree.Root()), 5);
+  ASSERT_EQ(tree.Height(), 2);
+  ASSERT_TRUE(tree.Insert(8));
+  ASSERT_EQ(tree.Height(), 3);
+}
+
+TEST(FlatAVLTreeTest, Rotations) {
+  auto root = [](std::initializer_list<int>&& list) {
+    auto tree = FlatAVLTree<int>::FromList(std::move(list));
+    EXPECT_EQ(tree.Height(), 3);
+    return tree.Value(*tree.Root());
+  };
+
+  ASSERT_EQ(root({ 5, 4, 3, 2, 1, 0 }), 2);  // right
+  ASSERT_EQ(root({ 1, 2, 3, 4, 5, 6 }), 4);  // left
+  ASSERT_EQ(root({ 4, 5, 1, 0, 3, 2 }), 3);  // left right
+  ASSERT_EQ(root({ 1, 0, 4, 3, 2, 5 }), 3);  // right left
+}
+
+TEST(FlatAVLTreeTest, FindAndRemove) {
+  auto tree = FlatAVLTree<int>::FromList({ 0, 1, 2, 3 });
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(tree.Find(i).has_value());
+    ASSERT_EQ(tree.Value(*tree.Find(i)), i);
+  }
+  ASSERT_FALSE(tree.Find(4).has_value());
+  ASSERT_FALSE(tree.Find(-1).has_value());
+  ASSERT_EQ(tree.Value(*tree.FindMin()), 0);
+
+  ASSERT_EQ(tree.Value(*tree.Root()), 1);
+  ASSERT_TRUE(tree.Remove(3));
+  ASSERT_FALSE(tree.Remove(3));
+  ASSERT_EQ(tree.Height(), 2);
+  ASSERT_TRUE(tree.Remove(1));
+  ASSERT_EQ(tree.Value(*tree.Root()), 2);
+  ASSERT_TRUE(tree.Remove(0));
+  ASSERT_EQ(tree.Height(), 1);
+  ASSERT_TRUE(tree.Remove(2));
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_FALSE(tree.FindMin().has_value());
+
+  // Freed nodes are reused.
+  ASSERT_TRUE(tree.Insert(9));
+  ASSERT_LT(*tree.Root(), 4);
+}
+
+TEST(FlatAVLTreeTest, Traversals) {
+  auto tree = FlatAVLTree<int>::FromList({ 0, 1, 2, 3, 4 });
+  ArrayListAppendFunctor<int> pre;
+  ArrayListAppendFunctor<int> in;
+  ArrayListAppendFunctor<int> post;
+
+  tree.PreorderTraversal(pre);
+  tree.InorderTraversal(in);
+  tree.PostorderTraversal(post);
+  EXPECT_TRUE(pre.vec_.isEqual({ 1, 0, 3, 2, 4 }));
+  EXPECT_TRUE(in.vec_.isEqual({ 0, 1, 2, 3, 4 }));
+  EXPECT_TRUE(post.vec_.isEqual({ 0, 2, 4, 3, 1 }));
+}
+
+TEST(FlatAVLTreeTest, RandomAgainstSet) {
+  FlatAVLTree<uint64_t, uint32_t, true> tree;
+  std::set<uint64_t> expected;
+  uint64_t x = 88172645463325252u;
+
+  for (int i = 0; i < 20000; ++i) {
+    next_random(x);
+    uint64_t value = x % 4096;
+    if (x & (1 << 20)) {
+      ASSERT_EQ(tree.Insert(value), expected.insert(value).second);
+    }
+    else {
+      ASSERT_EQ(tree.Remove(value), expected.erase(value) == 1);
+    }
+  }
+
+  ASSERT_EQ(tree.Size(), expected.size());
+  ASSERT_LE(tree.Height(), 1.45 * std::log2(expected.size() + 2));
+
+  ArrayListAppendFunctor<uint64_t> in;
+  tree.InorderTraversal(in);
+  ASSERT_TRUE(std::equal(in.vec_.begin(), in.vec_.end(), expected.begin(), expected.end()));
+
+  // Every node's parent chain reaches the root, with each step on the
+  // correct side.
+  for (auto value : expected) {
+    auto node = *tree.Find(value);
+    size_t depth = 1;
+    for (auto parent = tree.Parent(node); parent; node = *parent, parent = tree.Parent(node)) {
+      ASSERT_EQ(tree.Value(node) < tree.Value(*parent), value < tree.Value(*parent));
+      ++depth;
+    }
+    ASSERT_EQ(node, *tree.Root());
+    ASSERT_LE(depth, tree.Height());
+  }
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(FlatAVLTreeBenchmark, DISABLED_TenMillionKeys) {
+  constexpr size_t KEYS = 10000000;
+  using Clock = std::chrono::steady_clock;
+
+  ArrayList<uint32_t> keys(KEYS);
+  uint64_t x = 88172645463325252u;
+  for (size_t i = 0; i < KEYS; ++i) {
+    keys.Append(static_cast<uint32_t>(next_random(x)));
+  }
+
+  auto ms = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+
+  size_t found = 0;
+  double insert;
+  double find;
+  {
+    auto start = Clock::now();
+    // Rotations move values rather than nodes, so the root node stays put.
+    auto tree = AVLTree<uint32_t>::NewRoot(uint32_t(keys[0]));
+    for (size_t i = 1; i < KEYS; ++i) {
+      tree->Insert(keys[i]);
+    }
+    insert = ms(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < KEYS; ++i) {
+      found += tree->Find(keys[i]).has_value();
+    }
+    find = ms(start);
+  }
+  std::cout << "AVLTree: insert " << insert << " ms, find " << find << " ms, "
+            << sizeof(AVLTree<uint32_t>) << " bytes a node plus a shared_ptr control block" << std::endl;
+
+  auto start = Clock::now();
+  FlatAVLTree<uint32_t> flat;
+  for (size_t i = 0; i < KEYS; ++i) {
+    flat.Insert(keys[i]);
+  }
+  double flatInsert = ms(start);
+
+  start = Clock::now();
+  size_t flatFound = 0;
+  for (size_t i = 0; i < KEYS; ++i) {
+    flatFound += flat.Find(keys[i]).has_value();
+  }
+  double flatFind = ms(start);
+
+  std::cout << "FlatAVLTree: insert " << flatInsert << " ms (" << insert / flatInsert << "x), find " << flatFind
+            << " ms (" << find / flatFind << "x), " << FlatAVLTree<uint32_t>::NODE_SIZE << " bytes a node" << std::endl;
+
+  ASSERT_EQ(found, KEYS);
+  ASSERT_EQ(flatFound, KEYS);
+}
+
+namespace {
+
+// Whether tree holds exactly expected's entries, in order.
+template <class Tree, class Map>
+bool same_entries(const Tree& tree, const Map& expected) {
+  if (tree.Size() != expected.size()) {
+    return false;
+  }
+
+  auto it = expected.begin();
+  for (auto entry : tree) {
+    if (it == expected.end() || entry.first != it->first || entry.second != it->second) {
+      return false;
+    }
+    ++it;
+  }
+  return it == expected.end();
+}
+
+} // namespace
+
+TEST(BPlusTreeTest, InsertFind) {
+  // Seven keys a node, so a few thousand make a tree several levels deep.
+  using Tree = BPlusTree<int, int, 64>;
+  ASSERT_EQ(Tree::LEAF_KEYS, 7);
+  ASSERT_EQ(Tree::INNER_KEYS, 7);
+
+  Tree tree;
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_EQ(tree.Find(1), nullptr);
+  ASSERT_TRUE(tree.begin() == tree.end());
+
+  std::map<int, int> expected;
+  uint64_t x = 88172645463325252u;
+  for (int i = 0; i < 5000; ++i) {
+    int key = static_cast<int>(next_random(x) % 3000) - 1000;
+    ASSERT_EQ(tree.Insert(key, i), expected.count(key) == 0);
+    expected[key] = i;
+  }
+
+  ASSERT_GE(tree.Depth(), 3);
+  ASSERT_TRUE(same_entries(tree, expected));
+  for (int key = -1100; key < 2100; ++key) {
+    auto found = tree.Find(key);
+    ASSERT_EQ(found != nullptr, expected.count(key) == 1);
+    if (found) {
+      ASSERT_EQ(*found, expected[key]);
+    }
+  }
+
+  *tree.Find(expected.begin()->first) = -1;
+  ASSERT_EQ(tree.begin().Value(), -1);
+
+  // Ascending and descending runs split at the ends of the tree.
+  Tree ascending;
+  Tree descending;
+  for (int i = 0; i < 1000; ++i) {
+    ascending.Insert(i, i);
+    descending.Insert(-i, i);
+  }
+  ASSERT_EQ(ascending.Size(), 1000);
+  ASSERT_EQ(descending.begin().Key(), -999);
+  ASSERT_TRUE(ascending.Contains(999));
+  ASSERT_FALSE(descending.Contains(1));
+}
+
+TEST(BPlusTreeTest, Remove) {
+  BPlusTree<int, int, 64> tree;
+  std::map<int, int> expected;
+  uint64_t x = 2463534242u;
+
+  for (int i = 0; i < 20000; ++i) {
+    int key = static_cast<int>(next_random(x) % 2000);
+    if (next_random(x) % 3) {
+      tree.Insert(key, i);
+      expected[key] = i;
+    }
+    else {
+      ASSERT_EQ(tree.Remove(key), expected.erase(key) == 1);
+      ASSERT_EQ(tree.Find(key), nullptr);
+    }
+  }
+  ASSERT_TRUE(same_entries(tree, expected));
+
+  // Emptying whole leaves leaves gaps in the chain that iteration and the
+  // bounds step over.
+  for (int key = 500; key < 1500; ++key) {
+    tree.Remove(key);
+    expected.erase(key);
+  }
+  ASSERT_TRUE(same_entries(tree, expected));
+  ASSERT_EQ(tree.LowerBound(500).Key(), expected.lower_bound(500)->first);
+  ASSERT_EQ(tree.UpperBound(499).Key(), expected.upper_bound(499)->first);
+
+  for (auto& entry : expected) {
+    ASSERT_TRUE(tree.Remove(entry.first));
+  }
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_TRUE(tree.begin() == tree.end());
+  ASSERT_FALSE(tree.Remove(0));
+
+  ASSERT_TRUE(tree.Insert(7, 1));
+  ASSERT_EQ(*tree.Find(7), 1);
+}
+
+TEST(BPlusTreeTest, Bounds) {
+  BPlusTree<uint32_t, uint32_t, 64> tree;
+  std::map<uint32_t, uint32_t> expected;
+  uint64_t x = 2463534242u;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    uint32_t key = static_cast<uint32_t>(next_random(x) % 100000);
+    tree.Insert(key, i);
+    expected[key] = i;
+  }
+
+  for (int query = 0; query < 2000; ++query) {
+    uint32_t lo = static_cast<uint32_t>(next_random(x) % 101000);
+    uint32_t hi = lo + static_cast<uint32_t>(next_random(x) % 5000);
+
+    auto lower = tree.LowerBound(lo);
+    auto expectedLower = expected.lower_bound(lo);
+    ASSERT_EQ(lower == tree.end(), expectedLower == expected.end());
+    if (expectedLower != expected.end()) {
+      ASSERT_EQ(lower.Key(), expectedLower->first);
+    }
+
+    auto upper = tree.UpperBound(lo);
+    auto expectedUpper = expected.upper_bound(lo);
+    ASSERT_EQ(upper == tree.end(), expectedUpper == expected.end());
+    if (expectedUpper != expected.end()) {
+      ASSERT_EQ(upper.Key(), expectedUpper->first);
+    }
+
+    ArrayList<uint32_t> keys;
+    tree.Range(lo, hi, [&](uint32_t key, uint32_t value) {
+      ASSERT_EQ(value, expected[key]);
+      keys.Append(key);
+    });
+    ASSERT_EQ(keys.Size(), std::distance(expected.lower_bound(lo), expected.lower_bound(hi)));
+    ASSERT_TRUE(std::equal(keys.begin(), keys.end(), expected.lower_bound(lo),
+      [](uint32_t key, const std::pair<const uint32_t, uint32_t>& entry) { return key == entry.first; }));
+  }
+}
+
+TEST(BPlusTreeTest, FromSorted) {
+  ArrayList<std::pair<uint32_t, uint32_t>> entries;
+  uint64_t x = 88172645463325252u;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    entries.Append(std::make_pair(static_cast<uint32_t>(next_random(x)), i));
+  }
+  merge_sort(entries.begin(), entries.end());
+
+  std::map<uint32_t, uint32_t> expected(entries.begin(), entries.end());
+  ASSERT_EQ(expected.size(), entries.Size());
+
+  // Every leaf count from one up to several levels.
+  for (size_t n : { 0, 1, 7, 8, 50, 57, 400, 10000 }) {
+    auto tree = BPlusTree<uint32_t, uint32_t, 64>::FromSorted(entries.begin(), entries.begin() + n);
+    ASSERT_TRUE(same_entries(tree, std::map<uint32_t, uint32_t>(entries.begin(), entries.begin() + n)));
+    for (size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(*tree.Find(entries[i].first), entries[i].second);
+    }
+  }
+
+  // A loaded tree takes inserts like any other.
+  auto tree = BPlusTree<uint32_t, uint32_t, 64>::FromSorted(entries.begin(), entries.end());
+  for (uint32_t i = 0; i < 5000; ++i) {
+    uint32_t key = static_cast<uint32_t>(next_random(x));
+    tree.Insert(key, i);
+    expected[key] = i;
+  }
+  ASSERT_TRUE(same_entries(tree, expected));
+}
+
+TEST(BPlusTreeTest, StringKeys) {
+  BPlusTree<std::string, int> tree;
+  ASSERT_TRUE(tree.Insert("pear", 1));
+  ASSERT_TRUE(tree.Insert("apple", 2));
+  ASSERT_TRUE(tree.Insert("fig", 3));
+  ASSERT_FALSE(tree.Insert("pear", 4));
+
+  ASSERT_EQ(*tree.Find("pear"), 4);
+  ASSERT_EQ(tree.LowerBound("b").Key(), "fig");
+  ASSERT_EQ(tree.UpperBound("fig").Key(), "pear");
+  ASSERT_TRUE(tree.UpperBound("pear") == tree.end());
+
+  ArrayList<std::string> keys;
+  tree.Range("apple", "pear", [&keys](const std::string& key, int) { keys.Append(key); });
+  ASSERT_EQ(keys.Size(), 2);
+  ASSERT_EQ(keys[1], "fig");
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(BPlusTreeBenchmark, DISABLED_LookupAndScan) {
+  constexpr size_t KEYS = 1 << 22;
+  using Clock = std::chrono::steady_clock;
+
+  ArrayList<std::pair<uint32_t, uint32_t>> entries(KEYS);
+  uint64_t x = 88172645463325252u;
+  for (uint32_t i = 0; i < KEYS; ++i) {
+    entries.Append(std::make_pair(static_cast<uint32_t>(next_random(x)), i));
+  }
+  ArrayList<uint32_t> queries(KEYS);
+  for (size_t i = 0; i < KEYS; ++i) {
+    queries.Append(entries[next_random(x) % KEYS].first);
+  }
+
+  auto ms = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  };
+  auto report = [](const char* name, double build, double find, double scan) {
+    std::cout << name << ": build " << build << " ms, " << KEYS << " finds " << find << " ms, full scan "
+              << scan << " ms" << std::endl;
+  };
+
+  uint64_t sum = 0;
+  {
+    auto start = Clock::now();
+    auto tree = AVLTree<uint32_t>::NewRoot(uint32_t(entries[0].first));
+    for (size_t i = 1; i < KEYS; ++i) {
+      tree->Insert(entries[i].first);
+    }
+    double build = ms(start);
+
+    start = Clock::now();
+    size_t found = 0;
+    for (auto key : queries) {
+      found += tree->Find(key).has_value();
+    }
+    double find = ms(start);
+
+    start = Clock::now();
+    auto add = [&sum](uint32_t key) { sum += key; };
+    tree->InorderTraversal(add);
+    report("AVLTree", build, find, ms(start));
+    ASSERT_EQ(found, KEYS);
+  }
+
+  {
+    auto start = Clock::now();
+    FlatAVLTree<uint32_t> tree;
+    for (auto& entry : entries) {
+      tree.Insert(entry.first);
+    }
+    double build = ms(start);
+
+    start = Clock::now();
+    size_t found = 0;
+    for (auto key : queries) {
+      found += tree.Find(key).has_value();
+    }
+    double find = ms(start);
+
+    start = Clock::now();
+    uint64_t flatSum = 0;
+    auto add = [&flatSum](uint32_t key) { flatSum += key; };
+    tree.InorderTraversal(add);
+    report("FlatAVLTree", build, find, ms(start));
+    ASSERT_EQ(found, KEYS);
+    ASSERT_EQ(flatSum, sum);
+  }
+
+  for (bool bulk : { false, true }) {
+    auto start = Clock::now();
+    BPlusTree<uint32_t, uint32_t> tree;
+    if (bulk) {
+      merge_sort(entries.begin(), entries.end());
+      auto last = std::unique(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.first == b.first; });
+      tree = BPlusTree<uint32_t, uint32_t>::FromSorted(entries.begin(), last);
+    }
+    else {
+      for (auto& entry : entries) {
+        tree.Insert(entry.first, entry.second);
+      }
+    }
+    double build = ms(start);
+
+    start = Clock::now();
+    size_t found = 0;
+    for (auto key : queries) {
+      found += tree.Find(key) != nullptr;
+    }
+    double find = ms(start);
+
+    start = Clock::now();
+    uint64_t treeSum = 0;
+    tree.Range(0, std::numeric_limits<uint32_t>::max(), [&treeSum](uint32_t key, uint32_t) { treeSum += key; });
+    report(bulk ? "BPlusTree, merge_sort and FromSorted" : "BPlusTree, inserts", build, find, ms(start));
+    ASSERT_EQ(found, KEYS);
+    ASSERT_EQ(treeSum, sum);
+  }
+}
+
 TEST(Trie, Test) {
   Trie t;
   t.insert("cat");
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "list.h"
+
+namespace ds {
+
+namespace _ {
+
+// The 64-bit bit-scan intrinsics exist only on x64 and ARM64 and __popcnt64
+// only on x64; 32-bit x86 scans and counts the word as two halves.
+
+// Index of the lowest set bit of a non-zero word, by the processor's bit
+// scan.
+inline size_t lowest_bit_(uint64_t word) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanForward(&index, static_cast<unsigned long>(word))) {
+    return index;
+  }
+  _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+  return index + 32;
+#else
+  return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+}
+
+// Index of the highest set bit of a non-zero word, by the processor's bit
+// scan.
+inline size_t highest_bit_(uint64_t word) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanReverse64(&index, word);
+  return index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanReverse(&index, static_cast<unsigned long>(word >> 32))) {
+    return index + 32;
+  }
+  _BitScanReverse(&index, static_cast<unsigned long>(word));
+  return index;
+#else
+  return static_cast<size_t>(63 - __builtin_clzll(word));
+#endif
+}
+
+inline size_t popcount_(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<size_t>(__popcnt64(word));
+#elif defined(_MSC_VER) && defined(_M_IX86)
+  return static_cast<size_t>(__popcnt(static_cast<unsigned int>(word)) +
+                             __popcnt(static_cast<unsigned int>(word >> 32)));
+#elif defined(_MSC_VER)
+  word = word - ((word >> 1) & 0x5555555555555555u);
+  word = (word & 0x3333333333333333u) + ((word >> 2) & 0x3333333333333333u);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fu;
+  return static_cast<size_t>((word * 0x0101010101010101u) >> 56);
+#else
+  return static_cast<size_t>(__builtin_popcountll(word));
+#endif
+}
+
+} // namespace _
+
+// Dense bitset sized at run time, one bit per element in 64-bit words. Bits
+// past Size() in the last word are kept clear so Count and the word-level
+// operations never see them.
+class DynamicBitset {
+public:
+  static constexpr size_t NPOS = std::numeric_limits<size_t>::max();
+  static constexpr size_t WORD_BITS = 64;
+
+  DynamicBitset()
+      : size_(0),
+        words_() {
+
+  }
+
+  DynamicBitset(size_t size, bool value = false)
+      : size_(size),
+        words_(wordCount(size), value ? ~uint64_t(0) : 0) {
+    trim();
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  bool isEmpty() const {
+    return size_ == 0;
+  }
+
+  bool Test(size_t i) const {
+    check_bounds(i, size_);
+    return (word(i / WORD_BITS) >> (i % WORD_BITS)) & 1;
+  }
+
+  bool operator[](size_t i) const {
+    return (word(i / WORD_BITS) >> (i % WORD_BITS)) & 1;
+  }
+
+  void Set(size_t i) {
+    check_bounds(i, size_);
+    words_[i / WORD_BITS] |= uint64_t(1) << (i % WORD_BITS);
+  }
+
+  void Set(size_t i, bool value) {
+    if (value) Set(i); else Reset(i);
+  }
+
+  void Reset(size_t i) {
+    check_bounds(i, size_);
+    words_[i / WORD_BITS] &= ~(uint64_t(1) << (i % WORD_BITS));
+  }
+
+  void Flip(size_t i) {
+    check_bounds(i, size_);
+    words_[i / WORD_BITS] ^= uint64_t(1) << (i % WORD_BITS);
+  }
+
+  // Sets bit i and returns its previous value, for visited checks.
+  bool TestAndSet(size_t i) {
+    check_bounds(i, size_);
+    uint64_t mask = uint64_t(1) << (i % WORD_BITS);
+    uint64_t& w = words_[i / WORD_BITS];
+    bool wasSet = (w & mask) != 0;
+    w |= mask;
+    return wasSet;
+  }
+
+  void SetAll() {
+    std::fill(words_.begin(), words_.end(), ~uint64_t(0));
+    trim();
+  }
+
+  void ResetAll() {
+    std::fill(words_.begin(), words_.end(), uint64_t(0));
+  }
+
+  size_t Count() const {
+    size_t count = 0;
+    for (auto w : words_) {
+      count += _::popcount_(w);
+    }
+    return count;
+  }
+
+  bool Any() const {
+    return std::any_of(words_.begin(), words_.end(), [](uint64_t w) { return w != 0; });
+  }
+
+  bool None() const {
+    return !Any();
+  }
+
+  // The first set bit, or NPOS.
+  size_t FindFirst() const {
+    return findFrom(0, ~uint64_t(0));
+  }
+
+  // The first set bit after i, or NPOS.
+  size_t FindNext(size_t i) const {
+    size_t next = i + 1;
+    if (next >= size_) {
+      return NPOS;
+    }
+    return findFrom(next / WORD_BITS, ~uint64_t(0) << (next % WORD_BITS));
+  }
+
+  // Grows or shrinks to size; new bits take value.
+  void Resize(size_t size, bool value = false) {
+    size_t oldSize = size_;
+    size_t words = wordCount(size);
+
+    if (value && oldSize % WORD_BITS) {
+      words_[oldSize / WORD_BITS] |= ~uint64_t(0) << (oldSize % WORD_BITS);
+    }
+    words_.Reserve(words);
+    while (words_.Size() < words) {
+      words_.Append(value ? ~uint64_t(0) : uint64_t(0));
+    }
+    while (words_.Size() > words) {
+      words_.Remove(words_.Size() - 1);
+    }
+
+    size_ = size;
+    trim();
+  }
+
+  // Word-level operations. Both sets must be the same size.
+  DynamicBitset& operator&=(const DynamicBitset& other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.Size(); ++w) {
+      words_[w] &= other.word(w);
+    }
+    return *this;
+  }
+
+  DynamicBitset& operator|=(const DynamicBitset& other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.Size(); ++w) {
+      words_[w] |= other.word(w);
+    }
+    return *this;
+  }
+
+  DynamicBitset& operator^=(const DynamicBitset& other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.Size(); ++w) {
+      words_[w] ^= other.word(w);
+    }
+    return *this;
+  }
+
+  // Clears every bit that is set in other.
+  DynamicBitset& Subtract(const DynamicBitset& other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.Size(); ++w) {
+      words_[w] &= ~other.word(w);
+    }
+    return *this;
+  }
+
+  bool operator==(const DynamicBitset& other) const {
+    return size_ == other.size_ && words_.isEqual(other.words_);
+  }
+
+  bool operator!=(const DynamicBitset& other) const {
+    return !(*this == other);
+  }
+
+  // The raw words, lowest bits first.
+  size_t WordCount() const {
+    return words_.Size();
+  }
+
+  uint64_t Word(size_t w) const {
+    check_bounds(w, words_.Size());
+    return word(w);
+  }
+
+  // Calls f(i) for each set bit in ascending order.
+  template <class Func>
+  void ForEachSet(Func&& f) const {
+    for (size_t w = 0; w < words_.Size(); ++w) {
+      for (uint64_t bits = word(w); bits; bits &= bits - 1) {
+        f(w * WORD_BITS + _::lowest_bit_(bits));
+      }
+    }
+  }
+
+private:
+  size_t size_;
+  ArrayList<uint64_t> words_;
+
+  static size_t wordCount(size_t size) {
+    return (size + WORD_BITS - 1) / WORD_BITS;
+  }
+
+  uint64_t word(size_t w) const {
+    return words_.begin()[w];
+  }
+
+  void trim() {
+    if (size_ % WORD_BITS) {
+      words_[words_.Size() - 1] &= ~(~uint64_t(0) << (size_ % WORD_BITS));
+    }
+  }
+
+  size_t findFrom(size_t w, uint64_t mask) const {
+    for (; w < words_.Size(); ++w) {
+      uint64_t bits = word(w) & mask;
+      if (bits) {
+        return w * WORD_BITS + _::lowest_bit_(bits);
+      }
+      mask = ~uint64_t(0);
+    }
+    return NPOS;
+  }
+};
+
+} // namespace ds
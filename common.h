@@ -1,9 +1,24 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ds {
 
 constexpr size_t abs_diff(size_t a, size_t b) {
   return (a < b) ? b - a : a - b;
 }
 
-} // namespace ds
\ No newline at end of file
+namespace _ {
+
+// Marsaglia's xorshift64: advances state, which must be nonzero, and returns
+// it. Cheap enough for sampling and shard picking on hot paths.
+inline uint64_t xorshift_(uint64_t& state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+} // namespace _
+
+} // namespace ds
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+// Comparators shared by sort.h and heap.h. A comparator op(a, b) is a strict
+// weak ordering that is true when a belongs before b.
+
+namespace ds {
+
+namespace _ {
+
+// Both comparators are strict weak orderings: equal values compare false
+// either way round, which merge_sort relies on for stability.
+template <class T = void>
+struct ascending_ {
+  constexpr bool operator()(const T& lhs, const T& rhs) const {
+    return lhs < rhs;
+  }
+};
+
+template <>
+struct ascending_<void> {
+  template <class L, class R>
+  constexpr bool operator()(const L& lhs, const R& rhs) const {
+    return lhs < rhs;
+  }
+};
+
+template <class T = void>
+struct descending_ {
+  constexpr bool operator()(const T& lhs, const T& rhs) const {
+    return rhs < lhs;
+  }
+};
+
+template <>
+struct descending_<void> {
+  template <class L, class R>
+  constexpr bool operator()(const L& lhs, const R& rhs) const {
+    return rhs < lhs;
+  }
+};
+
+// Orders values by a projection of them: a pointer to a data member, a
+// pointer to a const member function, or any callable taking the value.
+template <class Proj, class Func>
+struct by_key_ {
+  Proj proj_;
+  Func op_;
+
+  template <class L, class R>
+  constexpr bool operator()(const L& lhs, const R& rhs) const {
+    return op_(std::invoke(proj_, lhs), std::invoke(proj_, rhs));
+  }
+};
+
+// Comparators whose result can be computed for arithmetic values without a
+// branch. Sorts over arithmetic values pick compare-and-swap and merge steps
+// that select with conditional moves instead of jumps for these.
+template <class Func>
+struct is_branchless_ : std::false_type {};
+
+template <class T>
+struct is_branchless_<ascending_<T>> : std::true_type {};
+
+template <class T>
+struct is_branchless_<descending_<T>> : std::true_type {};
+
+} // namespace _
+
+static auto ascending = _::ascending_<>{};
+static auto descending = _::descending_<>{};
+
+// by_key(&Record::field) orders records by field; by_key(proj, descending)
+// reverses it.
+template <class Proj, class Func = _::ascending_<>>
+constexpr auto by_key(Proj proj, Func op = Func{}) {
+  return _::by_key_<Proj, Func>{ proj, op };
+}
+
+} // namespace ds
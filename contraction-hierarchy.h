@@ -0,0 +1,724 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include "bitset.h"
+#include "graph.h"
+#include "heap.h"
+#include "list.h"
+
+namespace ds {
+
+namespace _ {
+
+// Contracts the nodes of a graph one at a time, least important first. Taking
+// v out adds a shortcut u -> w for each pair of neighbours whose shortest path
+// ran through v, unless a bounded witness search finds another path at most
+// as short. What is left of v's edges when it goes are exactly its edges to
+// more important nodes, so they become its arcs in the hierarchy.
+template <class Index>
+class ch_builder_ {
+public:
+  static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+  struct arc_ {
+    Index node_;
+    Index middle_;
+    double weight_;
+  };
+
+  template <class Graph>
+  ch_builder_(const Graph& graph, size_t witness_limit)
+      : out_(graph.NodeCount(), ArrayList<arc_>()),
+        in_(graph.NodeCount(), ArrayList<arc_>()),
+        order_(graph.NodeCount(), NONE),
+        level_(graph.NodeCount(), 0),
+        distance_(graph.NodeCount(), std::numeric_limits<double>::max()),
+        touched_(),
+        queue_(graph.NodeCount()),
+        witness_limit_(witness_limit),
+        target_(graph.NodeCount(), 0),
+        stamp_(0) {
+    assert(graph.NodeCount() < NONE);
+
+    for (size_t n = 0; n < graph.NodeCount(); ++n) {
+      graph.ForEachEdge(n, [this, n](size_t dest, double weight) {
+        if (dest != n) {
+          addArc(n, dest, weight, NONE);
+        }
+      });
+    }
+  }
+
+  // Contracts every node. order()[n] is then n's rank, and out(n) and in(n)
+  // its upward arcs: edges n -> w and u -> n to higher-ranked nodes.
+  void Run() {
+    size_t count = order_.Size();
+    IndexedHeap<double, MinHeap> pending(count);
+
+    for (size_t n = 0; n < count; ++n) {
+      pending.Insert(n, priority(n));
+    }
+
+    for (size_t rank = 0; !pending.isEmpty(); ) {
+      size_t v = pending.Pop().first;
+
+      // Priorities go stale as neighbours are contracted. Rechecking only the
+      // node about to go, rather than every neighbour after each contraction,
+      // builds about twice as fast for a hierarchy nearly as good.
+      double p = priority(v);
+      if (!pending.isEmpty() && p > pending.Peek().second) {
+        pending.Insert(v, p);
+        continue;
+      }
+
+      contract(v, false);
+      order_[v] = static_cast<Index>(rank++);
+
+      for (auto& arc : out_[v]) {
+        detach(in_[arc.node_], v);
+        level_[arc.node_] = std::max(level_[arc.node_], level_[v] + 1);
+      }
+      for (auto& arc : in_[v]) {
+        detach(out_[arc.node_], v);
+        level_[arc.node_] = std::max(level_[arc.node_], level_[v] + 1);
+      }
+    }
+  }
+
+  const ArrayList<Index>& order() const {
+    return order_;
+  }
+
+  const ArrayList<arc_>& out(size_t node) const {
+    return out_.begin()[node];
+  }
+
+  const ArrayList<arc_>& in(size_t node) const {
+    return in_.begin()[node];
+  }
+
+private:
+  ArrayList<ArrayList<arc_>> out_;
+  ArrayList<ArrayList<arc_>> in_;
+  ArrayList<Index> order_;
+  ArrayList<uint32_t> level_;
+
+  // Witness search scratch, reset through touched_ after each search.
+  ArrayList<double> distance_;
+  ArrayList<Index> touched_;
+  IndexedHeap<double, MinHeap> queue_;
+  size_t witness_limit_;
+
+  // target_[n] == stamp_ marks the out-neighbours of the node being
+  // contracted, so a witness search can stop once it has settled them all.
+  ArrayList<uint32_t> target_;
+  uint32_t stamp_;
+
+  // Keeps the lighter of parallel edges.
+  void addArc(size_t src, size_t dest, double weight, Index middle) {
+    for (auto& arc : out_[src]) {
+      if (arc.node_ == dest) {
+        if (weight < arc.weight_) {
+          arc.weight_ = weight;
+          arc.middle_ = middle;
+          for (auto& back : in_[dest]) {
+            if (back.node_ == src) {
+              back.weight_ = weight;
+              back.middle_ = middle;
+            }
+          }
+        }
+        return;
+      }
+    }
+
+    out_[src].Append(arc_{ static_cast<Index>(dest), middle, weight });
+    in_[dest].Append(arc_{ static_cast<Index>(src), middle, weight });
+  }
+
+  static void detach(ArrayList<arc_>& arcs, size_t node) {
+    for (size_t i = 0; i < arcs.Size(); ++i) {
+      if (arcs[i].node_ == node) {
+        arcs[i] = arcs[arcs.Size() - 1];
+        arcs.Pop();
+        return;
+      }
+    }
+  }
+
+  // Edge difference plus level. Fewer shortcuts than removed edges keeps the
+  // hierarchy sparse; the level, one above the highest contracted
+  // neighbour, spreads contraction evenly over the graph and keeps it
+  // shallow.
+  double priority(size_t v) {
+    double added = static_cast<double>(contract(v, true));
+    double removed = static_cast<double>(out_[v].Size() + in_[v].Size());
+    return added - removed + level_[v];
+  }
+
+  // Returns the number of shortcuts contracting v needs, adding them unless
+  // simulate is set. Simulations, run only to rank nodes, use far shorter
+  // witness searches; overcounting a few shortcuts barely changes the order.
+  size_t contract(size_t v, bool simulate) {
+    double longestOut = 0;
+    for (auto& arc : out_[v]) {
+      longestOut = std::max(longestOut, arc.weight_);
+    }
+
+    size_t shortcuts = 0;
+    if (++stamp_ == 0) {
+      std::fill(target_.begin(), target_.end(), 0);
+      stamp_ = 1;
+    }
+    for (auto& arc : out_[v]) {
+      target_[arc.node_] = stamp_;
+    }
+
+    // Shortcuts never touch v's own lists, so indices stay valid.
+    for (size_t i = 0; i < in_[v].Size(); ++i) {
+      arc_ from = in_[v][i];
+      size_t targets = out_[v].Size() - (target_[from.node_] == stamp_);
+      witness(from.node_, v, from.weight_ + longestOut, targets, simulate ? witness_limit_ / 25 : witness_limit_);
+
+      for (size_t j = 0; j < out_[v].Size(); ++j) {
+        arc_ to = out_[v][j];
+        double via = from.weight_ + to.weight_;
+
+        if (to.node_ != from.node_ && distance_[to.node_] > via) {
+          ++shortcuts;
+          if (!simulate) {
+            addArc(from.node_, to.node_, via, static_cast<Index>(v));
+          }
+        }
+      }
+
+      for (auto n : touched_) {
+        distance_[n] = std::numeric_limits<double>::max();
+      }
+      touched_.Clear();
+      while (!queue_.isEmpty()) {
+        queue_.Pop();
+      }
+    }
+
+    return shortcuts;
+  }
+
+  // Dijkstra from source around skip, until it passes limit, settles every
+  // one of targets nodes marked in target_, or settles settle_limit nodes.
+  // distance_ holds the lengths of paths found, which may not be the
+  // shortest once the search is cut off but are still real paths.
+  void witness(size_t source, size_t skip, double limit, size_t targets, size_t settle_limit) {
+    distance_[source] = 0;
+    touched_.Append(static_cast<Index>(source));
+    queue_.Insert(source, 0);
+
+    for (size_t settled = 0; !queue_.isEmpty() && settled < settle_limit && targets > 0; ++settled) {
+      auto top = queue_.Pop();
+      if (top.second > limit) {
+        break;
+      }
+      if (target_[top.first] == stamp_ && top.first != source) {
+        --targets;
+      }
+
+      for (auto& arc : out_[top.first]) {
+        double d = top.second + arc.weight_;
+
+        if (arc.node_ != skip && d < distance_[arc.node_]) {
+          if (distance_[arc.node_] == std::numeric_limits<double>::max()) {
+            touched_.Append(arc.node_);
+          }
+          distance_[arc.node_] = d;
+
+          if (queue_.Contains(arc.node_)) {
+            queue_.DecreaseKey(arc.node_, d);
+          }
+          else {
+            queue_.Insert(arc.node_, d);
+          }
+        }
+      }
+    }
+  }
+};
+
+} // namespace _
+
+// Contraction hierarchy over a static weighted graph, for point-to-point
+// queries many orders of magnitude faster than Dikstras. Building it orders
+// the nodes and adds shortcut edges so that every shortest path climbs to a
+// most important node and then descends; a query is then a pair of small
+// upward searches. Nodes are stored in rank order to keep those searches
+// local in memory. Weights must be non-negative.
+template <class Index = size_t>
+class ContractionHierarchy {
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
+
+public:
+  static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+  // An upward arc. middle_ is the node a shortcut bypasses, or NONE for an
+  // edge of the original graph.
+  struct Arc {
+    Index target_;
+    Index middle_;
+    double weight_;
+  };
+
+  class Query;
+
+  ContractionHierarchy()
+      : rank_(),
+        node_(),
+        forward_offsets_(size_t(1), size_t(0)),
+        forward_(),
+        backward_offsets_(size_t(1), size_t(0)),
+        backward_() {
+
+  }
+
+  // Preprocesses graph, anything with NodeCount() and ForEachEdge like
+  // AdjacencyListGraph. witness_limit caps the nodes each witness search
+  // settles: lower builds faster but adds more unneeded shortcuts.
+  template <class Graph>
+  explicit ContractionHierarchy(const Graph& graph, size_t witness_limit = 500)
+      : ContractionHierarchy() {
+    _::ch_builder_<Index> builder(graph, witness_limit);
+    builder.Run();
+
+    size_t count = graph.NodeCount();
+    rank_ = builder.order();
+    node_ = ArrayList<Index>(count, 0);
+    for (size_t n = 0; n < count; ++n) {
+      node_[rank_[n]] = static_cast<Index>(n);
+    }
+
+    auto flatten = [&](ArrayList<size_t>& offsets, ArrayList<Arc>& arcs, auto&& upward) {
+      offsets = ArrayList<size_t>(count + 1, 0);
+      for (size_t r = 0; r < count; ++r) {
+        offsets[r + 1] = offsets[r] + upward(node_[r]).Size();
+      }
+
+      arcs = ArrayList<Arc>(offsets[count], Arc{});
+      for (size_t r = 0, slot = 0; r < count; ++r) {
+        for (auto& arc : upward(node_[r])) {
+          Index middle = arc.middle_ == NONE ? NONE : rank_[arc.middle_];
+          arcs[slot++] = Arc{ rank_[arc.node_], middle, arc.weight_ };
+        }
+      }
+    };
+
+    flatten(forward_offsets_, forward_, [&builder](size_t n) -> auto& { return builder.out(n); });
+    flatten(backward_offsets_, backward_, [&builder](size_t n) -> auto& { return builder.in(n); });
+  }
+
+  size_t NodeCount() const {
+    return node_.Size();
+  }
+
+  // Upward arcs in both directions, original edges and shortcuts.
+  size_t ArcCount() const {
+    return forward_.Size() + backward_.Size();
+  }
+
+  size_t ShortcutCount() const {
+    size_t count = 0;
+    for (auto& arc : forward_) count += arc.middle_ != NONE;
+    for (auto& arc : backward_) count += arc.middle_ != NONE;
+    return count;
+  }
+
+  // The node's position in the contraction order; higher is more important.
+  size_t Rank(size_t node) const {
+    check_bounds(node, NodeCount());
+    return rank_[node];
+  }
+
+  // Writes the hierarchy in a binary format Load reads back on a machine of
+  // the same endianness. Returns false if the file cannot be written.
+  bool Save(const std::filesystem::path& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+      return false;
+    }
+
+    header_ header{};
+    std::memcpy(header.magic_, MAGIC, sizeof(header.magic_));
+    header.version_ = VERSION;
+    header.index_bytes_ = sizeof(Index);
+    header.nodes_ = node_.Size();
+    header.forward_ = forward_.Size();
+    header.backward_ = backward_.Size();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(out, node_);
+    write(out, forward_offsets_);
+    write(out, forward_);
+    write(out, backward_offsets_);
+    write(out, backward_);
+
+    return static_cast<bool>(out.flush());
+  }
+
+  // Replaces this hierarchy with one written by Save. Returns false, leaving
+  // it unchanged, if the file is missing, truncated or was saved with a
+  // different Index.
+  bool Load(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+      return false;
+    }
+
+    header_ header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (in.gcount() != sizeof(header) ||
+        std::memcmp(header.magic_, MAGIC, sizeof(header.magic_)) != 0 ||
+        header.version_ != VERSION ||
+        header.index_bytes_ != sizeof(Index) ||
+        header.nodes_ >= NONE) {
+      return false;
+    }
+
+    // Every section must fit in the rest of the file, checked before any
+    // array is sized from the header's counts.
+    std::error_code ec;
+    uint64_t remaining = std::filesystem::file_size(path, ec);
+    if (ec) {
+      return false;
+    }
+    remaining -= sizeof(header);
+
+    auto take = [&remaining](uint64_t count, uint64_t bytes) {
+      if (count > remaining / bytes) {
+        return false;
+      }
+      remaining -= count * bytes;
+      return true;
+    };
+    if (!take(header.nodes_, sizeof(Index)) ||
+        !take(header.nodes_ + 1, sizeof(size_t)) || !take(header.forward_, sizeof(Arc)) ||
+        !take(header.nodes_ + 1, sizeof(size_t)) || !take(header.backward_, sizeof(Arc))) {
+      return false;
+    }
+
+    size_t count = static_cast<size_t>(header.nodes_);
+    ArrayList<Index> node(count, 0);
+    ArrayList<size_t> forwardOffsets(count + 1, 0);
+    ArrayList<Arc> forward(static_cast<size_t>(header.forward_), Arc{});
+    ArrayList<size_t> backwardOffsets(count + 1, 0);
+    ArrayList<Arc> backward(static_cast<size_t>(header.backward_), Arc{});
+
+    if (!read(in, node) || !read(in, forwardOffsets) || !read(in, forward) ||
+        !read(in, backwardOffsets) || !read(in, backward) ||
+        !valid(count, forwardOffsets, forward) || !valid(count, backwardOffsets, backward)) {
+      return false;
+    }
+
+    ArrayList<Index> rank(count, NONE);
+    for (size_t r = 0; r < count; ++r) {
+      if (node[r] >= count || rank[node[r]] != NONE) {
+        return false;
+      }
+      rank[node[r]] = static_cast<Index>(r);
+    }
+
+    rank_ = std::move(rank);
+    node_ = std::move(node);
+    forward_offsets_ = std::move(forwardOffsets);
+    forward_ = std::move(forward);
+    backward_offsets_ = std::move(backwardOffsets);
+    backward_ = std::move(backward);
+    return true;
+  }
+
+private:
+  static constexpr char MAGIC[4] = { 'D', 'S', 'C', 'H' };
+  static constexpr uint32_t VERSION = 1;
+
+  struct header_ {
+    char magic_[4];
+    uint32_t version_;
+    uint64_t index_bytes_;
+    uint64_t nodes_;
+    uint64_t forward_;
+    uint64_t backward_;
+  };
+
+  // Original node id to rank, and back.
+  ArrayList<Index> rank_;
+  ArrayList<Index> node_;
+
+  // Indexed by rank: arcs r -> w with rank w > r, and arcs u -> r stored at r
+  // as target u, with rank u > r.
+  ArrayList<size_t> forward_offsets_;
+  ArrayList<Arc> forward_;
+  ArrayList<size_t> backward_offsets_;
+  ArrayList<Arc> backward_;
+
+  template <class U>
+  static void write(std::ostream& out, const ArrayList<U>& list) {
+    out.write(reinterpret_cast<const char*>(list.begin()), list.Size() * sizeof(U));
+  }
+
+  template <class U>
+  static bool read(std::istream& in, ArrayList<U>& list) {
+    auto bytes = static_cast<std::streamsize>(list.Size() * sizeof(U));
+    in.read(reinterpret_cast<char*>(list.begin()), bytes);
+    return in.gcount() == bytes;
+  }
+
+  static bool valid(size_t count, const ArrayList<size_t>& offsets, const ArrayList<Arc>& arcs) {
+    const size_t* o = offsets.begin();
+    if (o[0] != 0 || o[count] != arcs.Size()) {
+      return false;
+    }
+    for (size_t r = 0; r < count; ++r) {
+      if (o[r] > o[r + 1]) {
+        return false;
+      }
+    }
+    for (auto& arc : arcs) {
+      if (arc.target_ >= count || (arc.middle_ != NONE && arc.middle_ >= count)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The bypassed node of the arc from -> to, both ranks; an original edge
+  // gives NONE.
+  Index middleOf(size_t from, size_t to) const {
+    bool up = from < to;
+    size_t at = up ? from : to;
+    size_t other = up ? to : from;
+    const ArrayList<size_t>& offsets = up ? forward_offsets_ : backward_offsets_;
+    const Arc* arcs = up ? forward_.begin() : backward_.begin();
+
+    for (size_t e = offsets.begin()[at], end = offsets.begin()[at + 1]; e < end; ++e) {
+      if (arcs[e].target_ == other) {
+        return arcs[e].middle_;
+      }
+    }
+
+    assert(false);
+    return NONE;
+  }
+
+  // Expands the arc from -> to into original nodes, appending all but from.
+  void unpack(size_t from, size_t to, ArrayList<size_t>& path, ArrayList<std::pair<Index, Index>>& stack) const {
+    stack.Append(std::make_pair(static_cast<Index>(from), static_cast<Index>(to)));
+
+    while (!stack.isEmpty()) {
+      auto leg = stack.Pop();
+      Index middle = middleOf(leg.first, leg.second);
+
+      if (middle == NONE) {
+        path.Append(static_cast<size_t>(node_[leg.second]));
+      }
+      else {
+        stack.Append(std::make_pair(middle, leg.second));
+        stack.Append(std::make_pair(leg.first, middle));
+      }
+    }
+  }
+};
+
+// Query engine over a ContractionHierarchy. Its scratch arrays are sized to
+// the graph once and reset through touched lists, so a query costs only the
+// nodes it visits; they grow again if Load gives the hierarchy more nodes.
+// Not thread-safe; use one per thread.
+template <class Index>
+class ContractionHierarchy<Index>::Query {
+public:
+  explicit Query(const ContractionHierarchy& hierarchy)
+      : hierarchy_(hierarchy),
+        forward_(hierarchy.NodeCount()),
+        backward_(hierarchy.NodeCount()),
+        stack_() {
+
+  }
+
+  // The shortest distance from start to end, or max() if end is unreachable.
+  double Distance(size_t start, size_t end) {
+    double distance = search(start, end).first;
+    reset();
+    return distance;
+  }
+
+  // The (path, distance) pair Dikstras would return.
+  std::pair<ArrayList<size_t>, double> ShortestPath(size_t start, size_t end) {
+    auto found = search(start, end);
+    ArrayList<size_t> path;
+
+    if (found.second == NONE || start == end) {
+      reset();
+      return std::make_pair(std::move(path), found.first);
+    }
+
+    // Ranks from start up to the meeting node, then down the backward tree.
+    ArrayList<Index> up;
+    for (size_t r = found.second; ; r = forward_.parent_[r]) {
+      up.Append(static_cast<Index>(r));
+      if (forward_.parent_[r] == r) {
+        break;
+      }
+    }
+    std::reverse(up.begin(), up.end());
+
+    path.Append(start);
+    for (size_t i = 1; i < up.Size(); ++i) {
+      hierarchy_.unpack(up[i - 1], up[i], path, stack_);
+    }
+    for (size_t r = found.second; r != backward_.parent_[r]; r = backward_.parent_[r]) {
+      hierarchy_.unpack(r, backward_.parent_[r], path, stack_);
+    }
+
+    reset();
+    return std::make_pair(std::move(path), found.first);
+  }
+
+private:
+  // One direction of the search, over ranks.
+  struct side_ {
+    IndexedHeap<double, MinHeap> queue_;
+    ArrayList<double> distance_;
+    ArrayList<Index> parent_;
+    ArrayList<Index> touched_;
+
+    side_(size_t count)
+        : queue_(count),
+          distance_(count, std::numeric_limits<double>::max()),
+          parent_(count, NONE),
+          touched_() {
+
+    }
+
+    void Reach(size_t node, double distance, size_t parent) {
+      if (distance_[node] == std::numeric_limits<double>::max()) {
+        touched_.Append(static_cast<Index>(node));
+        queue_.Insert(node, distance);
+      }
+      else {
+        queue_.DecreaseKey(node, distance);
+      }
+      distance_[node] = distance;
+      parent_[node] = static_cast<Index>(parent);
+    }
+
+    // Makes room for count ranks. Only called between queries, when
+    // everything is clear, so the arrays are simply replaced.
+    void Grow(size_t count) {
+      if (distance_.Size() < count) {
+        queue_ = IndexedHeap<double, MinHeap>(count);
+        distance_ = ArrayList<double>(count, std::numeric_limits<double>::max());
+        parent_ = ArrayList<Index>(count, NONE);
+      }
+    }
+
+    void Reset() {
+      for (auto n : touched_) {
+        distance_[n] = std::numeric_limits<double>::max();
+        parent_[n] = NONE;
+      }
+      touched_.Clear();
+      while (!queue_.isEmpty()) {
+        queue_.Pop();
+      }
+    }
+  };
+
+  const ContractionHierarchy& hierarchy_;
+  side_ forward_;
+  side_ backward_;
+  ArrayList<std::pair<Index, Index>> stack_;
+
+  void reset() {
+    forward_.Reset();
+    backward_.Reset();
+  }
+
+  // Runs both upward searches and returns the distance and the rank where
+  // they meet, or NONE. Leaves the search state for ShortestPath to read.
+  std::pair<double, size_t> search(size_t start, size_t end) {
+    constexpr double INF = std::numeric_limits<double>::max();
+    check_bounds(start, hierarchy_.NodeCount());
+    check_bounds(end, hierarchy_.NodeCount());
+    forward_.Grow(hierarchy_.NodeCount());
+    backward_.Grow(hierarchy_.NodeCount());
+
+    if (start == end) {
+      return { 0, NONE };
+    }
+
+    const ContractionHierarchy& h = hierarchy_;
+    size_t s = h.rank_.begin()[start];
+    size_t t = h.rank_.begin()[end];
+    forward_.Reach(s, 0, s);
+    backward_.Reach(t, 0, t);
+
+    double best = INF;
+    size_t meet = NONE;
+
+    // Settles the next node of one side. A node is stalled, its arcs not
+    // relaxed, when a higher node of the same search already reaches it more
+    // cheaply through an arc of the opposite direction.
+    auto step = [&](side_& side, side_& other, const ArrayList<size_t>& offsets, const ArrayList<Arc>& arcs,
+                    const ArrayList<size_t>& stallOffsets, const ArrayList<Arc>& stallArcs) {
+      auto top = side.queue_.Pop();
+      size_t n = top.first;
+      double d = top.second;
+
+      if (other.distance_[n] < INF && d + other.distance_[n] < best) {
+        best = d + other.distance_[n];
+        meet = n;
+      }
+
+      const size_t* so = stallOffsets.begin();
+      for (size_t e = so[n]; e < so[n + 1]; ++e) {
+        const Arc& arc = stallArcs.begin()[e];
+        if (side.distance_[arc.target_] < INF && side.distance_[arc.target_] + arc.weight_ < d) {
+          return;
+        }
+      }
+
+      const size_t* o = offsets.begin();
+      for (size_t e = o[n]; e < o[n + 1]; ++e) {
+        const Arc& arc = arcs.begin()[e];
+        double next = d + arc.weight_;
+        if (next < side.distance_[arc.target_]) {
+          side.Reach(arc.target_, next, n);
+        }
+      }
+    };
+
+    bool forwardDone = false;
+    bool backwardDone = false;
+
+    while (!forwardDone || !backwardDone) {
+      forwardDone = forwardDone || forward_.queue_.isEmpty() || forward_.queue_.Peek().second >= best;
+      backwardDone = backwardDone || backward_.queue_.isEmpty() || backward_.queue_.Peek().second >= best;
+
+      if (!forwardDone) {
+        step(forward_, backward_, h.forward_offsets_, h.forward_, h.backward_offsets_, h.backward_);
+      }
+      if (!backwardDone) {
+        step(backward_, forward_, h.backward_offsets_, h.backward_, h.forward_offsets_, h.forward_);
+      }
+    }
+
+    if (meet == NONE) {
+      reset();
+      return { INF, NONE };
+    }
+
+    return { best, meet };
+  }
+};
+
+} // namespace ds
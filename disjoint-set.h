@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+#include "list.h"
+
+namespace ds {
+
+// Union-find over the elements 0 to Size() - 1, in two flat arrays of Index.
+// Union by size keeps the trees shallow and Find halves the path it walks,
+// so any sequence of operations runs in near-constant amortized time each.
+template <class Index = size_t>
+class DisjointSet {
+  static_assert(std::is_unsigned<Index>::value, "element indices must be unsigned");
+
+public:
+  DisjointSet(size_t count = 0)
+      : parent_(count, 0),
+        size_(count, 1),
+        sets_(count) {
+    assert(count <= std::numeric_limits<Index>::max());
+    std::iota(parent_.begin(), parent_.end(), Index(0));
+  }
+
+  size_t Size() const {
+    return parent_.Size();
+  }
+
+  // Number of disjoint sets.
+  size_t SetCount() const {
+    return sets_;
+  }
+
+  // Adds a new element in a set of its own and returns it.
+  size_t Add() {
+    assert(parent_.Size() < std::numeric_limits<Index>::max());
+    parent_.Append(static_cast<Index>(parent_.Size()));
+    size_.Append(1);
+    ++sets_;
+    return parent_.Size() - 1;
+  }
+
+  // The representative of i's set.
+  size_t Find(size_t i) {
+    check_bounds(i, Size());
+    Index* parent = parent_.begin();
+
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  // Merges the sets of a and b. Returns false if they were already one.
+  bool Union(size_t a, size_t b) {
+    a = Find(a);
+    b = Find(b);
+    if (a == b) {
+      return false;
+    }
+
+    if (size_[a] < size_[b]) {
+      std::swap(a, b);
+    }
+    parent_[b] = static_cast<Index>(a);
+    size_[a] += size_[b];
+    --sets_;
+    return true;
+  }
+
+  bool isConnected(size_t a, size_t b) {
+    return Find(a) == Find(b);
+  }
+
+  // Number of elements in i's set.
+  size_t SetSize(size_t i) {
+    return size_[Find(i)];
+  }
+
+private:
+  ArrayList<Index> parent_;
+  ArrayList<Index> size_;
+  size_t sets_;
+};
+
+// Lock-free union-find that any number of threads may use at once. Roots
+// are linked by compare-and-swap, always the larger index under the smaller,
+// so no cycle can form however unions interleave, and Find halves paths with
+// CAS too, which only ever moves an element closer to its root. Linking by
+// index instead of size keeps a union to one CAS; trees stay shallow enough
+// in practice, especially once Find has compressed them.
+class ConcurrentDisjointSet {
+public:
+  ConcurrentDisjointSet(size_t count)
+      : count_(count),
+        parent_(std::make_unique<std::atomic<size_t>[]>(count)) {
+    for (size_t i = 0; i < count; ++i) {
+      parent_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ConcurrentDisjointSet(const ConcurrentDisjointSet& other) = delete;
+  ConcurrentDisjointSet& operator=(const ConcurrentDisjointSet& other) = delete;
+
+  size_t Size() const {
+    return count_;
+  }
+
+  // The representative of i's set at some moment during the call.
+  size_t Find(size_t i) {
+    check_bounds(i, count_);
+
+    while (true) {
+      size_t p = parent_[i].load(std::memory_order_acquire);
+      if (p == i) {
+        return i;
+      }
+
+      size_t grand = parent_[p].load(std::memory_order_acquire);
+      if (p != grand) {
+        parent_[i].compare_exchange_weak(p, grand, std::memory_order_acq_rel, std::memory_order_relaxed);
+      }
+      i = grand;
+    }
+  }
+
+  // Merges the sets of a and b. Returns true for exactly one of several
+  // threads racing to join the same two sets.
+  bool Union(size_t a, size_t b) {
+    while (true) {
+      a = Find(a);
+      b = Find(b);
+      if (a == b) {
+        return false;
+      }
+      if (a < b) {
+        std::swap(a, b);
+      }
+
+      size_t expected = a;
+      if (parent_[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+  // Whether a and b were in one set at some moment during the call; a true
+  // answer stays true.
+  bool isConnected(size_t a, size_t b) {
+    while (true) {
+      a = Find(a);
+      b = Find(b);
+      if (a == b) {
+        return true;
+      }
+      if (parent_[a].load(std::memory_order_acquire) == a) {
+        return false;
+      }
+    }
+  }
+
+private:
+  size_t count_;
+  std::unique_ptr<std::atomic<size_t>[]> parent_;
+};
+
+} // namespace ds
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "list.h"
+#include "heap.h"
+#include "sort.h"
+
+namespace ds {
+
+struct ExternalSortOptions {
+  // Bytes of records held in memory per sorted run.
+  size_t memory_bytes = size_t(64) << 20;
+  // Stream buffer per open file; runs are read and written sequentially.
+  // The merge opens at most memory_bytes / buffer_bytes runs at once (and at
+  // least two), merging in several passes when there are more.
+  size_t buffer_bytes = size_t(1) << 20;
+  // Where runs are spilled. Defaults to the system temp directory.
+  std::filesystem::path temp_dir;
+};
+
+struct ExternalSortStats {
+  uint64_t bytes = 0;
+  size_t records = 0;
+  size_t runs = 0;
+  size_t merge_passes = 0;
+  double seconds = 0;
+
+  double MegabytesPerSecond() const {
+    return seconds > 0 ? (bytes / (1024.0 * 1024.0)) / seconds : 0;
+  }
+};
+
+namespace _ {
+
+template <class Stream>
+struct buffered_ {
+  std::unique_ptr<char[]> buffer_;
+  Stream stream_;
+
+  buffered_(const std::filesystem::path& path, size_t buffer_bytes)
+      : buffer_(std::make_unique<char[]>(buffer_bytes)),
+        stream_() {
+    stream_.rdbuf()->pubsetbuf(buffer_.get(), buffer_bytes);
+    stream_.open(path, std::ios::binary);
+  }
+};
+
+// Fixed-size binary records, read and written as raw bytes.
+template <class T>
+struct binary_records_ {
+  static_assert(std::is_trivially_copyable<T>::value, "binary records must be trivially copyable");
+
+  using value_type = T;
+  static constexpr size_t MIN_BYTES = sizeof(T);
+
+  static bool Read(std::istream& in, T& out) {
+    in.read(reinterpret_cast<char*>(&out), sizeof(T));
+    return in.gcount() == sizeof(T);
+  }
+
+  // Whether the Read that failed stopped at a clean end of input, rather
+  // than on an I/O error or partway through a record.
+  static bool Ended(const std::istream& in) {
+    return in.eof() && !in.bad() && in.gcount() == 0;
+  }
+
+  static void Write(std::ostream& out, const T& val) {
+    out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+  }
+
+  static size_t Bytes(const T&) {
+    return sizeof(T);
+  }
+
+  static size_t Footprint(const T&) {
+    return sizeof(T);
+  }
+};
+
+// Newline-delimited text records.
+struct text_lines_ {
+  using value_type = std::string;
+  static constexpr size_t MIN_BYTES = 1;
+
+  static bool Read(std::istream& in, std::string& out) {
+    return static_cast<bool>(std::getline(in, out));
+  }
+
+  static bool Ended(const std::istream& in) {
+    return in.eof() && !in.bad();
+  }
+
+  static void Write(std::ostream& out, const std::string& val) {
+    out.write(val.data(), val.size());
+    out.put('\n');
+  }
+
+  static size_t Bytes(const std::string& val) {
+    return val.size() + 1;
+  }
+
+  static size_t Footprint(const std::string& val) {
+    return sizeof(std::string) + val.capacity();
+  }
+};
+
+// Head of one run in the k-way merge.
+template <class T>
+struct merge_head_ {
+  T value_;
+  size_t run_;
+};
+
+// Orders run heads by op, then by run, so equal values come out in run order
+// and the merge is stable like merge_sort.
+template <class T, typename Func>
+struct merge_order_ {
+  Func* op_;
+
+  bool operator()(const merge_head_<T>& lhs, const merge_head_<T>& rhs) const {
+    if ((*op_)(lhs.value_, rhs.value_)) return true;
+    if ((*op_)(rhs.value_, lhs.value_)) return false;
+    return lhs.run_ < rhs.run_;
+  }
+};
+
+inline std::filesystem::path run_path_(const std::filesystem::path& dir, size_t run) {
+  auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+  return dir / ("ds-run-" + std::to_string(stamp) + "-" + std::to_string(run) + ".tmp");
+}
+
+// Merges runs[first, last) into out. Returns false if a run cannot be opened
+// or read to its end.
+template <class Format, typename Func>
+bool merge_runs_(const ArrayList<std::filesystem::path>& runs, size_t first, size_t last,
+                 std::ostream& out, Func&& op, const ExternalSortOptions& options) {
+  using T = typename Format::value_type;
+  using Order = merge_order_<T, std::remove_reference_t<Func>>;
+
+  ArrayList<std::unique_ptr<buffered_<std::ifstream>>> readers(last - first);
+  BinHeap<merge_head_<T>, Order> heap(last - first, Order{ &op });
+  T val;
+
+  for (size_t r = 0; r < last - first; ++r) {
+    readers.Append(std::make_unique<buffered_<std::ifstream>>(runs.begin()[first + r], options.buffer_bytes));
+    if (!readers[r]->stream_.is_open()) {
+      return false;
+    }
+    if (Format::Read(readers[r]->stream_, val)) {
+      heap.Insert(merge_head_<T>{ std::move(val), r });
+    }
+  }
+
+  while (!heap.isEmpty()) {
+    size_t run = heap.Top().run_;
+    Format::Write(out, heap.Top().value_);
+
+    if (Format::Read(readers[run]->stream_, val)) {
+      heap.Replace(merge_head_<T>{ std::move(val), run });
+    }
+    else {
+      heap.Pop();
+    }
+  }
+
+  for (auto& reader : readers) {
+    if (!Format::Ended(reader->stream_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sorts memory_bytes-sized chunks with merge_sort, spills each to a run file
+// and k-way merges the runs through a BinHeap. A single run is written
+// straight to the output. While there are more runs than the fan-in, each
+// pass merges consecutive groups of them into longer runs; keeping the groups
+// in input order keeps the sort stable. On failure the runs and any partial
+// output are removed.
+template <class Format, typename Func>
+std::optional<ExternalSortStats> external_sort(const std::filesystem::path& in_path,
+                                               const std::filesystem::path& out_path,
+                                               Func&& op,
+                                               const ExternalSortOptions& options) {
+  using T = typename Format::value_type;
+
+  auto start = std::chrono::steady_clock::now();
+  auto dir = options.temp_dir.empty() ? std::filesystem::temp_directory_path() : options.temp_dir;
+
+  buffered_<std::ifstream> in(in_path, options.buffer_bytes);
+  if (!in.stream_.is_open()) {
+    return {};
+  }
+
+  // Opening the output truncates it, so it must not be the input.
+  std::error_code ec;
+  if (std::filesystem::equivalent(in_path, out_path, ec)) {
+    return {};
+  }
+
+  buffered_<std::ofstream> out(out_path, options.buffer_bytes);
+  if (!out.stream_.is_open()) {
+    return {};
+  }
+
+  ExternalSortStats stats;
+  ArrayList<std::filesystem::path> runs;
+
+  auto cleanup = [&runs]() {
+    std::error_code ec;
+    for (auto& path : runs) {
+      std::filesystem::remove(path, ec);
+    }
+  };
+
+  auto fail = [&]() -> std::optional<ExternalSortStats> {
+    cleanup();
+    out.stream_.close();
+    std::filesystem::remove(out_path, ec);
+    return {};
+  };
+
+  // Every record takes at least sizeof(T) of the budget, so the chunk never
+  // needs more slots than this and is never regrown by doubling. Small inputs
+  // get a chunk sized to the file instead.
+  size_t slots = options.memory_bytes / sizeof(T) + 1;
+  auto in_bytes = std::filesystem::file_size(in_path, ec);
+  if (!ec) {
+    slots = std::min<size_t>(slots, in_bytes / Format::MIN_BYTES + 1);
+  }
+  ArrayList<T> chunk(slots);
+
+  T val;
+  bool more = Format::Read(in.stream_, val);
+
+  while (more) {
+    chunk.Clear();
+    size_t used = 0;
+
+    while (more && used < options.memory_bytes && chunk.Size() < slots) {
+      used += Format::Footprint(val);
+      stats.bytes += Format::Bytes(val);
+      chunk.Append(std::move(val));
+      more = Format::Read(in.stream_, val);
+    }
+
+    merge_sort(chunk.begin(), chunk.end(), op);
+    stats.records += chunk.Size();
+    ++stats.runs;
+
+    if (!more && runs.isEmpty()) {
+      for (auto& record : chunk) {
+        Format::Write(out.stream_, record);
+      }
+      break;
+    }
+
+    runs.Append(run_path_(dir, runs.Size()));
+    buffered_<std::ofstream> run(runs[runs.Size() - 1], options.buffer_bytes);
+
+    for (auto& record : chunk) {
+      Format::Write(run.stream_, record);
+    }
+
+    if (!run.stream_.flush()) {
+      return fail();
+    }
+  }
+
+  // A read error or a truncated last record ends the input early.
+  if (!Format::Ended(in.stream_)) {
+    return fail();
+  }
+
+  // Give the chunk's memory back before the merge opens its buffers.
+  chunk = ArrayList<T>();
+
+  size_t fan_in = std::max<size_t>(2, options.memory_bytes / std::max<size_t>(1, options.buffer_bytes));
+  size_t spilled = runs.Size();
+
+  while (runs.Size() > fan_in) {
+    ArrayList<std::filesystem::path> merged;
+
+    for (size_t first = 0; first < runs.Size(); first += fan_in) {
+      merged.Append(run_path_(dir, spilled++));
+      buffered_<std::ofstream> run(merged[merged.Size() - 1], options.buffer_bytes);
+
+      size_t last = std::min(first + fan_in, runs.Size());
+      bool merged_ok = merge_runs_<Format>(runs, first, last, run.stream_, op, options) && run.stream_.flush();
+      run.stream_.close();
+
+      if (!merged_ok) {
+        for (auto& path : merged) {
+          std::filesystem::remove(path, ec);
+        }
+        return fail();
+      }
+    }
+
+    cleanup();
+    runs = std::move(merged);
+    ++stats.merge_passes;
+  }
+
+  if (!runs.isEmpty()) {
+    if (!merge_runs_<Format>(runs, 0, runs.Size(), out.stream_, op, options)) {
+      return fail();
+    }
+    cleanup();
+    ++stats.merge_passes;
+  }
+
+  if (!out.stream_.flush()) {
+    return fail();
+  }
+
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return stats;
+}
+
+} // namespace _
+
+// Sorts a file of fixed-size binary records of type T. Returns nullopt if a
+// file cannot be opened, read or written, if the input ends partway through
+// a record, or if in_path and out_path are the same file.
+template <class T, typename Func>
+std::optional<ExternalSortStats> external_sort_records(const std::filesystem::path& in_path,
+                                                       const std::filesystem::path& out_path,
+                                                       Func&& op,
+                                                       const ExternalSortOptions& options = {}) {
+  return _::external_sort<_::binary_records_<T>>(in_path, out_path, op, options);
+}
+
+template <class T>
+std::optional<ExternalSortStats> external_sort_records(const std::filesystem::path& in_path,
+                                                       const std::filesystem::path& out_path) {
+  return external_sort_records<T>(in_path, out_path, ascending);
+}
+
+// Sorts a newline-delimited text file line by line.
+template <typename Func>
+std::optional<ExternalSortStats> external_sort_lines(const std::filesystem::path& in_path,
+                                                     const std::filesystem::path& out_path,
+                                                     Func&& op,
+                                                     const ExternalSortOptions& options = {}) {
+  return _::external_sort<_::text_lines_>(in_path, out_path, op, options);
+}
+
+inline std::optional<ExternalSortStats> external_sort_lines(const std::filesystem::path& in_path,
+                                                            const std::filesystem::path& out_path) {
+  return external_sort_lines(in_path, out_path, ascending);
+}
+
+} // namespace ds
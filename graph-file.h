@@ -0,0 +1,653 @@
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+#include "list.h"
+#include "thread-pool.h"
+
+// Binary graph files. A file is a header and four sections: the targets and
+// weights of every edge, grouped by source node, then the node values and
+// the CSR offsets into the edge sections. The header gives each section's
+// byte position, each a multiple of 8, so a mapped file's sections are
+// aligned arrays that MappedGraph traverses in place. Files are read back on
+// machines of the endianness they were written on.
+
+namespace ds {
+
+namespace _ {
+
+struct graph_header_ {
+  static constexpr char MAGIC[4] = { 'D', 'S', 'G', 'F' };
+  static constexpr uint32_t VERSION = 1;
+
+  char magic_[4];
+  uint32_t version_;
+  uint64_t value_bytes_;
+  uint64_t index_bytes_;
+  uint64_t nodes_;
+  uint64_t edges_;
+  uint64_t targets_at_;
+  uint64_t weights_at_;
+  uint64_t values_at_;
+  uint64_t offsets_at_;
+};
+
+inline uint64_t align8_(uint64_t at) {
+  return (at + 7) & ~uint64_t(7);
+}
+
+// A whole file mapped read-only, unmapped on destruction. An empty file maps
+// to no data.
+class mapped_file_ {
+public:
+  mapped_file_()
+      : data_(nullptr),
+        size_(0) {
+
+  }
+
+  mapped_file_(const mapped_file_& other) = delete;
+  mapped_file_& operator=(const mapped_file_& other) = delete;
+
+  mapped_file_(mapped_file_&& other) noexcept
+      : data_(other.data_),
+        size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  mapped_file_& operator=(mapped_file_&& other) noexcept {
+    if (this != &other) {
+      Close();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+    }
+    return *this;
+  }
+
+  ~mapped_file_() {
+    Close();
+  }
+
+  bool Open(const std::filesystem::path& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      return false;
+    }
+
+    void* data = nullptr;
+    if (size.QuadPart > 0) {
+      HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping) {
+        data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+      }
+    }
+    CloseHandle(file);
+
+    if (size.QuadPart > 0 && !data) {
+      return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      return false;
+    }
+
+    struct stat status;
+    if (::fstat(file, &status) != 0) {
+      ::close(file);
+      return false;
+    }
+
+    void* data = nullptr;
+    if (status.st_size > 0) {
+      data = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+    }
+    ::close(file);
+
+    if (data == MAP_FAILED) {
+      return false;
+    }
+    size_ = static_cast<size_t>(status.st_size);
+#endif
+
+    data_ = static_cast<const char*>(data);
+    return true;
+  }
+
+  void Close() {
+    if (data_) {
+#ifdef _WIN32
+      UnmapViewOfFile(data_);
+#else
+      ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  const char* Data() const {
+    return data_;
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+private:
+  const char* data_;
+  size_t size_;
+};
+
+} // namespace _
+
+// Writes a graph file a node at a time, so a graph larger than memory can be
+// written as it is generated. Targets go straight to the file and weights to
+// a temporary file beside it; only values and offsets, a few bytes per node,
+// are held until Close assembles the file.
+template <class T, class Index = size_t>
+class GraphWriter {
+  static_assert(std::is_trivially_copyable<T>::value, "node values are written as raw bytes");
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
+
+public:
+  GraphWriter(const std::filesystem::path& path)
+      : path_(path),
+        weightsPath_(path.string() + ".weights"),
+        out_(path, std::ios::binary),
+        weights_(weightsPath_, std::ios::binary),
+        values_(),
+        offsets_(1, 0),
+        largest_(0),
+        closed_(false),
+        ok_(false) {
+    _::graph_header_ header{};
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+  GraphWriter(const GraphWriter& other) = delete;
+  GraphWriter& operator=(const GraphWriter& other) = delete;
+
+  ~GraphWriter() {
+    Close();
+  }
+
+  size_t NodeCount() const {
+    return values_.Size();
+  }
+
+  size_t EdgeCount() const {
+    return offsets_.begin()[offsets_.Size() - 1];
+  }
+
+  // Starts a new node; edges added until the next AddNode leave it.
+  size_t AddNode(T value = T{}) {
+    values_.Append(value);
+    offsets_.Append(EdgeCount());
+    return values_.Size() - 1;
+  }
+
+  // An edge from the last node added to dest, which may be added later.
+  void AddEdge(size_t dest, double weight = 1.0) {
+    assert(!values_.isEmpty());
+    assert(dest <= std::numeric_limits<Index>::max());
+
+    Index target = static_cast<Index>(dest);
+    out_.write(reinterpret_cast<const char*>(&target), sizeof(Index));
+    weights_.write(reinterpret_cast<const char*>(&weight), sizeof(double));
+    largest_ = std::max(largest_, dest);
+    ++offsets_[offsets_.Size() - 1];
+  }
+
+  // Finishes the file. Returns false if a write failed or an edge points past
+  // the last node, leaving no file behind.
+  bool Close() {
+    if (closed_) {
+      return ok_;
+    }
+    closed_ = true;
+
+    _::graph_header_ header{};
+    std::memcpy(header.magic_, _::graph_header_::MAGIC, sizeof(header.magic_));
+    header.version_ = _::graph_header_::VERSION;
+    header.value_bytes_ = sizeof(T);
+    header.index_bytes_ = sizeof(Index);
+    header.nodes_ = NodeCount();
+    header.edges_ = EdgeCount();
+    header.targets_at_ = sizeof(header);
+    header.weights_at_ = _::align8_(header.targets_at_ + EdgeCount() * sizeof(Index));
+    header.values_at_ = header.weights_at_ + EdgeCount() * sizeof(double);
+    header.offsets_at_ = _::align8_(header.values_at_ + NodeCount() * sizeof(T));
+
+    weights_.close();
+    ok_ = static_cast<bool>(weights_) && (EdgeCount() == 0 || largest_ < NodeCount());
+
+    if (ok_) {
+      pad(header.weights_at_);
+      std::ifstream weights(weightsPath_, std::ios::binary);
+      if (EdgeCount() > 0) {
+        out_ << weights.rdbuf();
+      }
+      out_.write(reinterpret_cast<const char*>(values_.begin()), NodeCount() * sizeof(T));
+      pad(header.offsets_at_);
+      for (auto offset : offsets_) {
+        uint64_t at = offset;
+        out_.write(reinterpret_cast<const char*>(&at), sizeof(at));
+      }
+
+      out_.seekp(0);
+      out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      ok_ = static_cast<bool>(out_.flush());
+    }
+
+    out_.close();
+    std::error_code ignored;
+    std::filesystem::remove(weightsPath_, ignored);
+    if (!ok_) {
+      std::filesystem::remove(path_, ignored);
+    }
+    return ok_;
+  }
+
+private:
+  std::filesystem::path path_;
+  std::filesystem::path weightsPath_;
+  std::ofstream out_;
+  std::ofstream weights_;
+  ArrayList<T> values_;
+  ArrayList<size_t> offsets_;
+  size_t largest_;
+  bool closed_;
+  bool ok_;
+
+  // Zero bytes up to file position at.
+  void pad(uint64_t at) {
+    static const char zeros[8] = {};
+    auto position = static_cast<uint64_t>(out_.tellp());
+    out_.write(zeros, static_cast<std::streamsize>(at - position));
+  }
+};
+
+// Writes graph, an AdjacencyListGraph or CSRGraph, as a graph file.
+template <class Index = size_t, class Graph>
+bool save_graph(const Graph& graph, const std::filesystem::path& path) {
+  using T = std::decay_t<decltype(graph.Value(0))>;
+  GraphWriter<T, Index> writer(path);
+
+  for (size_t n = 0; n < graph.NodeCount(); ++n) {
+    writer.AddNode(graph.Value(n));
+    graph.ForEachEdge(n, [&writer](size_t dest, double weight) {
+      writer.AddEdge(dest, weight);
+    });
+  }
+
+  return writer.Close();
+}
+
+// A graph file mapped into memory and traversed where it lies: opening it
+// reads nothing but the header and offsets, and pages load as traversals
+// touch them. Offers CSRGraph's read-only interface over the mapped arrays.
+template <class T, class Index = size_t>
+class MappedGraph {
+  static_assert(std::is_trivially_copyable<T>::value, "node values are read as raw bytes");
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
+
+public:
+  MappedGraph()
+      : file_(),
+        nodes_(0),
+        values_(nullptr),
+        offsets_(nullptr),
+        targets_(nullptr),
+        weights_(nullptr) {
+
+  }
+
+  // Maps the file at path in place of any open one. Returns false, leaving
+  // this graph empty, if it is missing, truncated, was written with another
+  // T or Index, or has offsets out of order. Targets are not checked, as that
+  // would read the whole file.
+  bool Open(const std::filesystem::path& path) {
+    Close();
+
+    _::mapped_file_ file;
+    if (!file.Open(path) || file.Size() < sizeof(_::graph_header_)) {
+      return false;
+    }
+
+    _::graph_header_ header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    uint64_t size = file.Size();
+    uint64_t nodes = header.nodes_;
+    uint64_t edges = header.edges_;
+
+    auto fits = [size](uint64_t at, uint64_t count, uint64_t bytes) {
+      return at % 8 == 0 && at <= size && count <= (size - at) / bytes;
+    };
+
+    if (std::memcmp(header.magic_, _::graph_header_::MAGIC, sizeof(header.magic_)) != 0 ||
+        header.version_ != _::graph_header_::VERSION ||
+        header.value_bytes_ != sizeof(T) ||
+        header.index_bytes_ != sizeof(Index) ||
+        nodes > std::numeric_limits<Index>::max() ||
+        !fits(header.targets_at_, edges, sizeof(Index)) ||
+        !fits(header.weights_at_, edges, sizeof(double)) ||
+        !fits(header.values_at_, nodes, sizeof(T)) ||
+        !fits(header.offsets_at_, nodes + 1, sizeof(uint64_t))) {
+      return false;
+    }
+
+    auto offsets = reinterpret_cast<const uint64_t*>(file.Data() + header.offsets_at_);
+    if (offsets[0] != 0 || offsets[nodes] != edges) {
+      return false;
+    }
+    for (uint64_t n = 0; n < nodes; ++n) {
+      if (offsets[n] > offsets[n + 1]) {
+        return false;
+      }
+    }
+
+    nodes_ = static_cast<size_t>(nodes);
+    values_ = reinterpret_cast<const T*>(file.Data() + header.values_at_);
+    offsets_ = offsets;
+    targets_ = reinterpret_cast<const Index*>(file.Data() + header.targets_at_);
+    weights_ = reinterpret_cast<const double*>(file.Data() + header.weights_at_);
+    file_ = std::move(file);
+    return true;
+  }
+
+  // Unmaps the file, leaving this graph empty. Windows will not resize,
+  // rewrite or delete a file while a view of it is open.
+  void Close() {
+    *this = MappedGraph();
+  }
+
+  size_t NodeCount() const {
+    return nodes_;
+  }
+
+  size_t EdgeCount() const {
+    return nodes_ ? static_cast<size_t>(offsets_[nodes_]) : 0;
+  }
+
+  const T& Value(size_t node) const {
+    check_bounds(node, NodeCount());
+    return values_[node];
+  }
+
+  size_t Degree(size_t node) const {
+    check_bounds(node, NodeCount());
+    return static_cast<size_t>(offsets_[node + 1] - offsets_[node]);
+  }
+
+  template <class Func>
+  void ForEachEdge(size_t node, Func&& f) const {
+    for (size_t e = offsets_[node], end = offsets_[node + 1]; e < end; ++e) {
+      f(static_cast<size_t>(targets_[e]), weights_[e]);
+    }
+  }
+
+  template <class Func>
+  void DFS(size_t start, Func& f) const {
+    TraversalContext context;
+    DFS(start, context, f);
+  }
+
+  template <class Pre, class Post = _::no_visit_>
+  bool DFS(size_t start, TraversalContext& context, Pre& pre, Post&& post = Post()) const {
+    check_bounds(start, NodeCount());
+    context.Reset(NodeCount());
+    return _::depth_first_(start, context,
+      [this](size_t node) { return std::make_pair(size_t(offsets_[node]), size_t(offsets_[node + 1])); },
+      [this](size_t, size_t e) { return static_cast<size_t>(targets_[e]); },
+      pre, post);
+  }
+
+  template <class Queue = IndexedHeap<double, MinHeap>>
+  std::pair<ArrayList<size_t>, double> Dikstras(size_t start, size_t end) const {
+    return _::shortest_path_<Queue, Index>(NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  double Dikstras(size_t start, size_t end, PathContext& context, ArrayList<size_t>& path) const {
+    return _::context_path_(context, NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, path);
+  }
+
+  ShortestPathTree DeltaStepping(size_t start, ThreadPool& pool, double delta = 0) const {
+    check_bounds(start, NodeCount());
+    return _::delta_stepping_<Index>(NodeCount(), start, delta, pool, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  Components ConnectedComponents(ThreadPool& pool) const {
+    return _::connected_components_(NodeCount(), pool,
+      [this](size_t node) { return std::make_pair(size_t(offsets_[node]), size_t(offsets_[node + 1])); },
+      [this](size_t, size_t e) { return static_cast<size_t>(targets_[e]); });
+  }
+
+  RankResult PageRank(ThreadPool& pool, double damping = 0.85, double tolerance = 1e-6,
+                      size_t maxIterations = 100) const {
+    return _::pagerank_push_<Index>(NodeCount(), pool, damping, tolerance, maxIterations,
+      [this](size_t n) { return static_cast<size_t>(offsets_[n + 1] - offsets_[n]); },
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  // A copy in memory, for the algorithms that need a CSRGraph.
+  CSRGraph<T, Index> ToCSR() const {
+    ArrayList<T> values(NodeCount());
+    ArrayList<GraphEdge> edges(EdgeCount());
+
+    for (size_t n = 0; n < NodeCount(); ++n) {
+      values.Append(values_[n]);
+      ForEachEdge(n, [&](size_t dest, double weight) {
+        edges.Append(GraphEdge(n, dest, weight));
+      });
+    }
+
+    return CSRGraph<T, Index>(std::move(values), edges.begin(), edges.end());
+  }
+
+private:
+  _::mapped_file_ file_;
+  size_t nodes_;
+  const T* values_;
+  const uint64_t* offsets_;
+  const Index* targets_;
+  const double* weights_;
+};
+
+// Converts a text edge list to a graph file of nodes valued T{}. Lines are
+// "src dest [weight]" with 0-based ids, as SNAP writes them, or DIMACS's
+// "a src dest weight" with 1-based ids; '#', '%' and DIMACS 'c' lines are
+// comments, and a DIMACS "p sp nodes edges" line sets the node count.
+// Otherwise there are as many nodes as the largest id needs. The text is
+// mapped and parsed by the pool's threads in chunks split at line ends;
+// edges keep their order in the file. Returns the number of edges written,
+// or nullopt if the text cannot be read or parsed or the file written.
+template <class T = int, class Index = size_t>
+std::optional<size_t> convert_edge_list(const std::filesystem::path& text, const std::filesystem::path& path,
+                                        ThreadPool& pool) {
+  constexpr size_t CHUNK = size_t(1) << 22;
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  _::mapped_file_ file;
+  if (!file.Open(text)) {
+    return {};
+  }
+
+  const char* data = file.Data();
+  size_t size = file.Size();
+  ArrayList<size_t> starts(1, 0);
+  while (starts[starts.Size() - 1] < size) {
+    size_t at = std::min(size, starts[starts.Size() - 1] + CHUNK);
+    while (at < size && data[at - 1] != '\n') {
+      ++at;
+    }
+    starts.Append(at);
+  }
+  size_t chunks = starts.Size() - 1;
+
+  ArrayList<ArrayList<GraphEdge>> parsed(chunks, ArrayList<GraphEdge>());
+  ArrayList<size_t> declared(chunks, NONE);
+  std::atomic<bool> failed(false);
+
+  pool.ParallelFor(0, chunks, 1, [&](size_t lo, size_t hi, size_t) {
+    for (size_t c = lo; c < hi && !failed.load(std::memory_order_relaxed); ++c) {
+      const char* p = data + starts[c];
+      const char* end = data + starts[c + 1];
+      auto& edges = parsed[c];
+
+      auto skip = [&p, end]() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')) ++p;
+      };
+      auto number = [&p, end](auto& value) {
+        auto r = std::from_chars(p, end, value);
+        p = r.ptr;
+        return r.ec == std::errc();
+      };
+
+      while (p < end) {
+        const char* eol = std::find(p, end, '\n');
+        skip();
+
+        if (p < eol && *p != '#' && *p != '%' && *p != 'c') {
+          bool dimacs = *p == 'a';
+          bool problem = *p == 'p';
+          size_t src = 0;
+          size_t dest = 0;
+          double weight = 1.0;
+          bool ok = true;
+
+          if (problem) {
+            p = std::find_if(p + 1, eol, [](char ch) { return ch >= '0' && ch <= '9'; });
+            ok = number(declared[c]);
+          }
+          else {
+            if (dimacs) {
+              ++p;
+              skip();
+            }
+            ok = number(src);
+            skip();
+            ok = ok && number(dest);
+            skip();
+            if (ok && p < eol) {
+              ok = number(weight);
+            }
+            if (dimacs) {
+              ok = ok && src > 0 && dest > 0;
+              --src;
+              --dest;
+            }
+            if (ok) {
+              edges.Append(GraphEdge(src, dest, weight));
+            }
+          }
+
+          if (!ok) {
+            failed = true;
+            return;
+          }
+        }
+
+        p = eol < end ? eol + 1 : end;
+      }
+    }
+  });
+
+  if (failed) {
+    return {};
+  }
+
+  size_t nodes = 0;
+  size_t edgeCount = 0;
+  for (size_t c = 0; c < chunks; ++c) {
+    if (declared[c] != NONE) {
+      nodes = std::max(nodes, declared[c]);
+    }
+    for (auto& e : parsed[c]) {
+      nodes = std::max(nodes, std::max(e.src_, e.dest_) + 1);
+    }
+    edgeCount += parsed[c].Size();
+  }
+  if (nodes > std::numeric_limits<Index>::max()) {
+    return {};
+  }
+
+  // Gathered by source, in file order, like CSRGraph's constructor.
+  ArrayList<size_t> offsets(nodes + 1, 0);
+  for (auto& edges : parsed) {
+    for (auto& e : edges) {
+      ++offsets[e.src_ + 1];
+    }
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  ArrayList<Index> targets(edgeCount, 0);
+  ArrayList<double> weights(edgeCount, 0);
+  ArrayList<size_t> cursor(offsets);
+  for (auto& edges : parsed) {
+    for (auto& e : edges) {
+      size_t slot = cursor[e.src_]++;
+      targets[slot] = static_cast<Index>(e.dest_);
+      weights[slot] = e.weight_;
+    }
+    edges = ArrayList<GraphEdge>();
+  }
+
+  GraphWriter<T, Index> writer(path);
+  for (size_t n = 0; n < nodes; ++n) {
+    writer.AddNode();
+    for (size_t e = offsets[n]; e < offsets[n + 1]; ++e) {
+      writer.AddEdge(targets[e], weights[e]);
+    }
+  }
+
+  if (!writer.Close()) {
+    return {};
+  }
+  return edgeCount;
+}
+
+} // namespace ds
@@ -2,220 +2,3180 @@
 
 #include <memory>
 #include <array>
+#include <numeric>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
 #include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
 
+#include "bitset.h"
+#include "common.h"
+#include "disjoint-set.h"
 #include "list.h"
 #include "queue.h"
 #include "heap.h"
+#include "sort.h"
+#include "thread-pool.h"
 #include <mutex>
 
 namespace ds {
 
-template <class T>
+// A directed, weighted edge from src_ to dest_.
+struct GraphEdge {
+  size_t src_;
+  size_t dest_;
+  double weight_;
+
+  GraphEdge()
+      : src_(0),
+        dest_(0),
+        weight_(0) {
+
+  }
+
+  GraphEdge(size_t src, size_t dest, double weight = 1.0) 
+      : src_(src),
+        dest_(dest),
+        weight_(weight) {
+
+  }
+
+  bool operator< (const GraphEdge& other) const { return weight_ < other.weight_; }
+  bool operator> (const GraphEdge& other) const { return other.weight_ < weight_; }
+  bool operator<=(const GraphEdge& other) const { return !(weight_ > other.weight_); }
+  bool operator>=(const GraphEdge& other) const { return !(weight_ < other.weight_); }
+}; // struct GraphEdge
+
+// Hop counts and BFS tree from a traversal. Unreached nodes hold UNREACHED in
+// both arrays; the start is its own parent.
+struct BFSResult {
+  static constexpr size_t UNREACHED = std::numeric_limits<size_t>::max();
+
+  ArrayList<size_t> distance_;
+  ArrayList<size_t> parent_;
+};
+
+// Distances and shortest-path tree from one source. Unreached nodes keep
+// distance max() and parent UNREACHED; the source is its own parent.
+struct ShortestPathTree {
+  static constexpr size_t UNREACHED = std::numeric_limits<size_t>::max();
+
+  ArrayList<double> distance_;
+  ArrayList<size_t> parent_;
+
+  // The (path, distance) pair Dikstras would return for source to node.
+  std::pair<ArrayList<size_t>, double> PathTo(size_t node) const {
+    check_bounds(node, parent_.Size());
+    ArrayList<size_t> path;
+
+    if (parent_[node] == UNREACHED) {
+      return std::make_pair(std::move(path), distance_[node]);
+    }
+    if (parent_[node] == node) {
+      return std::make_pair(std::move(path), 0.0);
+    }
+
+    for (size_t p = node; ; p = parent_[p]) {
+      path.Append(p);
+      if (parent_[p] == p) {
+        break;
+      }
+    }
+    std::reverse(path.begin(), path.end());
+
+    return std::make_pair(std::move(path), distance_[node]);
+  }
+};
+
+// Component of each node, numbered 0 to count_ - 1.
+struct Components {
+  ArrayList<size_t> label_;
+  size_t count_;
+};
+
+// A minimum spanning forest: one tree per connected component, edges taken as
+// undirected, and their total weight.
+struct SpanningForest {
+  ArrayList<GraphEdge> edges_;
+  double weight_;
+};
+
+// Ranks from PageRank and its variants, summing to 1, with the number of
+// iterations run and the L1 change made by the last one.
+struct RankResult {
+  ArrayList<double> rank_;
+  size_t iterations_;
+  double delta_;
+};
+
+// Part of each node, 0 to parts_ - 1, and how many edges run between parts.
+struct GraphPartition {
+  ArrayList<size_t> part_;
+  size_t parts_;
+  size_t cut_;
+};
+
+// What a traversal callback asks for next. Prune skips the children of the
+// node just entered; Stop ends the traversal.
+enum class TraversalAction {
+  Continue,
+  Prune,
+  Stop
+};
+
+class TraversalContext;
+class PathContext;
+
+namespace _ {
+
+template <class Range, class Target, class Pre, class Post>
+bool depth_first_(size_t start, TraversalContext& context, Range&& range, Target&& target, Pre& pre, Post& post);
+
+template <class ForEachEdge>
+double context_path_(PathContext& context, size_t count, size_t start, size_t end, ForEachEdge&& edges,
+                     ArrayList<size_t>& out_path);
+
+} // namespace _
+
+// Reusable state for repeated traversals of one graph. A node is visited when
+// its stamp equals the current epoch, so starting a traversal bumps the epoch
+// rather than clearing V flags, and the DFS stack keeps its storage, so a
+// traversal costs O(nodes visited) after the first.
+class TraversalContext {
+public:
+  TraversalContext(size_t nodes = 0)
+      : epoch_(0),
+        stamps_(nodes, 0),
+        stack_() {
+
+  }
+
+  // Starts a traversal over nodes nodes with nothing visited.
+  void Reset(size_t nodes) {
+    if (stamps_.Size() < nodes) {
+      stamps_.Reserve(nodes);
+      while (stamps_.Size() < nodes) {
+        stamps_.Append(0);
+      }
+    }
+
+    if (++epoch_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+
+  bool isVisited(size_t node) const {
+    return stamps_.begin()[node] == epoch_;
+  }
+
+  // Marks node visited; false if it already was.
+  bool Visit(size_t node) {
+    if (isVisited(node)) {
+      return false;
+    }
+    stamps_[node] = epoch_;
+    return true;
+  }
+
+private:
+  template <class Range, class Target, class Pre, class Post>
+  friend bool _::depth_first_(size_t start, TraversalContext& context, Range&& range, Target&& target, Pre& pre, Post& post);
+
+  uint32_t epoch_;
+  ArrayList<uint32_t> stamps_;
+  ArrayList<std::pair<size_t, size_t>> stack_;
+};
+
+// Reusable state for repeated Dikstras queries, kept by the caller across
+// calls. Distances and predecessors count only where a node's stamp is the
+// current epoch, so a query resets nothing it did not touch: the epoch is
+// bumped and whatever the last search left queued is dropped. Once the
+// context has grown to the graph, a query allocates nothing.
+class PathContext {
+public:
+  PathContext(size_t nodes = 0)
+      : epoch_(0),
+        reached_(nodes, 0),
+        settled_(nodes, 0),
+        distance_(nodes, 0),
+        prev_(nodes, 0),
+        queue_(nodes) {
+
+  }
+
+  // Starts a query over nodes nodes with nothing reached.
+  void Reset(size_t nodes) {
+    if (reached_.Size() < nodes) {
+      grow(reached_, nodes, 0u);
+      grow(settled_, nodes, 0u);
+      grow(distance_, nodes, 0.0);
+      grow(prev_, nodes, size_t(0));
+      queue_ = IndexedHeap<double, MinHeap>(nodes);
+    }
+    queue_.Clear();
+
+    if (++epoch_ == 0) {
+      std::fill(reached_.begin(), reached_.end(), 0);
+      std::fill(settled_.begin(), settled_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+
+  // Distance to node found by the last query, final if node was settled;
+  // max() if the query never reached it.
+  double Distance(size_t node) const {
+    return reached_.begin()[node] == epoch_ ? distance_.begin()[node] : std::numeric_limits<double>::max();
+  }
+
+private:
+  template <class ForEachEdge>
+  friend double _::context_path_(PathContext& context, size_t count, size_t start, size_t end, ForEachEdge&& edges,
+                                 ArrayList<size_t>& out_path);
+
+  template <class T>
+  static void grow(ArrayList<T>& list, size_t size, T value) {
+    list.Reserve(size);
+    while (list.Size() < size) {
+      list.Append(value);
+    }
+  }
+
+  uint32_t epoch_;
+  ArrayList<uint32_t> reached_;
+  ArrayList<uint32_t> settled_;
+  ArrayList<double> distance_;
+  ArrayList<size_t> prev_;
+  IndexedHeap<double, MinHeap> queue_;
+};
+
+namespace _ {
+
+// Gives each priority queue the Push(node, distance) / Pop() -> node shape the
+// shortest path search uses. Queues with a decrease-key keep one entry per
+// node; the others take a fresh entry per improvement and the search skips
+// nodes it has already settled.
+template <class Queue>
+struct path_queue_;
+
+template <class P, class Compare, size_t Arity, typename E>
+struct path_queue_<IndexedHeap<P, Compare, Arity, E>> {
+  IndexedHeap<P, Compare, Arity, E> q_;
+
+  path_queue_(size_t count)
+      : q_(count) {
+
+  }
+
+  bool isEmpty() const {
+    return q_.isEmpty();
+  }
+
+  void Push(size_t node, double distance) {
+    if (q_.Contains(node)) {
+      q_.DecreaseKey(node, static_cast<P>(distance));
+    }
+    else {
+      q_.Insert(node, static_cast<P>(distance));
+    }
+  }
+
+  size_t Pop() {
+    return q_.Pop().first;
+  }
+};
+
+// A node is pushed again only before it is settled, and settled nodes are
+// never pushed, so a node's handle is live whenever it is set.
+template <class P, class Compare>
+struct path_queue_<PairingHeap<std::pair<P, size_t>, Compare>> {
+  using Heap = PairingHeap<std::pair<P, size_t>, Compare>;
+
+  Heap q_;
+  ArrayList<typename Heap::Handle> handles_;
+
+  path_queue_(size_t count)
+      : q_(),
+        handles_(count, nullptr) {
+
+  }
+
+  bool isEmpty() const {
+    return q_.isEmpty();
+  }
+
+  void Push(size_t node, double distance) {
+    if (handles_[node]) {
+      q_.DecreaseKey(handles_[node], { static_cast<P>(distance), node });
+    }
+    else {
+      handles_[node] = q_.Insert({ static_cast<P>(distance), node });
+    }
+  }
+
+  size_t Pop() {
+    return q_.Pop().second;
+  }
+};
+
+template <class P, class Compare, size_t Arity, typename E>
+struct path_queue_<BinHeap<std::pair<P, size_t>, Compare, Arity, E>> {
+  BinHeap<std::pair<P, size_t>, Compare, Arity, E> q_;
+
+  path_queue_(size_t count)
+      : q_(count) {
+
+  }
+
+  bool isEmpty() const {
+    return q_.isEmpty();
+  }
+
+  void Push(size_t node, double distance) {
+    q_.Insert({ static_cast<P>(distance), node });
+  }
+
+  size_t Pop() {
+    return q_.Pop().second;
+  }
+};
+
+// Distances are truncated to Key, so weights must be non-negative integers.
+template <class Key>
+struct path_queue_<RadixHeap<Key, size_t>> {
+  RadixHeap<Key, size_t> q_;
+
+  path_queue_(size_t)
+      : q_() {
+
+  }
+
+  bool isEmpty() const {
+    return q_.isEmpty();
+  }
+
+  void Push(size_t node, double distance) {
+    q_.Insert(static_cast<Key>(distance), node);
+  }
+
+  size_t Pop() {
+    return q_.Pop().second;
+  }
+};
+
+template <class Index>
+void make_path_(size_t start, size_t end, const ArrayList<Index>& prev, ArrayList<size_t>& out_path) {
+  size_t p = end;
+
+  out_path.Append(p);
+
+  while (p != start) {
+    p = prev[p];
+    out_path.Append(p);
+  }
+
+  std::reverse(out_path.begin(), out_path.end());
+}
+
+struct zero_heuristic_ {
+  double operator()(size_t) const {
+    return 0;
+  }
+};
+
+// Dijkstra over count nodes. edges(n, visit) calls visit(dest, weight) for
+// each edge out of n, so every graph representation shares one search. prev
+// is stored as Index, the graph's node index type. A non-zero heuristic makes
+// it A*: nodes are queued by distance + heuristic(node), and since a node is
+// final once popped, the heuristic must be consistent (never drop by more
+// than an edge's weight along that edge).
+template <class Queue, class Index, class ForEachEdge, class Heuristic = zero_heuristic_>
+std::pair<ArrayList<size_t>, double> shortest_path_(size_t count, size_t start, size_t end, ForEachEdge&& edges,
+                                                    Heuristic&& heuristic = Heuristic()) {
+
+  if (start == end) {
+    return { {}, 0 };
+  }
+
+  ArrayList<double> distance(count, std::numeric_limits<double>::max());
+  ArrayList<Index> prev(count, std::numeric_limits<Index>::max());
+  DynamicBitset visited(count);
+
+  path_queue_<Queue> q(count);
+
+  q.Push(start, 0);
+  distance[start] = 0;
+
+  ArrayList<size_t> path;
+
+  while (!q.isEmpty()) {
+    size_t n = q.Pop();
+
+    if (visited.TestAndSet(n)) {
+      continue;
+    }
+
+    if (n == end) {
+      make_path_(start, end, prev, path);
+      break;
+    }
+
+    edges(n, [&](size_t dest, double weight) {
+      if (!visited[dest]) {
+        auto d = distance[n] + weight;
+        if (d < distance[dest]) {
+          distance[dest] = d;
+          prev[dest] = static_cast<Index>(n);
+          q.Push(dest, d + heuristic(dest));
+        }
+      }
+    });
+  }
+
+  return std::make_pair(std::move(path), distance[end]);
+}
+
+// shortest_path_ with the default queue over context's arrays, writing the
+// path into out_path instead of returning a new list. The path is laid out
+// front to back from its hop count, so out_path never grows beyond the
+// path's length and is not reversed.
+template <class ForEachEdge>
+double context_path_(PathContext& context, size_t count, size_t start, size_t end, ForEachEdge&& edges,
+                     ArrayList<size_t>& out_path) {
+  check_bounds(start, count);
+  check_bounds(end, count);
+  out_path.Clear();
+  context.Reset(count);
+
+  uint32_t epoch = context.epoch_;
+  uint32_t* reached = context.reached_.begin();
+  uint32_t* settled = context.settled_.begin();
+  double* distance = context.distance_.begin();
+  size_t* prev = context.prev_.begin();
+  auto& q = context.queue_;
+
+  reached[start] = epoch;
+  distance[start] = 0;
+  if (start == end) {
+    return 0;
+  }
+  q.Insert(start, 0);
+
+  while (!q.isEmpty()) {
+    size_t n = q.Pop().first;
+    settled[n] = epoch;
+
+    if (n == end) {
+      size_t hops = 0;
+      for (size_t p = end; p != start; p = prev[p]) {
+        ++hops;
+      }
+
+      out_path.Reserve(hops + 1);
+      for (size_t i = 0; i <= hops; ++i) {
+        out_path.Append(start);
+      }
+      for (size_t p = end, i = hops; p != start; p = prev[p], --i) {
+        out_path[i] = p;
+      }
+      return distance[end];
+    }
+
+    double dn = distance[n];
+    edges(n, [&](size_t dest, double weight) {
+      if (settled[dest] == epoch) {
+        return;
+      }
+
+      double d = dn + weight;
+      if (reached[dest] != epoch) {
+        reached[dest] = epoch;
+        distance[dest] = d;
+        prev[dest] = n;
+        q.Insert(dest, d);
+      }
+      else if (d < distance[dest]) {
+        distance[dest] = d;
+        prev[dest] = n;
+        q.DecreaseKey(dest, d);
+      }
+    });
+  }
+
+  return std::numeric_limits<double>::max();
+}
+
+template <class Func>
+TraversalAction traversal_action_(Func& f, size_t node) {
+  if constexpr (std::is_void<decltype(f(node))>::value) {
+    f(node);
+    return TraversalAction::Continue;
+  }
+  else {
+    return f(node);
+  }
+}
+
+struct no_visit_ {
+  void operator()(size_t) const {
+
+  }
+};
+
+// Iterative DFS shared by the graph types. range(node) gives the node's edge
+// cursor range [first, last) and target(node, cursor) the edge's head. Frames
+// of (node, next cursor) live on the context's stack, so nodes are entered
+// and left in the same order as the recursive version without using the call
+// stack. Returns false if a callback stopped the traversal.
+template <class Range, class Target, class Pre, class Post>
+bool depth_first_(size_t start, TraversalContext& context, Range&& range, Target&& target, Pre& pre, Post& post) {
+  auto& stack = context.stack_;
+  size_t depth = 0;
+
+  auto enter = [&](size_t node) {
+    context.Visit(node);
+
+    auto action = traversal_action_(pre, node);
+    if (action == TraversalAction::Continue) {
+      if (depth == stack.Size()) {
+        stack.Append(std::make_pair(node, range(node).first));
+      }
+      else {
+        stack[depth] = std::make_pair(node, range(node).first);
+      }
+      ++depth;
+    }
+    else if (action == TraversalAction::Prune) {
+      action = traversal_action_(post, node);
+    }
+    return action != TraversalAction::Stop;
+  };
+
+  if (!enter(start)) {
+    return false;
+  }
+
+  while (depth > 0) {
+    auto& frame = stack[depth - 1];
+
+    if (frame.second == range(frame.first).second) {
+      --depth;
+      if (traversal_action_(post, frame.first) == TraversalAction::Stop) {
+        return false;
+      }
+      continue;
+    }
+
+    size_t next = target(frame.first, frame.second++);
+    if (!context.isVisited(next) && !enter(next)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Point-to-point Dijkstra from both ends at once: forward over out-edges from
+// start and backward over in-edges from end, always expanding the smaller
+// queue. It stops once the two queue tops together cannot beat the best
+// start-to-end distance seen where the searches touch, which on road-like
+// graphs settles about half the nodes a one-sided search does.
+template <class Index, class Forward, class Backward>
+std::pair<ArrayList<size_t>, double> bidirectional_path_(size_t count, size_t start, size_t end,
+                                                         Forward&& forward, Backward&& backward) {
+  constexpr double INF = std::numeric_limits<double>::max();
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  if (start == end) {
+    return { {}, 0 };
+  }
+
+  struct side_ {
+    IndexedHeap<double, MinHeap> queue_;
+    ArrayList<double> distance_;
+    ArrayList<Index> prev_;
+    DynamicBitset done_;
+
+    side_(size_t count, size_t origin)
+        : queue_(count),
+          distance_(count, std::numeric_limits<double>::max()),
+          prev_(count, std::numeric_limits<Index>::max()),
+          done_(count) {
+      queue_.Insert(origin, 0);
+      distance_[origin] = 0;
+    }
+  };
+
+  side_ fwd(count, start);
+  side_ bwd(count, end);
+  double best = INF;
+  size_t meet = NONE;
+
+  auto expand = [&](side_& side, side_& other, auto& edges) {
+    size_t n = side.queue_.Pop().first;
+    side.done_.Set(n);
+
+    edges(n, [&](size_t dest, double weight) {
+      double d = side.distance_[n] + weight;
+
+      if (d < side.distance_[dest] && !side.done_[dest]) {
+        side.distance_[dest] = d;
+        side.prev_[dest] = static_cast<Index>(n);
+
+        if (side.queue_.Contains(dest)) {
+          side.queue_.DecreaseKey(dest, d);
+        }
+        else {
+          side.queue_.Insert(dest, d);
+        }
+      }
+
+      if (other.distance_[dest] < INF && side.distance_[dest] + other.distance_[dest] < best) {
+        best = side.distance_[dest] + other.distance_[dest];
+        meet = dest;
+      }
+    });
+  };
+
+  while (!fwd.queue_.isEmpty() && !bwd.queue_.isEmpty()) {
+    if (fwd.queue_.Peek().second + bwd.queue_.Peek().second >= best) {
+      break;
+    }
+
+    if (fwd.queue_.Size() <= bwd.queue_.Size()) {
+      expand(fwd, bwd, forward);
+    }
+    else {
+      expand(bwd, fwd, backward);
+    }
+  }
+
+  ArrayList<size_t> path;
+
+  if (meet == NONE) {
+    return std::make_pair(std::move(path), INF);
+  }
+
+  make_path_(start, meet, fwd.prev_, path);
+  for (size_t p = meet; p != end; ) {
+    p = bwd.prev_[p];
+    path.Append(p);
+  }
+
+  return std::make_pair(std::move(path), best);
+}
+
+// Parallel single-source shortest paths by delta-stepping (Meyer and Sanders).
+// Tentative distances are kept in buckets of width delta. The lowest bucket is
+// settled in rounds that relax the light edges (weight <= delta) of its nodes,
+// which can only refill that bucket, and then the heavy edges of everything
+// it settled once. Each round scans edges in parallel into per-thread
+// relaxation requests and applies them serially, so distances and parents
+// need no atomics and ties resolve the same way on every run. Buckets are
+// cyclic: no tentative distance is more than the largest weight ahead of the
+// current bucket, and a bitmap of the non-empty buckets lets the search jump
+// over empty ones. delta <= 0 uses the mean edge weight; either way delta is
+// raised if needed to keep the bucket count to MAX_SLOTS.
+template <class Index, class ForEachEdge>
+ShortestPathTree delta_stepping_(size_t count, size_t start, double delta, ThreadPool& pool, ForEachEdge&& edges) {
+  constexpr size_t GRAIN = 256;
+  constexpr size_t MAX_SLOTS = size_t(1) << 16;
+
+  struct request_ {
+    Index node_;
+    Index parent_;
+    double distance_;
+  };
+
+  ShortestPathTree tree{ ArrayList<double>(count, std::numeric_limits<double>::max()),
+                         ArrayList<size_t>(count, ShortestPathTree::UNREACHED) };
+  double* distance = tree.distance_.begin();
+  size_t* parent = tree.parent_.begin();
+
+  distance[start] = 0;
+  parent[start] = start;
+
+  // Largest and total weight, for the bucket count and the default delta.
+  ArrayList<double> maxWeight(pool.Size(), 0);
+  ArrayList<double> sumWeight(pool.Size(), 0);
+  ArrayList<size_t> edgeCount(pool.Size(), 0);
+
+  pool.ParallelFor(0, count, 4096, [&](size_t lo, size_t hi, size_t worker) {
+    for (size_t n = lo; n < hi; ++n) {
+      edges(n, [&](size_t, double weight) {
+        maxWeight[worker] = std::max(maxWeight[worker], weight);
+        sumWeight[worker] += weight;
+        ++edgeCount[worker];
+      });
+    }
+  });
+
+  double heaviest = *std::max_element(maxWeight.begin(), maxWeight.end());
+  size_t m = std::accumulate(edgeCount.begin(), edgeCount.end(), size_t(0));
+
+  if (delta <= 0) {
+    double total = std::accumulate(sumWeight.begin(), sumWeight.end(), 0.0);
+    delta = m > 0 && total > 0 ? total / m : 1;
+  }
+
+  // A single heavy edge would otherwise need heaviest / delta buckets.
+  delta = std::max(delta, heaviest / (MAX_SLOTS - 2));
+
+  size_t slots = static_cast<size_t>(heaviest / delta) + 2;
+  ArrayList<ArrayList<Index>> buckets(slots, ArrayList<Index>());
+  DynamicBitset occupied(slots);
+  ArrayList<ArrayList<request_>> requests(pool.Size(), ArrayList<request_>());
+  ArrayList<size_t> taken(count, std::numeric_limits<size_t>::max());
+  ArrayList<size_t> settledIn(count, std::numeric_limits<size_t>::max());
+  ArrayList<Index> settled;
+  size_t pending = 1;
+
+  auto bucketOf = [delta](double d) {
+    return static_cast<size_t>(d / delta);
+  };
+
+  buckets[0].Append(static_cast<Index>(start));
+  occupied.Set(0);
+
+  auto relax = [&](const Index* nodes, size_t n, bool light) {
+    pool.ParallelFor(0, n, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      auto& out = requests[worker];
+
+      for (size_t i = lo; i < hi; ++i) {
+        size_t u = nodes[i];
+        double du = distance[u];
+
+        edges(u, [&](size_t v, double weight) {
+          if ((weight <= delta) == light && du + weight < distance[v]) {
+            out.Append(request_{ static_cast<Index>(v), static_cast<Index>(u), du + weight });
+          }
+        });
+      }
+    });
+
+    for (auto& out : requests) {
+      for (auto& r : out) {
+        if (r.distance_ < distance[r.node_]) {
+          distance[r.node_] = r.distance_;
+          parent[r.node_] = r.parent_;
+          size_t slot = bucketOf(r.distance_) % slots;
+          buckets[slot].Append(r.node_);
+          occupied.Set(slot);
+          ++pending;
+        }
+      }
+      out.Clear();
+    }
+  };
+
+  size_t round = 0;
+
+  for (size_t b = 0; ; ) {
+    size_t slot = b % slots;
+    settled.Clear();
+
+    while (!buckets[slot].isEmpty()) {
+      ArrayList<Index> frontier(std::move(buckets[slot]));
+      occupied.Reset(slot);
+      pending -= frontier.Size();
+      ++round;
+
+      // Drop stale entries and repeats.
+      size_t kept = 0;
+      for (size_t i = 0; i < frontier.Size(); ++i) {
+        Index v = frontier[i];
+        if (bucketOf(distance[v]) != b || taken[v] == round) {
+          continue;
+        }
+        taken[v] = round;
+        frontier[kept++] = v;
+
+        if (settledIn[v] != b) {
+          settledIn[v] = b;
+          settled.Append(v);
+        }
+      }
+
+      relax(frontier.begin(), kept, true);
+    }
+
+    if (!settled.isEmpty()) {
+      relax(settled.begin(), settled.Size(), false);
+    }
+    if (pending == 0) {
+      break;
+    }
+
+    // Every pending entry is less than slots buckets ahead, so the next
+    // occupied slot, wrapping round, is the next bucket to settle.
+    size_t next = occupied.FindNext(slot);
+    if (next == DynamicBitset::NPOS) {
+      next = occupied.FindFirst();
+    }
+    assert(next != DynamicBitset::NPOS && next != slot);
+    b += (next + slots - slot) % slots;
+  }
+
+  return tree;
+}
+
+// Fixed-size bitmap whose bits several threads may claim at once.
+class atomic_bitmap_ {
+public:
+  atomic_bitmap_(size_t bits)
+      : words_((bits + 63) / 64),
+        bits_(std::make_unique<std::atomic<uint64_t>[]>(words_)) {
+    Clear();
+  }
+
+  void Clear() {
+    for (size_t w = 0; w < words_; ++w) {
+      bits_[w].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  bool Test(size_t i) const {
+    return (bits_[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1;
+  }
+
+  // Sets bit i and returns true if this call was the one to set it.
+  bool Claim(size_t i) {
+    uint64_t mask = uint64_t(1) << (i & 63);
+    return !(bits_[i >> 6].fetch_or(mask, std::memory_order_relaxed) & mask);
+  }
+
+  size_t Words() const {
+    return words_;
+  }
+
+  uint64_t Word(size_t w) const {
+    return bits_[w].load(std::memory_order_relaxed);
+  }
+
+private:
+  size_t words_;
+  std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+};
+
+// Numbers the groups of key (a root, or any per-group id) 0, 1, ... in order
+// of each group's lowest node, so results do not depend on thread timing.
+template <class Key>
+Components number_components_(size_t count, Key&& key) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  Components result{ ArrayList<size_t>(count, NONE), 0 };
+  ArrayList<size_t> number(count, NONE);
+
+  for (size_t n = 0; n < count; ++n) {
+    size_t k = key(n);
+    if (number[k] == NONE) {
+      number[k] = result.count_++;
+    }
+    result.label_[n] = number[k];
+  }
+
+  return result;
+}
+
+// Weakly connected components by Afforest (Sutton et al.) over a
+// ConcurrentDisjointSet. Each node first links along its first ROUNDS edges,
+// which on most graphs already joins the giant component. A sample then
+// finds that component, and the final pass skips edges with both ends inside
+// it, so most of the graph's edges cost a lookup rather than a link. range
+// and target are as for depth_first_.
+template <class Range, class Target>
+Components connected_components_(size_t count, ThreadPool& pool, Range&& range, Target&& target) {
+  constexpr size_t ROUNDS = 2;
+  constexpr size_t SAMPLES = 1024;
+  constexpr size_t GRAIN = 1024;
+
+  ConcurrentDisjointSet forest(count);
+
+  auto compress = [&]() {
+    pool.ParallelFor(0, count, GRAIN * 4, [&](size_t lo, size_t hi, size_t) {
+      for (size_t n = lo; n < hi; ++n) {
+        forest.Find(n);
+      }
+    });
+  };
+
+  for (size_t round = 0; round < ROUNDS; ++round) {
+    pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t) {
+      for (size_t n = lo; n < hi; ++n) {
+        auto edges = range(n);
+        if (edges.first + round < edges.second) {
+          forest.Union(n, target(n, edges.first + round));
+        }
+      }
+    });
+    compress();
+  }
+
+  size_t giant = count;
+  if (count > 0) {
+    ArrayList<size_t> samples(SAMPLES, 0);
+    uint64_t x = 88172645463325252u;
+    for (auto& sample : samples) {
+      sample = forest.Find(_::xorshift_(x) % count);
+    }
+    quick_sort(samples.begin(), samples.end());
+
+    size_t best = 0;
+    for (size_t i = 0, j = 0; i < SAMPLES; i = j) {
+      while (j < SAMPLES && samples[j] == samples[i]) ++j;
+      if (j - i > best) {
+        best = j - i;
+        giant = samples[i];
+      }
+    }
+  }
+
+  pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t) {
+    for (size_t n = lo; n < hi; ++n) {
+      auto edges = range(n);
+      bool inGiant = forest.Find(n) == giant;
+
+      for (size_t e = edges.first + ROUNDS; e < edges.second; ++e) {
+        size_t dest = target(n, e);
+        if (!inGiant || forest.Find(dest) != giant) {
+          forest.Union(n, dest);
+        }
+      }
+    }
+  });
+  compress();
+
+  return number_components_(count, [&forest](size_t n) { return forest.Find(n); });
+}
+
+// Tarjan's strongly connected components, iterative: each frame holds a node
+// and its edge cursor, and low links propagate to the parent frame as a frame
+// is popped. Components come out, and are numbered, in reverse topological
+// order of the condensation.
+template <class Range, class Target>
+Components tarjan_(size_t count, Range&& range, Target&& target) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  struct frame_ {
+    size_t node_;
+    size_t next_;
+    size_t end_;
+  };
+
+  Components result{ ArrayList<size_t>(count, NONE), 0 };
+  ArrayList<size_t> index(count, NONE);
+  ArrayList<size_t> low(count, 0);
+  DynamicBitset onStack(count);
+  ArrayList<size_t> stack;
+  ArrayList<frame_> frames;
+  size_t counter = 0;
+
+  auto enter = [&](size_t node) {
+    index[node] = low[node] = counter++;
+    stack.Append(node);
+    onStack.Set(node);
+    auto edges = range(node);
+    frames.Append(frame_{ node, edges.first, edges.second });
+  };
+
+  for (size_t root = 0; root < count; ++root) {
+    if (index[root] != NONE) {
+      continue;
+    }
+    enter(root);
+
+    while (!frames.isEmpty()) {
+      frame_& frame = frames[frames.Size() - 1];
+      size_t v = frame.node_;
+
+      if (frame.next_ < frame.end_) {
+        size_t w = target(v, frame.next_++);
+        if (index[w] == NONE) {
+          enter(w);
+        }
+        else if (onStack[w]) {
+          low[v] = std::min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      frames.Pop();
+      if (!frames.isEmpty()) {
+        size_t parent = frames[frames.Size() - 1].node_;
+        low[parent] = std::min(low[parent], low[v]);
+      }
+
+      if (low[v] == index[v]) {
+        size_t w;
+        do {
+          w = stack.Pop();
+          onStack.Reset(w);
+          result.label_[w] = result.count_;
+        } while (w != v);
+        ++result.count_;
+      }
+    }
+  }
+
+  return result;
+}
+
+// Level-synchronous parallel BFS over nodes that pass allowed, claiming them
+// in reached. Calls found(node) once for each node reached, the start
+// included.
+template <class Edges, class Allowed, class Found>
+void parallel_reach_(size_t start, ThreadPool& pool, atomic_bitmap_& reached, Edges&& edges, Allowed&& allowed, Found&& found) {
+  constexpr size_t GRAIN = 64;
+
+  ArrayList<size_t> frontier;
+  ArrayList<ArrayList<size_t>> next(pool.Size(), ArrayList<size_t>());
+
+  reached.Claim(start);
+  found(start);
+  frontier.Append(start);
+
+  while (!frontier.isEmpty()) {
+    pool.ParallelFor(0, frontier.Size(), GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      auto& out = next[worker];
+      for (size_t i = lo; i < hi; ++i) {
+        edges(frontier.begin()[i], [&](size_t dest, double) {
+          if (!reached.Test(dest) && allowed(dest) && reached.Claim(dest)) {
+            found(dest);
+            out.Append(dest);
+          }
+        });
+      }
+    });
+
+    frontier.Clear();
+    for (auto& out : next) {
+      for (auto n : out) {
+        frontier.Append(n);
+      }
+      out.Clear();
+    }
+  }
+}
+
+// Parallel strongly connected components in the Multistep style (Slota et al.).
+// Trimming peels off nodes with no live in- or out-edge as singletons. A
+// forward-backward search from a well-connected pivot then takes the giant
+// component: its nodes are exactly those both reached from and reaching the
+// pivot. The rest is split by colouring: every node takes the largest id
+// that reaches it, so each colour's root (the node of that id) heads the
+// colour's nodes, and a backward search from the root within its colour
+// collects its component. Colours are searched in parallel and coloured
+// again until no node is left. backward iterates the transpose.
+template <class Forward, class Backward>
+Components parallel_scc_(size_t count, ThreadPool& pool, Forward&& forward, Backward&& backward) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+  constexpr size_t GRAIN = 1024;
+  constexpr size_t TRIM_PASSES = 3;
+
+  // The component of each node, by some node of it, or NONE while live.
+  ArrayList<size_t> owner(count, NONE);
+  size_t* own = owner.begin();
+
+  ArrayList<size_t> live(count, 0);
+  std::iota(live.begin(), live.end(), size_t(0));
+
+  auto compact = [&]() {
+    size_t kept = 0;
+    for (auto n : live) {
+      if (own[n] == NONE) {
+        live[kept++] = n;
+      }
+    }
+    while (live.Size() > kept) {
+      live.Pop();
+    }
+  };
+
+  // Nodes decided in one pass only become visible to the next, so the
+  // passes read a stable snapshot.
+  ArrayList<uint8_t> trim(count, 0);
+  for (size_t pass = 0; pass < TRIM_PASSES && !live.isEmpty(); ++pass) {
+    size_t trimmed = 0;
+
+    pool.ParallelFor(0, live.Size(), GRAIN, [&](size_t lo, size_t hi, size_t) {
+      for (size_t i = lo; i < hi; ++i) {
+        size_t n = live.begin()[i];
+        bool in = false;
+        bool out = false;
+        forward(n, [&](size_t dest, double) { out = out || (dest != n && own[dest] == NONE); });
+        backward(n, [&](size_t dest, double) { in = in || (dest != n && own[dest] == NONE); });
+        trim[n] = !in || !out;
+      }
+    });
+
+    for (auto n : live) {
+      if (trim[n]) {
+        own[n] = n;
+        ++trimmed;
+      }
+    }
+    compact();
+
+    if (trimmed == 0) {
+      break;
+    }
+  }
+
+  auto isLive = [own](size_t n) { return own[n] == NONE; };
+
+  if (!live.isEmpty()) {
+    size_t pivot = live[0];
+    size_t bestDegree = 0;
+    for (auto n : live) {
+      size_t out = 0;
+      size_t in = 0;
+      forward(n, [&out](size_t, double) { ++out; });
+      backward(n, [&in](size_t, double) { ++in; });
+      if (out * in > bestDegree) {
+        bestDegree = out * in;
+        pivot = n;
+      }
+    }
+
+    atomic_bitmap_ reachedForward(count);
+    atomic_bitmap_ reachedBackward(count);
+    parallel_reach_(pivot, pool, reachedForward, forward, isLive, [](size_t) {});
+    parallel_reach_(pivot, pool, reachedBackward, backward,
+      [&reachedForward](size_t n) { return reachedForward.Test(n); }, [](size_t) {});
+
+    for (auto n : live) {
+      if (reachedBackward.Test(n)) {
+        own[n] = pivot;
+      }
+    }
+    compact();
+  }
+
+  auto color = std::make_unique<std::atomic<size_t>[]>(count);
+
+  while (!live.isEmpty()) {
+    for (auto n : live) {
+      color[n].store(n, std::memory_order_relaxed);
+    }
+
+    // Push colours forward until nothing changes.
+    std::atomic<bool> changed(true);
+    while (changed) {
+      changed = false;
+      pool.ParallelFor(0, live.Size(), GRAIN, [&](size_t lo, size_t hi, size_t) {
+        bool local = false;
+        for (size_t i = lo; i < hi; ++i) {
+          size_t n = live.begin()[i];
+          size_t c = color[n].load(std::memory_order_relaxed);
+
+          forward(n, [&](size_t dest, double) {
+            if (own[dest] != NONE) {
+              return;
+            }
+            size_t seen = color[dest].load(std::memory_order_relaxed);
+            while (seen < c && !color[dest].compare_exchange_weak(seen, c, std::memory_order_relaxed)) {
+            }
+            local = local || seen < c;
+          });
+        }
+        if (local) {
+          changed = true;
+        }
+      });
+    }
+
+    ArrayList<size_t> roots;
+    for (auto n : live) {
+      if (color[n].load(std::memory_order_relaxed) == n) {
+        roots.Append(n);
+      }
+    }
+
+    // Each root's search stays inside its own colour, so the searches touch
+    // disjoint nodes and run side by side.
+    ArrayList<ArrayList<size_t>> stacks(pool.Size(), ArrayList<size_t>());
+    pool.ParallelFor(0, roots.Size(), 1, [&](size_t lo, size_t hi, size_t worker) {
+      auto& stack = stacks[worker];
+
+      for (size_t i = lo; i < hi; ++i) {
+        size_t root = roots.begin()[i];
+        own[root] = root;
+        stack.Append(root);
+
+        while (!stack.isEmpty()) {
+          size_t n = stack.Pop();
+          backward(n, [&](size_t dest, double) {
+            // Only this search writes the owners of its colour.
+            if (color[dest].load(std::memory_order_relaxed) == root && own[dest] == NONE) {
+              own[dest] = root;
+              stack.Append(dest);
+            }
+          });
+        }
+      }
+    });
+
+    compact();
+  }
+
+  return number_components_(count, [own](size_t n) { return own[n]; });
+}
+
+// Kahn's algorithm, a level at a time: in-degrees are counted in parallel,
+// and each level's nodes release their successors in parallel, a successor
+// joining the next level when its last in-edge is consumed. Nodes within a
+// level may come out in any order when the pool has more than one thread.
+// Returns nullopt if the graph has a cycle.
+template <class Edges>
+std::optional<ArrayList<size_t>> topological_sort_(size_t count, ThreadPool& pool, Edges&& edges) {
+  constexpr size_t GRAIN = 1024;
+
+  auto inDegree = std::make_unique<std::atomic<size_t>[]>(count);
+  for (size_t n = 0; n < count; ++n) {
+    inDegree[n].store(0, std::memory_order_relaxed);
+  }
+
+  pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t) {
+    for (size_t n = lo; n < hi; ++n) {
+      edges(n, [&](size_t dest, double) {
+        inDegree[dest].fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+  });
+
+  ArrayList<size_t> order(count);
+  for (size_t n = 0; n < count; ++n) {
+    if (inDegree[n].load(std::memory_order_relaxed) == 0) {
+      order.Append(n);
+    }
+  }
+
+  ArrayList<ArrayList<size_t>> next(pool.Size(), ArrayList<size_t>());
+
+  for (size_t begin = 0; begin < order.Size(); ) {
+    size_t end = order.Size();
+
+    pool.ParallelFor(begin, end, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      auto& out = next[worker];
+      for (size_t i = lo; i < hi; ++i) {
+        edges(order.begin()[i], [&](size_t dest, double) {
+          if (inDegree[dest].fetch_sub(1, std::memory_order_relaxed) == 1) {
+            out.Append(dest);
+          }
+        });
+      }
+    });
+
+    for (auto& out : next) {
+      for (auto n : out) {
+        order.Append(n);
+      }
+      out.Clear();
+    }
+    begin = end;
+  }
+
+  if (order.Size() < count) {
+    return {};
+  }
+  return order;
+}
+
+// Every edge, in node order then in the order edges(n, visit) visits them.
+template <class Edges>
+ArrayList<GraphEdge> edge_list_(size_t count, Edges&& edges) {
+  ArrayList<GraphEdge> list;
+  for (size_t n = 0; n < count; ++n) {
+    edges(n, [&](size_t dest, double weight) {
+      list.Append(GraphEdge(n, dest, weight));
+    });
+  }
+  return list;
+}
+
+// Kruskal's algorithm. The sort is stable, so of equal weights the edge
+// listed first wins, the same tie-break boruvka_ uses.
+template <class Edges>
+SpanningForest kruskal_(size_t count, Edges&& edges) {
+  auto list = edge_list_(count, edges);
+  merge_sort(list.begin(), list.end());
+
+  DisjointSet<> sets(count);
+  SpanningForest forest{ ArrayList<GraphEdge>(), 0 };
+
+  for (auto& e : list) {
+    if (sets.SetCount() == 1) {
+      break;
+    }
+    if (sets.Union(e.src_, e.dest_)) {
+      forest.edges_.Append(e);
+      forest.weight_ += e.weight_;
+    }
+  }
+
+  return forest;
+}
+
+// Borůvka's algorithm over a ConcurrentDisjointSet. Each round every
+// component takes its lightest edge out by atomic minimum, ties going to the
+// lower edge index so that the picks never close a cycle, and the picks are
+// then unioned in parallel; an edge picked from both its ends is kept only by
+// the Union that succeeds. Components at least halve each round, and edges
+// found to lie inside one are dropped for good.
+template <class Edges>
+SpanningForest boruvka_(size_t count, ThreadPool& pool, Edges&& edges) {
+  constexpr size_t GRAIN = 1024;
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  auto list = edge_list_(count, edges);
+  const GraphEdge* edge = list.begin();
+  auto lighter = [edge](size_t a, size_t b) {
+    return edge[a].weight_ < edge[b].weight_ || (edge[a].weight_ == edge[b].weight_ && a < b);
+  };
+
+  ConcurrentDisjointSet sets(count);
+  auto cheapest = std::make_unique<std::atomic<size_t>[]>(count);
+  for (size_t n = 0; n < count; ++n) {
+    cheapest[n].store(NONE, std::memory_order_relaxed);
+  }
+
+  ArrayList<size_t> live(list.Size(), 0);
+  std::iota(live.begin(), live.end(), size_t(0));
+  ArrayList<ArrayList<size_t>> kept(pool.Size(), ArrayList<size_t>());
+  ArrayList<ArrayList<size_t>> picked(pool.Size(), ArrayList<size_t>());
+  SpanningForest forest{ ArrayList<GraphEdge>(), 0 };
+
+  while (true) {
+    pool.ParallelFor(0, live.Size(), GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      for (size_t i = lo; i < hi; ++i) {
+        size_t e = live.begin()[i];
+        size_t roots[] = { sets.Find(edge[e].src_), sets.Find(edge[e].dest_) };
+        if (roots[0] == roots[1]) {
+          continue;
+        }
+
+        kept[worker].Append(e);
+        for (auto root : roots) {
+          size_t current = cheapest[root].load(std::memory_order_relaxed);
+          while ((current == NONE || lighter(e, current))
+            && !cheapest[root].compare_exchange_weak(current, e, std::memory_order_relaxed)) {
+
+          }
+        }
+      }
+    });
+
+    live.Clear();
+    for (auto& out : kept) {
+      for (auto e : out) {
+        live.Append(e);
+      }
+      out.Clear();
+    }
+    if (live.isEmpty()) {
+      break;
+    }
+
+    pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      for (size_t n = lo; n < hi; ++n) {
+        size_t e = cheapest[n].load(std::memory_order_relaxed);
+        if (e == NONE) {
+          continue;
+        }
+        cheapest[n].store(NONE, std::memory_order_relaxed);
+        if (sets.Union(edge[e].src_, edge[e].dest_)) {
+          picked[worker].Append(e);
+        }
+      }
+    });
+
+    for (auto& out : picked) {
+      for (auto e : out) {
+        forest.edges_.Append(edge[e]);
+        forest.weight_ += edge[e].weight_;
+      }
+      out.Clear();
+    }
+  }
+
+  return forest;
+}
+
+// Where PageRank's surfer restarts: anywhere, or at one of seeds, a seed
+// listed twice getting twice the share.
+inline ArrayList<double> teleport_(size_t count, const ArrayList<size_t>* seeds) {
+  if (!seeds) {
+    return ArrayList<double>(count, 1.0 / count);
+  }
+
+  assert(!seeds->isEmpty());
+  ArrayList<double> teleport(count, 0);
+  for (auto seed : *seeds) {
+    check_bounds(seed, count);
+    teleport[seed] += 1.0 / seeds->Size();
+  }
+  return teleport;
+}
+
+// The power iteration behind both PageRank kernels. Each step splits every
+// node's rank over its out-degree(n) edges, has gather(contribution, sum) fill
+// sum[v] with what flows into v, then damps, spreads rank stuck at dangling
+// nodes as teleports, and stops once the L1 change is under tolerance.
+template <class Degree, class Gather>
+RankResult power_iteration_(size_t count, ThreadPool& pool, const ArrayList<size_t>* seeds, double damping,
+                            double tolerance, size_t maxIterations, Degree&& degree, Gather&& gather) {
+  constexpr size_t GRAIN = 4096;
+
+  auto teleport = teleport_(count, seeds);
+  RankResult result{ teleport, 0, 0 };
+  ArrayList<double> contribution(count, 0);
+  ArrayList<double> sum(count, 0);
+  ArrayList<double> dangling(pool.Size(), 0);
+  ArrayList<double> change(pool.Size(), 0);
+  double* rank = result.rank_.begin();
+
+  while (result.iterations_ < maxIterations) {
+    std::fill(dangling.begin(), dangling.end(), 0.0);
+    pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      for (size_t n = lo; n < hi; ++n) {
+        size_t d = degree(n);
+        contribution[n] = d ? rank[n] / d : 0;
+        dangling[worker] += d ? 0 : rank[n];
+      }
+    });
+
+    double stuck = std::accumulate(dangling.begin(), dangling.end(), 0.0);
+    gather(static_cast<const double*>(contribution.begin()), sum.begin());
+
+    std::fill(change.begin(), change.end(), 0.0);
+    pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      for (size_t v = lo; v < hi; ++v) {
+        double r = (1 - damping) * teleport[v] + damping * (sum[v] + stuck * teleport[v]);
+        change[worker] += std::abs(r - rank[v]);
+        rank[v] = r;
+      }
+    });
+
+    ++result.iterations_;
+    result.delta_ = std::accumulate(change.begin(), change.end(), 0.0);
+    if (result.delta_ < tolerance) {
+      break;
+    }
+  }
+
+  return result;
+}
+
+// Pull PageRank: each node adds up the contributions of its in-neighbours,
+// listed by inEdges(v, visit), so every write is to a node's own sum.
+template <class Degree, class InEdges>
+RankResult pagerank_pull_(size_t count, ThreadPool& pool, const ArrayList<size_t>* seeds, double damping,
+                          double tolerance, size_t maxIterations, Degree&& degree, InEdges&& inEdges) {
+  constexpr size_t GRAIN = 1024;
+
+  return power_iteration_(count, pool, seeds, damping, tolerance, maxIterations, degree,
+    [&](const double* contribution, double* sum) {
+      pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t) {
+        for (size_t v = lo; v < hi; ++v) {
+          double s = 0;
+          inEdges(v, [&](size_t u, double) { s += contribution[u]; });
+          sum[v] = s;
+        }
+      });
+    });
+}
+
+// Push PageRank with propagation blocking (Beamer et al.). Rather than adding
+// into sum at random along each out-edge, sources write their contributions
+// into a bin per block of BLOCK targets, and each block's bin is then summed
+// into a stretch of sum that stays in cache. The targets in the bins never
+// change, so they are laid out once up front and each iteration only
+// rewrites the values: both passes stream through memory in order. Sources
+// are split into ranges of about equal edge count, each with its own part of
+// every bin, so no two threads write to one place.
+template <class Index, class Degree, class Edges>
+RankResult pagerank_push_(size_t count, ThreadPool& pool, double damping, double tolerance, size_t maxIterations,
+                          Degree&& degree, Edges&& edges) {
+  constexpr size_t BLOCK = size_t(1) << 14;
+
+  size_t blocks = (count + BLOCK - 1) / BLOCK;
+  size_t total = 0;
+  for (size_t n = 0; n < count; ++n) {
+    total += degree(n);
+  }
+
+  // Source ranges [first[r], first[r + 1]).
+  size_t ranges = 4 * pool.Size();
+  ArrayList<size_t> first(1, 0);
+  for (size_t n = 0, seen = 0; n < count; ++n) {
+    seen += degree(n);
+    if (seen * ranges >= total * first.Size() && first.Size() < ranges) {
+      first.Append(n + 1);
+    }
+  }
+  while (first.Size() <= ranges) {
+    first.Append(count);
+  }
+
+  // start[b * ranges + r] is where range r's part of bin b begins.
+  ArrayList<size_t> start(blocks * ranges + 1, 0);
+  for (size_t r = 0; r < ranges; ++r) {
+    for (size_t u = first[r]; u < first[r + 1]; ++u) {
+      edges(u, [&](size_t v, double) { ++start[(v / BLOCK) * ranges + r + 1]; });
+    }
+  }
+  std::partial_sum(start.begin(), start.end(), start.begin());
+
+  ArrayList<Index> target(total, 0);
+  ArrayList<double> value(total, 0);
+  ArrayList<size_t> cursor(start);
+  for (size_t r = 0; r < ranges; ++r) {
+    for (size_t u = first[r]; u < first[r + 1]; ++u) {
+      edges(u, [&](size_t v, double) {
+        target[cursor[(v / BLOCK) * ranges + r]++] = static_cast<Index>(v);
+      });
+    }
+  }
+
+  ArrayList<ArrayList<size_t>> cursors(pool.Size(), ArrayList<size_t>(blocks, 0));
+
+  return power_iteration_(count, pool, nullptr, damping, tolerance, maxIterations, degree,
+    [&](const double* contribution, double* sum) {
+      pool.ParallelFor(0, ranges, 1, [&](size_t lo, size_t hi, size_t worker) {
+        size_t* at = cursors[worker].begin();
+        double* out = value.begin();
+
+        for (size_t r = lo; r < hi; ++r) {
+          for (size_t b = 0; b < blocks; ++b) {
+            at[b] = start[b * ranges + r];
+          }
+          for (size_t u = first[r]; u < first[r + 1]; ++u) {
+            double c = contribution[u];
+            edges(u, [&](size_t v, double) { out[at[v / BLOCK]++] = c; });
+          }
+        }
+      });
+
+      pool.ParallelFor(0, blocks, 1, [&](size_t lo, size_t hi, size_t) {
+        const Index* to = target.begin();
+        const double* from = value.begin();
+
+        for (size_t b = lo; b < hi; ++b) {
+          std::fill(sum + b * BLOCK, sum + std::min(count, (b + 1) * BLOCK), 0.0);
+          for (size_t i = start[b * ranges], end = start[(b + 1) * ranges]; i < end; ++i) {
+            sum[to[i]] += from[i];
+          }
+        }
+      });
+    });
+}
+
+// A pseudo-random 64-bit number, never 0, from three keys (splitmix64's
+// finalizer).
+inline uint64_t draw_(uint64_t a, uint64_t b, uint64_t c) {
+  uint64_t x = a * 0x9E3779B97F4A7C15u + b * 0xC2B2AE3D27D4EB4Fu + c;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9u;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBu;
+  return (x ^ (x >> 31)) | 1;
+}
+
+// Label propagation (Raghavan et al.): each node takes the label most common
+// among its neighbours along out(n, visit) and in(n, visit) edges, until a
+// pass changes no label or maxIterations passes have run. A node keeps its
+// own label on a tie; other ties go by a hash of node, label and pass, which
+// stands in for the paper's coin flip without making runs differ and stops
+// the smallest label flooding the graph in the first pass. Labels change in
+// place, so a pass already sees the changes made earlier in it, which
+// settles in fewer passes than swapping whole arrays. With several threads
+// the labels read mid-pass depend on timing, and so may the communities.
+template <class Out, class In>
+Components label_propagation_(size_t count, ThreadPool& pool, size_t maxIterations, Out&& out, In&& in) {
+  constexpr size_t GRAIN = 1024;
+
+  auto label = std::make_unique<std::atomic<size_t>[]>(count);
+  for (size_t n = 0; n < count; ++n) {
+    label[n].store(n, std::memory_order_relaxed);
+  }
+
+  // Per thread, an open-addressed table of (label, count), a power of two at
+  // least twice the largest neighbourhood seen, and the slots in use.
+  using slot = std::pair<size_t, size_t>;
+  constexpr size_t EMPTY = std::numeric_limits<size_t>::max();
+  ArrayList<ArrayList<slot>> tables(pool.Size(), ArrayList<slot>());
+  ArrayList<ArrayList<size_t>> used(pool.Size(), ArrayList<size_t>());
+  ArrayList<size_t> changed(pool.Size(), 0);
+
+  for (size_t pass = 0; pass < maxIterations; ++pass) {
+    std::fill(changed.begin(), changed.end(), size_t(0));
+
+    pool.ParallelFor(0, count, GRAIN, [&](size_t lo, size_t hi, size_t worker) {
+      auto& table = tables[worker];
+      auto& slots = used[worker];
+      size_t mask = 0;
+
+      auto tally = [&](size_t v, double) {
+        size_t l = label[v].load(std::memory_order_relaxed);
+        size_t h = ((l * 0x9E3779B97F4A7C15u) >> 32) & mask;
+        while (table[h].first != l && table[h].first != EMPTY) {
+          h = (h + 1) & mask;
+        }
+        if (table[h].first == EMPTY) {
+          table[h].first = l;
+          slots.Append(h);
+        }
+        ++table[h].second;
+      };
+
+      for (size_t n = lo; n < hi; ++n) {
+        size_t degree = 0;
+        auto counter = [&degree](size_t, double) { ++degree; };
+        out(n, counter);
+        in(n, counter);
+        if (degree == 0) {
+          continue;
+        }
+
+        if (2 * degree > table.Size()) {
+          size_t size = 16;
+          while (size < 2 * degree) {
+            size *= 2;
+          }
+          table = ArrayList<slot>(size, slot(EMPTY, 0));
+        }
+        mask = table.Size() - 1;
+        out(n, tally);
+        in(n, tally);
+
+        size_t current = label[n].load(std::memory_order_relaxed);
+        size_t best = current;
+        size_t bestCount = 0;
+        uint64_t bestDraw = 0;
+
+        for (auto h : slots) {
+          size_t l = table[h].first;
+          uint64_t draw = l == current ? 0 : draw_(n, l, pass);
+          if (table[h].second > bestCount || (table[h].second == bestCount && draw < bestDraw)) {
+            best = l;
+            bestCount = table[h].second;
+            bestDraw = draw;
+          }
+          table[h] = slot(EMPTY, 0);
+        }
+        slots.Clear();
+
+        if (best != current) {
+          label[n].store(best, std::memory_order_relaxed);
+          ++changed[worker];
+        }
+      }
+    });
+
+    if (std::accumulate(changed.begin(), changed.end(), size_t(0)) == 0) {
+      break;
+    }
+  }
+
+  return number_components_(count, [&label](size_t n) { return label[n].load(std::memory_order_relaxed); });
+}
+
+// Neighbour lists in CSR form: nodes_[offsets_[n], offsets_[n + 1]).
+struct adjacency_ {
+  ArrayList<size_t> offsets_;
+  ArrayList<size_t> nodes_;
+
+  size_t Degree(size_t n) const {
+    return offsets_.begin()[n + 1] - offsets_.begin()[n];
+  }
+
+  const size_t* begin(size_t n) const {
+    return nodes_.begin() + offsets_.begin()[n];
+  }
+
+  const size_t* end(size_t n) const {
+    return nodes_.begin() + offsets_.begin()[n + 1];
+  }
+};
+
+// The out-neighbours (forward), in-neighbours (backward) or both of every
+// node, as listed by edges(n, visit).
+template <class Edges>
+adjacency_ adjacency_of_(size_t count, Edges&& edges, bool forward, bool backward) {
+  adjacency_ adj{ ArrayList<size_t>(count + 1, 0), ArrayList<size_t>() };
+  size_t* offsets = adj.offsets_.begin();
+
+  for (size_t n = 0; n < count; ++n) {
+    edges(n, [&](size_t v, double) {
+      offsets[n + 1] += forward;
+      offsets[v + 1] += backward;
+    });
+  }
+  std::partial_sum(offsets, offsets + count + 1, offsets);
+
+  adj.nodes_ = ArrayList<size_t>(offsets[count], 0);
+  ArrayList<size_t> cursor(adj.offsets_);
+  for (size_t n = 0; n < count; ++n) {
+    edges(n, [&](size_t v, double) {
+      if (forward) {
+        adj.nodes_[cursor[n]++] = v;
+      }
+      if (backward) {
+        adj.nodes_[cursor[v]++] = n;
+      }
+    });
+  }
+
+  return adj;
+}
+
+// The permutation numbering order[i] as i.
+inline ArrayList<size_t> number_in_order_(const ArrayList<size_t>& order) {
+  ArrayList<size_t> permutation(order.Size(), 0);
+  for (size_t i = 0; i < order.Size(); ++i) {
+    permutation[order.begin()[i]] = i;
+  }
+  return permutation;
+}
+
+// order[i] is the node permutation numbers i. Asserts permutation is one,
+// and checks it numbers exactly count nodes.
+inline ArrayList<size_t> order_of_(const ArrayList<size_t>& permutation, size_t count) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+  check_bounds(permutation.Size(), count + 1);
+  check_bounds(count, permutation.Size() + 1);
+
+  ArrayList<size_t> order(permutation.Size(), NONE);
+  for (size_t n = 0; n < permutation.Size(); ++n) {
+    size_t i = permutation.begin()[n];
+    check_bounds(i, order.Size());
+    assert(order[i] == NONE);
+    order[i] = n;
+  }
+  return order;
+}
+
+// Breadth-first from start, recording each node's depth and listing the
+// nodes reached in reached. Returns the depth of the last level.
+inline size_t levels_(const adjacency_& adj, size_t start, ArrayList<size_t>& depth, ArrayList<size_t>& reached) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  reached.Clear();
+  reached.Append(start);
+  depth[start] = 0;
+
+  for (size_t i = 0; i < reached.Size(); ++i) {
+    size_t u = reached[i];
+    for (auto v = adj.begin(u); v != adj.end(u); ++v) {
+      if (depth[*v] == NONE) {
+        depth[*v] = depth[u] + 1;
+        reached.Append(*v);
+      }
+    }
+  }
+
+  return depth[reached[reached.Size() - 1]];
+}
+
+// Reverse Cuthill-McKee over adj, an undirected view. Each component is
+// numbered breadth-first from a pseudo-peripheral node (George and Liu: keep
+// restarting from the lowest-degree node of the last level while that
+// deepens the search), taking each node's new neighbours by increasing
+// degree, and the whole order is then reversed.
+inline ArrayList<size_t> cuthill_mckee_(const adjacency_& adj) {
+  constexpr size_t NONE = std::numeric_limits<size_t>::max();
+  constexpr size_t RESTARTS = 8;
+
+  size_t count = adj.offsets_.Size() - 1;
+  ArrayList<size_t> depth(count, NONE);
+  ArrayList<size_t> reached;
+  ArrayList<size_t> order(count);
+  ArrayList<bool> placed(count, false);
+  ArrayList<size_t> fresh;
+  auto fewer = [&adj](size_t a, size_t b) { return adj.Degree(a) < adj.Degree(b); };
+
+  for (size_t s = 0; s < count; ++s) {
+    if (placed[s]) {
+      continue;
+    }
+
+    size_t start = s;
+    size_t eccentricity = levels_(adj, start, depth, reached);
+    for (size_t restart = 0; restart < RESTARTS; ++restart) {
+      size_t candidate = reached[reached.Size() - 1];
+      for (size_t i = reached.Size(); i-- > 0 && depth[reached[i]] == eccentricity; ) {
+        if (adj.Degree(reached[i]) <= adj.Degree(candidate)) {
+          candidate = reached[i];
+        }
+      }
+
+      for (auto n : reached) {
+        depth[n] = NONE;
+      }
+      size_t deeper = levels_(adj, candidate, depth, reached);
+      if (deeper <= eccentricity) {
+        break;
+      }
+      start = candidate;
+      eccentricity = deeper;
+    }
+    for (auto n : reached) {
+      depth[n] = NONE;
+    }
+
+    size_t head = order.Size();
+    order.Append(start);
+    placed[start] = true;
+
+    for (; head < order.Size(); ++head) {
+      size_t u = order[head];
+      fresh.Clear();
+      for (auto v = adj.begin(u); v != adj.end(u); ++v) {
+        if (!placed[*v]) {
+          placed[*v] = true;
+          fresh.Append(*v);
+        }
+      }
+
+      merge_sort(fresh.begin(), fresh.end(), fewer);
+      for (auto v : fresh) {
+        order.Append(v);
+      }
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return number_in_order_(order);
+}
+
+// Nodes by degree in adj, highest first, ties kept in id order.
+inline ArrayList<size_t> degree_order_(const adjacency_& adj) {
+  size_t count = adj.offsets_.Size() - 1;
+  ArrayList<size_t> order(count, 0);
+  std::iota(order.begin(), order.end(), size_t(0));
+
+  merge_sort(order.begin(), order.end(), [&adj](size_t a, size_t b) { return adj.Degree(a) > adj.Degree(b); });
+  return number_in_order_(order);
+}
+
+// Max-priority queue of the nodes 0 to count - 1 whose keys only ever move by
+// one, as Gorder's scores do: each key is a doubly-linked bucket list, so a
+// step up or down is O(1), and Pop walks the top bucket index down past
+// empty buckets, which costs no more than the steps up that filled them.
+class unit_heap_ {
+public:
+  static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  // Every node starts queued with key 0.
+  unit_heap_(size_t count)
+      : key_(count, 0),
+        prev_(count, NONE),
+        next_(count, NONE),
+        head_(1, NONE),
+        top_(0) {
+    for (size_t n = count; n-- > 0; ) {
+      link(n);
+    }
+  }
+
+  bool Contains(size_t n) const {
+    return key_.begin()[n] != NONE;
+  }
+
+  void Increment(size_t n) {
+    unlink(n);
+    if (++key_[n] == head_.Size()) {
+      head_.Append(NONE);
+    }
+    top_ = std::max(top_, key_[n]);
+    link(n);
+  }
+
+  void Decrement(size_t n) {
+    unlink(n);
+    --key_[n];
+    link(n);
+  }
+
+  // Takes n out of the queue.
+  void Erase(size_t n) {
+    unlink(n);
+    key_[n] = NONE;
+  }
+
+  // Removes and returns a node with the highest key, or NONE if empty.
+  size_t Pop() {
+    while (head_[top_] == NONE) {
+      if (top_ == 0) {
+        return NONE;
+      }
+      --top_;
+    }
+    size_t n = head_[top_];
+    Erase(n);
+    return n;
+  }
+
+private:
+  ArrayList<size_t> key_;
+  ArrayList<size_t> prev_;
+  ArrayList<size_t> next_;
+  ArrayList<size_t> head_;
+  size_t top_;
+
+  void link(size_t n) {
+    size_t& head = head_[key_[n]];
+    prev_[n] = NONE;
+    next_[n] = head;
+    if (head != NONE) {
+      prev_[head] = n;
+    }
+    head = n;
+  }
+
+  void unlink(size_t n) {
+    if (prev_[n] != NONE) {
+      next_[prev_[n]] = next_[n];
+    }
+    else {
+      head_[key_[n]] = next_[n];
+    }
+    if (next_[n] != NONE) {
+      prev_[next_[n]] = prev_[n];
+    }
+  }
+};
+
+// Gorder (Wei et al.): greedily numbers next the node that has most in common
+// with the last window nodes numbered, a pair scoring one per edge between
+// them and one per in-neighbour they share. Scores live in a unit_heap_ and
+// step up and down as nodes enter and leave the window. Shared in-neighbours
+// with more than hub out-edges are not expanded, as in the paper: their
+// fan-out would dominate the running time while saying little about
+// locality.
+inline ArrayList<size_t> gorder_(const adjacency_& out, const adjacency_& in, size_t window) {
+  size_t count = out.offsets_.Size() - 1;
+  size_t hub = std::max<size_t>(32, static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+
+  unit_heap_ score(count);
+  size_t first = 0;
+  for (size_t n = 0; n < count; ++n) {
+    if (in.Degree(n) > in.Degree(first)) {
+      first = n;
+    }
+  }
+
+  auto add = [&score](size_t u, bool enter) {
+    if (score.Contains(u)) {
+      if (enter) {
+        score.Increment(u);
+      }
+      else {
+        score.Decrement(u);
+      }
+    }
+  };
+
+  auto slide = [&](size_t v, bool enter) {
+    for (auto u = out.begin(v); u != out.end(v); ++u) {
+      add(*u, enter);
+    }
+    for (auto x = in.begin(v); x != in.end(v); ++x) {
+      add(*x, enter);
+      if (out.Degree(*x) <= hub) {
+        for (auto u = out.begin(*x); u != out.end(*x); ++u) {
+          if (*u != v) {
+            add(*u, enter);
+          }
+        }
+      }
+    }
+  };
+
+  ArrayList<size_t> order(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t v = first;
+    if (i == 0) {
+      score.Erase(v);
+    }
+    else {
+      v = score.Pop();
+    }
+
+    order.Append(v);
+    slide(v, true);
+    if (i >= window) {
+      slide(order[i - window], false);
+    }
+  }
+
+  return number_in_order_(order);
+}
+
+// k-way edge-cut partition of adj, an undirected view. The reverse
+// Cuthill-McKee order, which keeps neighbours close, is cut into parts runs
+// of equal length; then, for up to PASSES passes, each node moves to the
+// part holding most of its neighbours if that part stays within
+// (1 + imbalance) times an even share.
+inline GraphPartition partition_(const adjacency_& adj, size_t parts, double imbalance) {
+  constexpr size_t PASSES = 8;
+  assert(parts > 0);
+
+  size_t count = adj.offsets_.Size() - 1;
+  GraphPartition result{ cuthill_mckee_(adj), parts, 0 };
+  ArrayList<size_t> size(parts, 0);
+  for (auto& part : result.part_) {
+    part = part * parts / std::max<size_t>(count, 1);
+    ++size[part];
+  }
+
+  size_t even = (count + parts - 1) / parts;
+  size_t capacity = std::max(even, static_cast<size_t>(std::ceil(static_cast<double>(count) / parts * (1 + imbalance))));
+  ArrayList<size_t> tally(parts, 0);
+  ArrayList<size_t> touched;
+
+  for (size_t pass = 0; pass < PASSES; ++pass) {
+    size_t moved = 0;
+
+    for (size_t n = 0; n < count; ++n) {
+      for (auto v = adj.begin(n); v != adj.end(n); ++v) {
+        size_t part = result.part_[*v];
+        if (tally[part]++ == 0) {
+          touched.Append(part);
+        }
+      }
+
+      size_t current = result.part_[n];
+      size_t best = current;
+      for (auto part : touched) {
+        if (tally[part] > tally[best] && size[part] < capacity) {
+          best = part;
+        }
+      }
+      for (auto part : touched) {
+        tally[part] = 0;
+      }
+      touched.Clear();
+
+      if (best != current) {
+        --size[current];
+        ++size[best];
+        result.part_[n] = best;
+        ++moved;
+      }
+    }
+
+    if (moved == 0) {
+      break;
+    }
+  }
+
+  for (size_t n = 0; n < count; ++n) {
+    for (auto v = adj.begin(n); v != adj.end(n); ++v) {
+      result.cut_ += result.part_[*v] != result.part_[n];
+    }
+  }
+  result.cut_ /= 2;
+
+  return result;
+}
+
+} // namespace _
+
+// Index is the type node indices are stored as, in edges and in the
+// algorithms' bookkeeping. uint32_t halves the edge lists of graphs under
+// 4G nodes; the public interface takes and returns size_t either way.
+template <class T, class Index = size_t>
 class AdjacencyListGraph {
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
+
+
+private:
+
+  using Edge = GraphEdge;
+
+  // An edge as stored in its source's list; the source is the list's index.
+  struct Arc {
+    Index dest_;
+    double weight_;
+  };
+
+  ArrayList<T> values_;
+  ArrayList<ArrayList<Arc>> adj_;
+  size_t edge_count_;
+  size_t reserve_degree_;
+
+  // The const operator[] of ArrayList copies, so reach the lists through the
+  // raw array.
+  const ArrayList<Arc>& arcs(size_t node) const {
+    return adj_.begin()[node];
+  }
+
+public:
+  AdjacencyListGraph()
+      : values_(),
+        adj_(),
+        edge_count_(0),
+        reserve_degree_(0) {
+
+  }
+
+  AdjacencyListGraph(size_t num_nodes, std::initializer_list<T>&& nodes, std::initializer_list<Edge>&& edges) 
+      : AdjacencyListGraph() {
+    Reserve(num_nodes, edges.size());
+    for (auto val : nodes) {
+      AddNode(std::move(val));
+    }
+    AddEdges(edges.begin(), edges.end());
+  }
+
+  ~AdjacencyListGraph() {
+
+  }
+
+  size_t NodeCount() const {
+    return values_.Size();
+  }
+
+  size_t EdgeCount() const {
+    return edge_count_;
+  }
 
-private:
+  const T& Value(size_t node) const {
+    check_bounds(node, NodeCount());
+    return values_.begin()[node];
+  }
 
-  struct Edge {
-    size_t src_;
-    size_t dest_;
-    double weight_;
+  size_t Degree(size_t node) const {
+    check_bounds(node, NodeCount());
+    return arcs(node).Size();
+  }
+
+  // Makes room for nodes in total and gives each node added afterwards space
+  // for its share of edges, so a graph of known size is built without
+  // regrowing its arrays.
+  void Reserve(size_t nodes, size_t edges) {
+    values_.Reserve(nodes);
+    adj_.Reserve(nodes);
+    reserve_degree_ = nodes > 0 ? edges / nodes : 0;
+  }
+
+  // Returns the new node's index.
+  size_t AddNode(T value = T{}) {
+    assert(values_.Size() < std::numeric_limits<Index>::max());
+    values_.Append(std::move(value));
+    adj_.Append(ArrayList<Arc>());
+    adj_[adj_.Size() - 1].Reserve(reserve_degree_);
+    return values_.Size() - 1;
+  }
+
+  // Amortized O(1).
+  void AddEdge(size_t src, size_t dest, double weight = 1.0) {
+    check_bounds(src, NodeCount());
+    check_bounds(dest, NodeCount());
+
+    adj_[src].Append(Arc{ static_cast<Index>(dest), weight });
+    ++edge_count_;
+  }
 
-    Edge()
-        : src_(0),
-          dest_(0),
-          weight_(0) {
+  // Adds [first, last) of GraphEdge (or anything with src_, dest_ and
+  // weight_). A forward range is counted first so each source list grows at
+  // most once.
+  template <typename InputIterator>
+  void AddEdges(InputIterator first, InputIterator last) {
+    using category = typename std::iterator_traits<InputIterator>::iterator_category;
+
+    if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+      ArrayList<size_t> degree(NodeCount(), 0);
+      for (auto it = first; it != last; ++it) {
+        check_bounds(it->src_, NodeCount());
+        ++degree[it->src_];
+      }
+      for (size_t i = 0; i < NodeCount(); ++i) {
+        if (degree[i] > 0) {
+          adj_[i].Reserve(adj_[i].Size() + degree[i]);
+        }
+      }
+    }
 
+    for (; first != last; ++first) {
+      AddEdge(first->src_, first->dest_, first->weight_);
     }
+  }
+
+  void AddEdges(std::initializer_list<Edge> edges) {
+    AddEdges(edges.begin(), edges.end());
+  }
 
-    Edge(size_t src, size_t dest, double weight = 1.0) 
-        : src_(src),
-          dest_(dest),
-          weight_(weight) {
+  // Removes the first edge from src to dest, keeping the order of the rest.
+  // Returns false if there is none. O(Degree(src)).
+  bool RemoveEdge(size_t src, size_t dest) {
+    check_bounds(src, NodeCount());
+    auto& list = adj_[src];
 
+    for (size_t i = 0; i < list.Size(); ++i) {
+      if (list[i].dest_ == dest) {
+        list.Remove(i);
+        --edge_count_;
+        return true;
+      }
     }
 
-    bool operator< (const Edge& other) const { return weight_ < other.weight_; }
-    bool operator> (const Edge& other) const { return other.weight_ < weight_; }
-    bool operator<=(const Edge& other) const { return !(weight_ > other.weight_); }
-    bool operator>=(const Edge& other) const { return !(weight_ < other.weight_); }
-  }; // struct Edge
+    return false;
+  }
+
+  // Removes node and every edge into or out of it. The last node moves into
+  // the freed index, so only that node is renumbered. O(V + E).
+  void RemoveNode(size_t node) {
+    check_bounds(node, NodeCount());
+    size_t last = NodeCount() - 1;
+
+    edge_count_ -= adj_[node].Size();
 
-  struct Node {
-    std::unique_ptr<T> value_;
-    SLList<Edge> adj_;
+    for (size_t i = 0; i < NodeCount(); ++i) {
+      if (i == node) {
+        continue;
+      }
+
+      auto& list = adj_[i];
+      size_t kept = 0;
 
-    Node()
-        : value_(),
-          adj_() {
+      for (size_t j = 0; j < list.Size(); ++j) {
+        Arc arc = list[j];
+        if (arc.dest_ == node) {
+          continue;
+        }
+        if (arc.dest_ == last) {
+          arc.dest_ = static_cast<Index>(node);
+        }
+        list[kept++] = arc;
+      }
 
+      edge_count_ -= list.Size() - kept;
+      while (list.Size() > kept) {
+        list.Remove(list.Size() - 1);
+      }
     }
 
-    Node(const T& value)
-        : value_(std::make_unique<T>(value)),
-          adj_() {
+    if (node != last) {
+      values_[node] = std::move(values_[last]);
+      adj_[node] = std::move(adj_[last]);
+    }
+    values_.Remove(last);
+    adj_.Remove(last);
+  }
 
+  // Reads a whitespace-separated edge list, one "src dest [weight]" per line
+  // with '#' or '%' starting a comment line, adding nodes as their indices
+  // appear. A %%MatrixMarket coordinate banner switches to that format: the
+  // "rows columns entries" size line adds the nodes, ids are 1-based, and a
+  // symmetric matrix adds each off-diagonal entry in both directions.
+  // Returns the number of edges added, or nullopt if the file cannot be
+  // opened or a line does not parse; edges read before a bad line are kept.
+  std::optional<size_t> LoadEdgeList(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+      return {};
     }
 
-    Node(T&& value)
-        : value_(std::make_unique<T>(std::move(value))),
-          adj_() {
+    constexpr size_t CHUNK = size_t(1) << 20;
+    std::string buffer;
+    std::string carry;
+    size_t added = 0;
 
+    // Matrix Market state: whether the banner was seen, whether its size
+    // line is still to come, and whether entries mirror across the diagonal.
+    bool matrixMarket = false;
+    bool sizePending = false;
+    bool symmetric = false;
+
+    auto parseLine = [&](const char* p, const char* end) {
+      auto skip = [&p, end]() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')) ++p;
+      };
+
+      constexpr std::string_view BANNER = "%%MatrixMarket";
+      if (!matrixMarket && added == 0 && std::string_view(p, end - p).substr(0, BANNER.size()) == BANNER) {
+        std::string banner(p, end);
+        std::transform(banner.begin(), banner.end(), banner.begin(), [](char c) {
+          return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        });
+        if (banner.find("coordinate") == std::string::npos) {
+          return false;
+        }
+        matrixMarket = true;
+        sizePending = true;
+        symmetric = banner.find("symmetric") != std::string::npos || banner.find("hermitian") != std::string::npos;
+        return true;
+      }
+
+      skip();
+      if (p == end || *p == '#' || *p == '%') {
+        return true;
+      }
+
+      if (sizePending) {
+        size_t rows = 0;
+        size_t columns = 0;
+        auto r = std::from_chars(p, end, rows);
+        if (r.ec != std::errc()) return false;
+        p = r.ptr;
+        skip();
+        r = std::from_chars(p, end, columns);
+        if (r.ec != std::errc()) return false;
+
+        while (NodeCount() < std::max(rows, columns)) {
+          AddNode();
+        }
+        sizePending = false;
+        return true;
+      }
+
+      size_t src = 0;
+      size_t dest = 0;
+      double weight = 1.0;
+
+      auto r = std::from_chars(p, end, src);
+      if (r.ec != std::errc()) return false;
+      p = r.ptr;
+      skip();
+
+      r = std::from_chars(p, end, dest);
+      if (r.ec != std::errc()) return false;
+      p = r.ptr;
+      skip();
+
+      if (p < end) {
+        r = std::from_chars(p, end, weight);
+        if (r.ec != std::errc()) return false;
+      }
+
+      if (matrixMarket) {
+        if (src == 0 || dest == 0) return false;
+        --src;
+        --dest;
+      }
+
+      while (NodeCount() <= std::max(src, dest)) {
+        AddNode();
+      }
+      AddEdge(src, dest, weight);
+      ++added;
+
+      if (symmetric && src != dest) {
+        AddEdge(dest, src, weight);
+        ++added;
+      }
+      return true;
+    };
+
+    while (in) {
+      buffer.resize(CHUNK);
+      in.read(&buffer[0], CHUNK);
+      buffer.resize(static_cast<size_t>(in.gcount()));
+
+      const char* p = buffer.data();
+      const char* end = p + buffer.size();
+
+      while (p < end) {
+        const char* eol = std::find(p, end, '\n');
+        if (eol == end) {
+          carry.append(p, end);
+          break;
+        }
+
+        const char* line = p;
+        const char* lineEnd = eol;
+
+        if (!carry.empty()) {
+          carry.append(p, eol);
+          line = carry.data();
+          lineEnd = line + carry.size();
+        }
+
+        if (!parseLine(line, lineEnd)) {
+          return {};
+        }
+        carry.clear();
+        p = eol + 1;
+      }
     }
 
-    Node(Node&& other)
-        : value_(std::move(other.value_)),
-          adj_(std::move(other.adj_)) {
-      other.value_.reset();
+    if (!carry.empty() && !parseLine(carry.data(), carry.data() + carry.size())) {
+      return {};
     }
 
-    ~Node() {
+    return added;
+  }
 
+  // Calls f(dest, weight) for each edge out of node.
+  template <class Func>
+  void ForEachEdge(size_t node, Func&& f) const {
+    for (auto& arc : arcs(node)) {
+      f(arc.dest_, arc.weight_);
     }
-  }; // struct Node
+  }
+
+  template <class Func>
+  void DFS(size_t start, Func& f) const {
+    TraversalContext context;
+    DFS(start, context, f);
+  }
+
+  // pre(node) runs as a node is entered and post(node) as it is left. Either
+  // may return a TraversalAction; void callbacks always continue. Returns
+  // false if a callback stopped the traversal. Resets context first.
+  template <class Pre, class Post = _::no_visit_>
+  bool DFS(size_t start, TraversalContext& context, Pre& pre, Post&& post = Post()) const {
+    check_bounds(start, NodeCount());
+    context.Reset(NodeCount());
+    return DFSFrom(start, context, pre, post);
+  }
 
-  ArrayList<std::shared_ptr<Node>> nodes_;
-  ArrayList<Edge> edges_;
+  // As DFS, but keeps what context has visited since its last Reset, e.g. to
+  // sweep every component in one pass.
+  template <class Pre, class Post = _::no_visit_>
+  bool DFSFrom(size_t start, TraversalContext& context, Pre& pre, Post&& post = Post()) const {
+    return _::depth_first_(start, context,
+      [this](size_t node) { return std::make_pair(size_t(0), arcs(node).Size()); },
+      [this](size_t node, size_t i) { return static_cast<size_t>(arcs(node).begin()[i].dest_); },
+      pre, post);
+  }
 
   template <class Func>
-  void DFSImpl(size_t start, ArrayList<bool>& visited, Func& f) const {
-    visited[start] = true;
-    f(start);
+  ArrayList<size_t> BFS(size_t start, size_t end, Func& f) const {
+    auto n = NodeCount();
+    DynamicBitset visited(n);
+    ArrayList<Index> prev(n, 0);
+
+    Queue<size_t> q;
+    q.Push(start);
+    visited.Set(start);
+   
+    ArrayList<size_t> path;
+
+    while (!q.isEmpty()) {
+      auto current = q.Pop();
+      f(current);
+
+      if (current == end) {
+        _::make_path_(start, end, prev, path);
+        break;
+      }
 
-    for (auto edge : nodes_[start]->adj_) {
-      auto node = edge.dest_;
-      if (!visited[node]) {
-        DFSImpl(node, visited, f);
+      for (auto& arc : arcs(current)) {
+        if (!visited.TestAndSet(arc.dest_)) {
+          prev[arc.dest_] = static_cast<Index>(current);
+          q.Push(arc.dest_);
+        }
       }
     }
+
+    return path;
   }
 
-  void makePath(size_t start, size_t end, const ArrayList<size_t>& prev, ArrayList<size_t>& out_path) {
-    size_t p = end;
+  // Queue picks the priority queue: the default IndexedHeap<double, MinHeap>,
+  // PairingHeap<std::pair<double, size_t>>, BinHeap<std::pair<double, size_t>, MinHeap>,
+  // or RadixHeap<uint64_t, size_t> when every weight is a non-negative integer.
+  template <class Queue = IndexedHeap<double, MinHeap>>
+  std::pair<ArrayList<size_t>, double> Dikstras(size_t start, size_t end) const {
+    return _::shortest_path_<Queue, Index>(NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
 
-    out_path.Append(p);
+  // As Dikstras with the default queue, but reusing context's buffers across
+  // queries and writing the path into path, which keeps its storage too.
+  // Returns the distance. Repeated queries on graphs no larger than the
+  // first allocate nothing once path has held the longest result.
+  double Dikstras(size_t start, size_t end, PathContext& context, ArrayList<size_t>& path) const {
+    return _::context_path_(context, NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, path);
+  }
+
+  // A* towards end: heuristic(node) estimates the remaining distance from
+  // node to end and must be consistent (see _::shortest_path_), e.g. the
+  // straight-line distance when weights are lengths. Same result as Dikstras,
+  // usually after settling far fewer nodes.
+  template <class Heuristic, class Queue = IndexedHeap<double, MinHeap>>
+  std::pair<ArrayList<size_t>, double> AStar(size_t start, size_t end, Heuristic&& heuristic) const {
+    return _::shortest_path_<Queue, Index>(NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, heuristic);
+  }
+
+  // The same nodes with every edge reversed.
+  AdjacencyListGraph Transpose() const {
+    AdjacencyListGraph reversed;
+    reversed.Reserve(NodeCount(), EdgeCount());
+
+    for (size_t n = 0; n < NodeCount(); ++n) {
+      reversed.AddNode(Value(n));
+    }
+    for (size_t n = 0; n < NodeCount(); ++n) {
+      ForEachEdge(n, [&reversed, n](size_t dest, double weight) {
+        reversed.AddEdge(dest, n, weight);
+      });
+    }
+
+    return reversed;
+  }
+
+  // Point-to-point search from both ends; reverse is Transpose(), built once
+  // and reused across queries (or the graph itself when it is undirected).
+  std::pair<ArrayList<size_t>, double> BidirectionalDikstras(size_t start, size_t end, const AdjacencyListGraph& reverse) const {
+    return _::bidirectional_path_<Index>(NodeCount(), start, end,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&reverse](size_t n, auto&& visit) { reverse.ForEachEdge(n, visit); });
+  }
+
+  // Distances and parents from start to every node, by parallel
+  // delta-stepping. delta <= 0 picks the mean edge weight.
+  ShortestPathTree DeltaStepping(size_t start, ThreadPool& pool, double delta = 0) const {
+    check_bounds(start, NodeCount());
+    return _::delta_stepping_<Index>(NodeCount(), start, delta, pool, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  std::pair<ArrayList<size_t>, double> DeltaStepping(size_t start, size_t end, ThreadPool& pool, double delta = 0) const {
+    check_bounds(end, NodeCount());
+    return DeltaStepping(start, pool, delta).PathTo(end);
+  }
+
+  // Weakly connected components: edges count in either direction.
+  Components ConnectedComponents(ThreadPool& pool) const {
+    return _::connected_components_(NodeCount(), pool,
+      [this](size_t node) { return std::make_pair(size_t(0), arcs(node).Size()); },
+      [this](size_t node, size_t i) { return static_cast<size_t>(arcs(node).begin()[i].dest_); });
+  }
+
+  // Serial, by Tarjan's algorithm; components are numbered in reverse
+  // topological order, so every edge between two of them runs from a higher
+  // label to a lower one.
+  Components StronglyConnectedComponents() const {
+    return _::tarjan_(NodeCount(),
+      [this](size_t node) { return std::make_pair(size_t(0), arcs(node).Size()); },
+      [this](size_t node, size_t i) { return static_cast<size_t>(arcs(node).begin()[i].dest_); });
+  }
+
+  // Parallel, by trimming, forward-backward search and colouring; transpose is
+  // Transpose(). Components are numbered in order of their lowest node.
+  Components StronglyConnectedComponents(const AdjacencyListGraph& transpose, ThreadPool& pool) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::parallel_scc_(NodeCount(), pool,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  // Nodes ordered so every edge points forward, or nullopt if there is a
+  // cycle. With one thread the order is Kahn's breadth-first one.
+  std::optional<ArrayList<size_t>> TopologicalSort(ThreadPool& pool) const {
+    return _::topological_sort_(NodeCount(), pool, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  std::optional<ArrayList<size_t>> TopologicalSort() const {
+    ThreadPool pool(1);
+    return TopologicalSort(pool);
+  }
+
+  // Minimum spanning forest by Kruskal's algorithm, edges taken as undirected.
+  SpanningForest KruskalMST() const {
+    return _::kruskal_(NodeCount(), [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  // Minimum spanning forest by parallel Borůvka. Ties in weight are broken as
+  // KruskalMST breaks them, so both pick the same edges.
+  SpanningForest BoruvkaMST(ThreadPool& pool) const {
+    return _::boruvka_(NodeCount(), pool, [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  // PageRank by pulling: each node adds up what its in-neighbours send it,
+  // found through transpose, a Transpose() of this graph. Edge weights are
+  // ignored, and rank stuck at nodes without out-edges is spread like a
+  // teleport. Stops when an iteration changes the ranks by less than
+  // tolerance in total, or after maxIterations.
+  RankResult PageRank(const AdjacencyListGraph& transpose, ThreadPool& pool, double damping = 0.85,
+                      double tolerance = 1e-6, size_t maxIterations = 100) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::pagerank_pull_(NodeCount(), pool, nullptr, damping, tolerance, maxIterations,
+      [this](size_t n) { return arcs(n).Size(); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  // PageRank by pushing along out-edges, binned by target so that the sums
+  // stay in cache. Needs no transpose.
+  RankResult PageRank(ThreadPool& pool, double damping = 0.85, double tolerance = 1e-6,
+                      size_t maxIterations = 100) const {
+    return _::pagerank_push_<Index>(NodeCount(), pool, damping, tolerance, maxIterations,
+      [this](size_t n) { return arcs(n).Size(); },
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  // PageRank whose surfer restarts only at seeds, so rank measures closeness
+  // to them.
+  RankResult PersonalizedPageRank(const ArrayList<size_t>& seeds, const AdjacencyListGraph& transpose,
+                                  ThreadPool& pool, double damping = 0.85, double tolerance = 1e-6,
+                                  size_t maxIterations = 100) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::pagerank_pull_(NodeCount(), pool, &seeds, damping, tolerance, maxIterations,
+      [this](size_t n) { return arcs(n).Size(); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  // Communities by label propagation, edges counting in either direction;
+  // transpose is Transpose(). Numbered in order of their lowest node.
+  Components LabelPropagation(const AdjacencyListGraph& transpose, ThreadPool& pool,
+                              size_t maxIterations = 20) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::label_propagation_(NodeCount(), pool, maxIterations,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  // Orders to renumber the graph by for locality, through Relabel. Each gives
+  // every node's new id, permutation[node]. Reverse Cuthill-McKee numbers
+  // nodes breadth-first, edges taken as undirected, so neighbours get nearby
+  // ids; it suits meshes and road networks.
+  ArrayList<size_t> ReverseCuthillMcKeeOrder() const {
+    return _::cuthill_mckee_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true));
+  }
+
+  // Nodes by degree, in and out, highest first, so hubs share cache lines.
+  ArrayList<size_t> DegreeOrder() const {
+    return _::degree_order_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true));
+  }
+
+  // Gorder: nodes sharing neighbours within a window of window ids. The
+  // slowest to compute; suits power-law graphs.
+  ArrayList<size_t> GorderOrder(size_t window = 5) const {
+    auto edges = [this](size_t n, auto&& visit) { ForEachEdge(n, visit); };
+    return _::gorder_(_::adjacency_of_(NodeCount(), edges, true, false),
+                      _::adjacency_of_(NodeCount(), edges, false, true), window);
+  }
+
+  // This graph with node n renumbered permutation[n], values and edges
+  // following.
+  AdjacencyListGraph Relabel(const ArrayList<size_t>& permutation) const {
+    auto order = _::order_of_(permutation, NodeCount());
+    AdjacencyListGraph g;
+    g.Reserve(NodeCount(), EdgeCount());
 
-    while (p != start) {
-      p = prev[p];
-      out_path.Append(p);
+    for (auto n : order) {
+      g.AddNode(Value(n));
     }
+    for (size_t i = 0; i < order.Size(); ++i) {
+      for (auto& arc : arcs(order[i])) {
+        g.AddEdge(i, permutation.begin()[arc.dest_], arc.weight_);
+      }
+    }
+
+    return g;
+  }
 
-    std::reverse(out_path.begin(), out_path.end());
+  // Splits the nodes into parts of about equal size with few edges between
+  // them, for threads to work on a part each.
+  GraphPartition Partition(size_t parts, double imbalance = 0.03) const {
+    return _::partition_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true), parts, imbalance);
   }
+};
+
+// Immutable compressed sparse row graph. The edges out of node n are
+// targets_[offsets_[n], offsets_[n + 1]) with matching weights_, so a
+// neighbour scan is a sequential read of two contiguous arrays rather than a
+// pointer chase per edge. Edges keep the order they were given in. Targets
+// are stored as Index, as in AdjacencyListGraph; offsets stay size_t since
+// edge counts outgrow node counts.
+template <class T, class Index = size_t>
+class CSRGraph {
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
 
 public:
-  AdjacencyListGraph(size_t num_nodes, std::initializer_list<T>&& nodes, std::initializer_list<Edge>&& edges) 
-      : nodes_(num_nodes),
-        edges_(edges) {
-    for (auto val : nodes) {
-      nodes_.Append(std::move(std::make_shared<Node>(val)));
+  CSRGraph(std::initializer_list<T> nodes, std::initializer_list<GraphEdge> edges)
+      : CSRGraph(ArrayList<T>(nodes), edges.begin(), edges.end()) {
+
+  }
+
+  // Builds from [first, last) of GraphEdge (or anything with src_, dest_ and
+  // weight_) with a counting sort by source, so there is no per-edge
+  // allocation.
+  template <typename ForwardIterator>
+  CSRGraph(ArrayList<T> values, ForwardIterator first, ForwardIterator last)
+      : values_(std::move(values)),
+        offsets_(values_.Size() + 1, 0),
+        targets_(std::distance(first, last), 0),
+        weights_(targets_.Size(), 0) {
+    size_t n = values_.Size();
+    assert(n <= std::numeric_limits<Index>::max());
+
+    for (auto it = first; it != last; ++it) {
+      check_bounds(it->src_, n);
+      check_bounds(it->dest_, n);
+      ++offsets_[it->src_ + 1];
     }
-    for (auto edge : edges) {
-      nodes_[edge.src_]->adj_.Append(edge);
+
+    for (size_t i = 0; i < n; ++i) {
+      offsets_[i + 1] += offsets_[i];
+    }
+
+    ArrayList<size_t> cursor(offsets_);
+    for (auto it = first; it != last; ++it) {
+      size_t slot = cursor[it->src_]++;
+      targets_[slot] = static_cast<Index>(it->dest_);
+      weights_[slot] = it->weight_;
     }
   }
 
-  ~AdjacencyListGraph() {
+  template <class GraphIndex>
+  explicit CSRGraph(const AdjacencyListGraph<T, GraphIndex>& graph)
+      : values_(graph.NodeCount(), T{}),
+        offsets_(graph.NodeCount() + 1, 0),
+        targets_(graph.EdgeCount(), 0),
+        weights_(graph.EdgeCount(), 0) {
+    size_t slot = 0;
+
+    for (size_t i = 0; i < graph.NodeCount(); ++i) {
+      values_[i] = graph.Value(i);
 
+      graph.ForEachEdge(i, [this, &slot](size_t dest, double weight) {
+        targets_[slot] = static_cast<Index>(dest);
+        weights_[slot] = weight;
+        ++slot;
+      });
+      offsets_[i + 1] = slot;
+    }
   }
 
   size_t NodeCount() const {
-    return nodes_.Size();
+    return values_.Size();
   }
 
   size_t EdgeCount() const {
-    return edges_.Size();
+    return targets_.Size();
+  }
+
+  const T& Value(size_t node) const {
+    check_bounds(node, NodeCount());
+    return values_.begin()[node];
+  }
+
+  size_t Degree(size_t node) const {
+    check_bounds(node, NodeCount());
+    return offsets_[node + 1] - offsets_[node];
+  }
+
+  // The raw arrays, for algorithms that scan them directly.
+  const ArrayList<size_t>& Offsets() const { return offsets_; }
+  const ArrayList<Index>& Targets() const { return targets_; }
+  const ArrayList<double>& Weights() const { return weights_; }
+
+  // Calls f(dest, weight) for each edge out of node.
+  template <class Func>
+  void ForEachEdge(size_t node, Func&& f) const {
+    const Index* targets = targets_.begin();
+    const double* weights = weights_.begin();
+
+    for (size_t e = offsets_[node], end = offsets_[node + 1]; e < end; ++e) {
+      f(static_cast<size_t>(targets[e]), weights[e]);
+    }
   }
 
   template <class Func>
   void DFS(size_t start, Func& f) const {
-    auto n = NodeCount();
-    ArrayList<bool> visited(n);
+    TraversalContext context;
+    DFS(start, context, f);
+  }
 
-    std::for_each(visited.begin(), visited.end(), [](bool& val) { val = false; });
+  // As AdjacencyListGraph::DFS.
+  template <class Pre, class Post = _::no_visit_>
+  bool DFS(size_t start, TraversalContext& context, Pre& pre, Post&& post = Post()) const {
+    check_bounds(start, NodeCount());
+    context.Reset(NodeCount());
+    return DFSFrom(start, context, pre, post);
+  }
 
-    DFSImpl(start, visited, f);
+  template <class Pre, class Post = _::no_visit_>
+  bool DFSFrom(size_t start, TraversalContext& context, Pre& pre, Post&& post = Post()) const {
+    return _::depth_first_(start, context,
+      [this](size_t node) { return std::make_pair(offsets_[node], offsets_[node + 1]); },
+      [this](size_t, size_t e) { return static_cast<size_t>(targets_.begin()[e]); },
+      pre, post);
   }
 
+  // Each node is queued at most once, so the queue is a flat array of
+  // NodeCount() slots.
   template <class Func>
-  ArrayList<size_t> BFS(size_t start, size_t end, Func& f) {
+  ArrayList<size_t> BFS(size_t start, size_t end, Func& f) const {
     auto n = NodeCount();
-    ArrayList<bool> visited(n);
-    ArrayList<size_t> prev(n);
+    DynamicBitset visited(n);
+    ArrayList<Index> prev(n, 0);
+    ArrayList<Index> queue(n, 0);
+    size_t head = 0;
+    size_t tail = 0;
 
-    for (size_t i = 0; i < n; ++i) {
-      visited[i] = false;
-      prev[i] = i;
-    }
+    visited.Set(start);
+    prev[start] = static_cast<Index>(start);
+    queue[tail++] = static_cast<Index>(start);
 
-    Queue<size_t> q;
-    q.Push(start);
-   
     ArrayList<size_t> path;
 
-    while (!q.isEmpty()) {
-      auto current = q.Pop();
+    while (head < tail) {
+      size_t current = queue[head++];
       f(current);
 
       if (current == end) {
-        makePath(start, end, prev, path);
+        _::make_path_(start, end, prev, path);
         break;
       }
 
-      for (auto edge : nodes_[current]->adj_) {
-        q.Push(edge.dest_);
-        prev[edge.dest_] = current;
+      for (size_t e = offsets_[current]; e < offsets_[current + 1]; ++e) {
+        Index next = targets_[e];
+        if (!visited.TestAndSet(next)) {
+          prev[next] = static_cast<Index>(current);
+          queue[tail++] = next;
+        }
       }
     }
 
     return path;
   }
 
-  //template <class Func>
-  std::pair<ArrayList<size_t>, double> Dikstras(size_t start, size_t end/*, Func& f*/) {
+  template <class Queue = IndexedHeap<double, MinHeap>>
+  std::pair<ArrayList<size_t>, double> Dikstras(size_t start, size_t end) const {
+    return _::shortest_path_<Queue, Index>(NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  double Dikstras(size_t start, size_t end, PathContext& context, ArrayList<size_t>& path) const {
+    return _::context_path_(context, NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, path);
+  }
+
+  // As AdjacencyListGraph::AStar, BidirectionalDikstras and DeltaStepping.
+  template <class Heuristic, class Queue = IndexedHeap<double, MinHeap>>
+  std::pair<ArrayList<size_t>, double> AStar(size_t start, size_t end, Heuristic&& heuristic) const {
+    return _::shortest_path_<Queue, Index>(NodeCount(), start, end, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, heuristic);
+  }
+
+  std::pair<ArrayList<size_t>, double> BidirectionalDikstras(size_t start, size_t end, const CSRGraph& reverse) const {
+    return _::bidirectional_path_<Index>(NodeCount(), start, end,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&reverse](size_t n, auto&& visit) { reverse.ForEachEdge(n, visit); });
+  }
+
+  ShortestPathTree DeltaStepping(size_t start, ThreadPool& pool, double delta = 0) const {
+    check_bounds(start, NodeCount());
+    return _::delta_stepping_<Index>(NodeCount(), start, delta, pool, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  std::pair<ArrayList<size_t>, double> DeltaStepping(size_t start, size_t end, ThreadPool& pool, double delta = 0) const {
+    check_bounds(end, NodeCount());
+    return DeltaStepping(start, pool, delta).PathTo(end);
+  }
+
+  // The same nodes with every edge reversed.
+  CSRGraph Transpose() const {
+    ArrayList<GraphEdge> reversed(EdgeCount(), GraphEdge());
 
-    if (start == end) {
-      return { {}, 0 };
+    for (size_t n = 0; n < NodeCount(); ++n) {
+      for (size_t e = offsets_[n]; e < offsets_[n + 1]; ++e) {
+        reversed[e] = GraphEdge(targets_[e], n, weights_[e]);
+      }
     }
 
-    auto count = nodes_.Size();
+    return CSRGraph(values_, reversed.begin(), reversed.end());
+  }
+
+  // Level-synchronous parallel BFS that switches direction by frontier size
+  // (Beamer et al., "Direction-Optimizing Breadth-First Search"). Small
+  // frontiers expand top-down from a node list, claiming each newly reached
+  // node with an atomic bit; once the frontier's edges outweigh the
+  // unexplored edges by ALPHA it turns bottom-up, where every unvisited node
+  // scans its in-edges (transpose) for a parent in a frontier bitmap and stops
+  // at the first hit. It turns back when the frontier drops below n / BETA.
+  // Pass an undirected graph as its own transpose. Parents are whichever
+  // frontier node got there first, so they may differ between runs; the
+  // distances do not.
+  BFSResult ParallelBFS(size_t start, const CSRGraph& transpose, ThreadPool& pool) const {
+    constexpr size_t ALPHA = 14;
+    constexpr size_t BETA = 24;
+    constexpr size_t TOP_DOWN_GRAIN = 64;
+    constexpr size_t BOTTOM_UP_GRAIN = 4096;
+    constexpr size_t FLUSH = 256;
+
+    auto n = NodeCount();
+    check_bounds(start, n);
+    assert(transpose.NodeCount() == n);
+
+    BFSResult result{ ArrayList<size_t>(n, BFSResult::UNREACHED), ArrayList<size_t>(n, BFSResult::UNREACHED) };
+    size_t* distance = result.distance_.begin();
+    size_t* parent = result.parent_.begin();
 
-    ArrayList<double> distance(count, std::numeric_limits<double>::max());
-    ArrayList<size_t> prev(count, std::numeric_limits<size_t>::max());
-    ArrayList<size_t> visited(count, false);
+    const size_t* offsets = offsets_.begin();
+    const Index* targets = targets_.begin();
+    const size_t* inOffsets = transpose.offsets_.begin();
+    const Index* inTargets = transpose.targets_.begin();
 
-    BinHeap<Edge, MinHeap> q(count);
+    _::atomic_bitmap_ visited(n);
+    _::atomic_bitmap_ front(n);
+    _::atomic_bitmap_ next(n);
 
-    Edge startEdge{ start, start, 0 };
-    q.Insert(startEdge);
+    ArrayList<Index> queueA(n, 0);
+    ArrayList<Index> queueB(n, 0);
+    Index* frontier = queueA.begin();
+    Index* nextFrontier = queueB.begin();
+
+    visited.Claim(start);
     distance[start] = 0;
+    parent[start] = start;
+    frontier[0] = static_cast<Index>(start);
 
-    ArrayList<size_t> path;
+    size_t frontierSize = 1;
+    size_t frontierEdges = offsets[start + 1] - offsets[start];
+    size_t unexploredEdges = EdgeCount() - frontierEdges;
+    bool bottomUp = false;
 
-    while (!q.isEmpty()) {
-      Edge currentEdge = q.Pop();
-      size_t n = currentEdge.dest_;
+    for (size_t level = 1; frontierSize > 0; ++level) {
+      if (!bottomUp && frontierEdges > unexploredEdges / ALPHA) {
+        front.Clear();
+        for (size_t i = 0; i < frontierSize; ++i) {
+          front.Claim(frontier[i]);
+        }
+        bottomUp = true;
+      }
+      else if (bottomUp && frontierSize < n / BETA) {
+        size_t count = 0;
+        for (size_t w = 0; w < front.Words(); ++w) {
+          for (uint64_t bits = front.Word(w); bits; bits &= bits - 1) {
+            frontier[count++] = static_cast<Index>((w << 6) + _::lowest_bit_(bits));
+          }
+        }
+        bottomUp = false;
+      }
 
-      if (n == end) {
-        makePath(start, end, prev, path);
-        break;
+      std::atomic<size_t> nextSize(0);
+      std::atomic<size_t> nextEdges(0);
+
+      if (bottomUp) {
+        next.Clear();
+
+        // Chunks are whole bitmap words, so each thread sets only its own
+        // words of visited and next.
+        pool.ParallelFor(0, n, BOTTOM_UP_GRAIN, [&](size_t lo, size_t hi, size_t) {
+          size_t count = 0;
+          size_t edges = 0;
+
+          for (size_t v = lo; v < hi; ++v) {
+            if (visited.Test(v)) {
+              continue;
+            }
+
+            for (size_t e = inOffsets[v]; e < inOffsets[v + 1]; ++e) {
+              size_t u = inTargets[e];
+              if (front.Test(u)) {
+                visited.Claim(v);
+                next.Claim(v);
+                distance[v] = level;
+                parent[v] = u;
+                ++count;
+                edges += offsets[v + 1] - offsets[v];
+                break;
+              }
+            }
+          }
+
+          nextSize += count;
+          nextEdges += edges;
+        });
+
+        std::swap(front, next);
       }
+      else {
+        std::atomic<size_t> tail(0);
+
+        pool.ParallelFor(0, frontierSize, TOP_DOWN_GRAIN, [&](size_t lo, size_t hi, size_t) {
+          Index local[FLUSH];
+          size_t count = 0;
+          size_t edges = 0;
+
+          auto flush = [&]() {
+            size_t at = tail.fetch_add(count, std::memory_order_relaxed);
+            std::copy(local, local + count, nextFrontier + at);
+            count = 0;
+          };
 
-      for (auto edge : nodes_[n]->adj_) {
-        if (!visited[edge.dest_]) {
-          auto d = distance[edge.src_] + edge.weight_;
-          if (d < distance[edge.dest_]) {
-            distance[edge.dest_] = d;
-            q.Insert(edge);
-            prev[edge.dest_] = edge.src_;
+          for (size_t i = lo; i < hi; ++i) {
+            size_t u = frontier[i];
+
+            for (size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+              Index v = targets[e];
+              if (!visited.Test(v) && visited.Claim(v)) {
+                distance[v] = level;
+                parent[v] = u;
+                edges += offsets[v + 1] - offsets[v];
+                local[count++] = v;
+                if (count == FLUSH) {
+                  flush();
+                }
+              }
+            }
           }
-        }
+
+          flush();
+          nextEdges += edges;
+        });
+
+        nextSize = tail.load();
+        std::swap(frontier, nextFrontier);
       }
-      visited[n] = true;
+
+      frontierSize = nextSize;
+      frontierEdges = nextEdges;
+      unexploredEdges -= std::min(unexploredEdges, frontierEdges);
+    }
+
+    return result;
+  }
+
+  // Builds the transpose and a pool for a one-off search. Reuse them through
+  // the overload above when searching the same graph repeatedly.
+  BFSResult ParallelBFS(size_t start) const {
+    ThreadPool pool;
+    return ParallelBFS(start, Transpose(), pool);
+  }
+
+  // As AdjacencyListGraph::ConnectedComponents and the rest.
+  Components ConnectedComponents(ThreadPool& pool) const {
+    return _::connected_components_(NodeCount(), pool,
+      [this](size_t node) { return std::make_pair(offsets_[node], offsets_[node + 1]); },
+      [this](size_t, size_t e) { return static_cast<size_t>(targets_.begin()[e]); });
+  }
+
+  Components StronglyConnectedComponents() const {
+    return _::tarjan_(NodeCount(),
+      [this](size_t node) { return std::make_pair(offsets_[node], offsets_[node + 1]); },
+      [this](size_t, size_t e) { return static_cast<size_t>(targets_.begin()[e]); });
+  }
+
+  Components StronglyConnectedComponents(const CSRGraph& transpose, ThreadPool& pool) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::parallel_scc_(NodeCount(), pool,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  std::optional<ArrayList<size_t>> TopologicalSort(ThreadPool& pool) const {
+    return _::topological_sort_(NodeCount(), pool, [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    });
+  }
+
+  std::optional<ArrayList<size_t>> TopologicalSort() const {
+    ThreadPool pool(1);
+    return TopologicalSort(pool);
+  }
+
+  SpanningForest KruskalMST() const {
+    return _::kruskal_(NodeCount(), [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  SpanningForest BoruvkaMST(ThreadPool& pool) const {
+    return _::boruvka_(NodeCount(), pool, [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  RankResult PageRank(const CSRGraph& transpose, ThreadPool& pool, double damping = 0.85,
+                      double tolerance = 1e-6, size_t maxIterations = 100) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::pagerank_pull_(NodeCount(), pool, nullptr, damping, tolerance, maxIterations,
+      [this](size_t n) { return offsets_[n + 1] - offsets_[n]; },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  RankResult PageRank(ThreadPool& pool, double damping = 0.85, double tolerance = 1e-6,
+                      size_t maxIterations = 100) const {
+    return _::pagerank_push_<Index>(NodeCount(), pool, damping, tolerance, maxIterations,
+      [this](size_t n) { return offsets_[n + 1] - offsets_[n]; },
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); });
+  }
+
+  RankResult PersonalizedPageRank(const ArrayList<size_t>& seeds, const CSRGraph& transpose,
+                                  ThreadPool& pool, double damping = 0.85, double tolerance = 1e-6,
+                                  size_t maxIterations = 100) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::pagerank_pull_(NodeCount(), pool, &seeds, damping, tolerance, maxIterations,
+      [this](size_t n) { return offsets_[n + 1] - offsets_[n]; },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  Components LabelPropagation(const CSRGraph& transpose, ThreadPool& pool, size_t maxIterations = 20) const {
+    assert(transpose.NodeCount() == NodeCount());
+    return _::label_propagation_(NodeCount(), pool, maxIterations,
+      [this](size_t n, auto&& visit) { ForEachEdge(n, visit); },
+      [&transpose](size_t n, auto&& visit) { transpose.ForEachEdge(n, visit); });
+  }
+
+  // As AdjacencyListGraph::ReverseCuthillMcKeeOrder and the rest.
+  ArrayList<size_t> ReverseCuthillMcKeeOrder() const {
+    return _::cuthill_mckee_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true));
+  }
+
+  ArrayList<size_t> DegreeOrder() const {
+    return _::degree_order_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true));
+  }
+
+  ArrayList<size_t> GorderOrder(size_t window = 5) const {
+    auto edges = [this](size_t n, auto&& visit) { ForEachEdge(n, visit); };
+    return _::gorder_(_::adjacency_of_(NodeCount(), edges, true, false),
+                      _::adjacency_of_(NodeCount(), edges, false, true), window);
+  }
+
+  CSRGraph Relabel(const ArrayList<size_t>& permutation) const {
+    auto order = _::order_of_(permutation, NodeCount());
+    ArrayList<T> values(NodeCount());
+    ArrayList<GraphEdge> edges(EdgeCount());
+
+    for (size_t i = 0; i < order.Size(); ++i) {
+      values.Append(values_.begin()[order[i]]);
+      ForEachEdge(order[i], [&](size_t dest, double weight) {
+        edges.Append(GraphEdge(i, permutation.begin()[dest], weight));
+      });
     }
 
-    return std::make_pair(std::move(path), distance[end]);
+    return CSRGraph(std::move(values), edges.begin(), edges.end());
   }
+
+  GraphPartition Partition(size_t parts, double imbalance = 0.03) const {
+    return _::partition_(_::adjacency_of_(NodeCount(), [this](size_t n, auto&& visit) {
+      ForEachEdge(n, visit);
+    }, true, true), parts, imbalance);
+  }
+
+private:
+  ArrayList<T> values_;
+  ArrayList<size_t> offsets_;
+  ArrayList<Index> targets_;
+  ArrayList<double> weights_;
 };
 
 } //namespace ds
\ No newline at end of file
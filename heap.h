@@ -1,49 +1,137 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 #include "list.h"
+#include "bitset.h"
+#include "common.h"
+#include "compare.h"
 #include <array>
 namespace ds {
 
+// A heap keeps on top the value its comparator orders first, so the tags are
+// just the stock comparators.
+using MinHeap = _::ascending_<>;
+using MaxHeap = _::descending_<>;
+
 namespace _ {
-struct HeapType {};
-} // namespace _
 
-struct MinHeap : _::HeapType {};
-struct MaxHeap : _::HeapType {};
+// Holds a heap's comparator. Stateless comparators are an empty base and take
+// no space; anything else is stored as a member.
+template <class Compare, bool = std::is_empty<Compare>::value && !std::is_final<Compare>::value>
+class heap_compare_ : private Compare {
+public:
+  heap_compare_(const Compare& compare)
+      : Compare(compare) {
+
+  }
+
+  const Compare& comparator() const {
+    return *this;
+  }
+};
 
-template <class T, class H, 
-  typename = std::enable_if_t<std::is_base_of<_::HeapType, H>::value>
+template <class Compare>
+class heap_compare_<Compare, false> {
+public:
+  heap_compare_(const Compare& compare)
+      : compare_(compare) {
+
+  }
+
+  const Compare& comparator() const {
+    return compare_;
+  }
+
+private:
+  Compare compare_;
+};
+
+} // namespace _
+
+// Array-backed heap with Arity children per node. Compare is MinHeap, MaxHeap
+// or any comparator (e.g. by_key(&Task::deadline)); compare(a, b) is true when
+// a belongs nearer the top. A 4-ary heap is half the height of a binary one
+// and a node's children share a cache line, which usually wins on large heaps
+// despite the extra comparisons per level.
+template <class T, class Compare, size_t Arity = 2,
+  typename = std::enable_if_t<(Arity >= 2)>
 >
-class BinHeap : protected ArrayList<T> {
+class BinHeap : private _::heap_compare_<Compare>, protected ArrayList<T> {
 
 public:
-  using HeapType = H;
+  using HeapType = Compare;
+  static constexpr size_t ARITY = Arity;
 
-  BinHeap()
-      : ArrayList<T>() {
+  BinHeap(Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        ArrayList<T>() {
 
   }
 
-  BinHeap(size_t capacity)
-      : ArrayList<T>(capacity) {
+  BinHeap(size_t capacity, Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        ArrayList<T>(capacity) {
 
   }
 
-  BinHeap(std::initializer_list<T>&& in) {
-    for (auto val : in) {
-      Insert(val);
-    }
+  BinHeap(std::initializer_list<T>&& in, Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        ArrayList<T>() {
+    Heapify(in.begin(), in.end());
+  }
+
+  template <typename InputIterator>
+  BinHeap(InputIterator first, InputIterator last, Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        ArrayList<T>() {
+    Heapify(first, last);
   }
 
   bool isEmpty() const {
     return ArrayList<T>::isEmpty();
   }
 
+  size_t Size() const {
+    return ArrayList<T>::Size();
+  }
+
+  // Adds [first, last) and restores the heap bottom-up (Floyd), which is O(n)
+  // rather than the O(n log n) of inserting one at a time. Pass
+  // std::make_move_iterator to move records in.
+  template <typename InputIterator>
+  void Heapify(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) {
+      ArrayList<T>::Append(*first);
+    }
+
+    if (count_ < 2) {
+      return;
+    }
+
+    for (size_t i = parentIndex(count_ - 1) + 1; i > 0; --i) {
+      siftDown(i - 1, std::move(elements_[i - 1]));
+    }
+  }
+
   void Insert(T val) {
-    ArrayList<T>::Append(val);
-    fixUp(ArrayList<T>::Size() - 1);
+    ArrayList<T>::Append(std::move(val));
+    siftUp(count_ - 1, std::move(elements_[count_ - 1]));
+  }
+
+  template <typename... Args>
+  void Emplace(Args&&... args) {
+    Insert(T(std::forward<Args>(args)...));
+  }
+
+  const T& Top() const {
+    check_bounds(0, count_);
+    return elements_[0];
   }
 
   T Peek() const {
@@ -51,81 +139,731 @@ public:
   }
 
   T Pop() {
-    if (count_ == 1) {
-      return ArrayList<T>::Pop();
+    check_bounds(0, count_);
+
+    T top = std::move(elements_[0]);
+    T last = ArrayList<T>::Remove(count_ - 1);
+
+    if (count_ > 0) {
+      siftDown(0, std::move(last));
     }
 
-    std::swap(elements_[0], elements_[count_ - 1]);
-    auto retval = ArrayList<T>::Pop();
-    heapify(0);
-    return retval;
+    return top;
+  }
+
+  // Insert followed by Pop, in one sift. If val would be the new top it is
+  // handed straight back and the heap is untouched.
+  T PushPop(T val) {
+    if (isEmpty() || !compare(elements_[0], val)) {
+      return val;
+    }
+
+    return Replace(std::move(val));
+  }
+
+  // Pop followed by Insert, in one sift.
+  T Replace(T val) {
+    check_bounds(0, count_);
+
+    T top = std::move(elements_[0]);
+    siftDown(0, std::move(val));
+    return top;
   }
 
 private:
 
-  bool compare(size_t lhs, size_t rhs) const {
-    return std::is_same<HeapType, MinHeap>::value ? elements_[lhs] < elements_[rhs] : elements_[lhs] > elements_[rhs];
+  bool compare(const T& lhs, const T& rhs) const {
+    return this->comparator()(lhs, rhs);
   }
 
   size_t parentIndex(size_t index) const {
-    return (index - 1) / 2;
+    return (index - 1) / Arity;
+  }
+
+  size_t firstChildIndex(size_t index) const {
+    return (index * Arity) + 1;
+  }
+
+  // The sifts carry val in a hole that starts at index, moving each displaced
+  // element once, and write val when the hole stops.
+  void siftUp(size_t index, T val) {
+    while (index != 0 && compare(val, elements_[parentIndex(index)])) {
+      elements_[index] = std::move(elements_[parentIndex(index)]);
+      index = parentIndex(index);
+    }
+
+    elements_[index] = std::move(val);
+  }
+
+  void siftDown(size_t index, T val) {
+    while (true) {
+      size_t first = firstChildIndex(index);
+      if (first >= count_) {
+        break;
+      }
+
+      size_t last = std::min(first + Arity, count_);
+      size_t priority = first;
+
+      for (size_t child = first + 1; child < last; ++child) {
+        if (compare(elements_[child], elements_[priority])) {
+          priority = child;
+        }
+      }
+
+      if (!compare(elements_[priority], val)) {
+        break;
+      }
+
+      elements_[index] = std::move(elements_[priority]);
+      index = priority;
+    }
+
+    elements_[index] = std::move(val);
+  }
+};
+
+// Heap of handles in [0, capacity), each queued with a priority. A position
+// map from handle to heap slot lets a queued handle be re-prioritised or
+// erased in O(log n), so priority-driven algorithms such as Dijkstra keep at
+// most one entry per handle rather than pushing duplicates.
+template <class T, class Compare, size_t Arity = 4,
+  typename = std::enable_if_t<(Arity >= 2)>
+>
+class IndexedHeap : private _::heap_compare_<Compare> {
+public:
+  using HeapType = Compare;
+  static constexpr size_t ARITY = Arity;
+  static constexpr size_t NPOS = std::numeric_limits<size_t>::max();
+
+  IndexedHeap(size_t capacity, Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        count_(0),
+        entries_(capacity, Entry{}),
+        position_(capacity, NPOS) {
+
+  }
+
+  bool isEmpty() const {
+    return count_ == 0;
+  }
+
+  size_t Size() const {
+    return count_;
+  }
+
+  size_t Capacity() const {
+    return position_.Size();
+  }
+
+  bool Contains(size_t handle) const {
+    check_bounds(handle, Capacity());
+    return position_[handle] != NPOS;
+  }
+
+  T Priority(size_t handle) const {
+    check_bounds(handle, Capacity());
+    check_bounds(position_[handle], count_);
+    return entries_[position_[handle]].priority_;
+  }
+
+  // The handle and priority at the top of the heap.
+  std::pair<size_t, T> Peek() const {
+    check_bounds(0, count_);
+    return { entries_[0].handle_, entries_[0].priority_ };
+  }
+
+  std::pair<size_t, T> Pop() {
+    auto top = Peek();
+    Erase(top.first);
+    return top;
+  }
+
+  void Insert(size_t handle, T priority) {
+    check_bounds(handle, Capacity());
+    assert(position_[handle] == NPOS);
+
+    size_t index = count_++;
+    entries_[index] = Entry{ std::move(priority), handle };
+    position_[handle] = index;
+    siftUp(index);
+  }
+
+  // Moves a queued handle to its new priority, in whichever direction.
+  void Update(size_t handle, T priority) {
+    check_bounds(handle, Capacity());
+    size_t index = position_[handle];
+    check_bounds(index, count_);
+
+    entries_[index].priority_ = std::move(priority);
+    restore(index);
+  }
+
+  // Moves a queued handle towards the top (a smaller key in a MinHeap), so
+  // only a sift up is needed. Asserts the new priority is not further down.
+  void DecreaseKey(size_t handle, T priority) {
+    check_bounds(handle, Capacity());
+    size_t index = position_[handle];
+    check_bounds(index, count_);
+    assert(!before(entries_[index].priority_, priority));
+
+    entries_[index].priority_ = std::move(priority);
+    siftUp(index);
+  }
+
+  // Moves a queued handle away from the top; the converse of DecreaseKey.
+  void IncreaseKey(size_t handle, T priority) {
+    check_bounds(handle, Capacity());
+    size_t index = position_[handle];
+    check_bounds(index, count_);
+    assert(!before(priority, entries_[index].priority_));
+
+    entries_[index].priority_ = std::move(priority);
+    siftDown(index);
+  }
+
+  void Erase(size_t handle) {
+    check_bounds(handle, Capacity());
+    size_t index = position_[handle];
+    check_bounds(index, count_);
+
+    position_[handle] = NPOS;
+    --count_;
+
+    if (index != count_) {
+      place(index, std::move(entries_[count_]));
+      restore(index);
+    }
+  }
+
+  // Empties the heap in O(Size()), keeping its capacity.
+  void Clear() {
+    for (size_t i = 0; i < count_; ++i) {
+      position_[entries_[i].handle_] = NPOS;
+    }
+    count_ = 0;
+  }
+
+private:
+  struct Entry {
+    T priority_;
+    size_t handle_;
+  };
+
+  size_t count_;
+  ArrayList<Entry> entries_;
+  ArrayList<size_t> position_;
+
+  bool before(const T& lhs, const T& rhs) const {
+    return this->comparator()(lhs, rhs);
+  }
+
+  void place(size_t index, Entry&& entry) {
+    position_[entry.handle_] = index;
+    entries_[index] = std::move(entry);
+  }
+
+  void restore(size_t index) {
+    if (index > 0 && before(entries_[index].priority_, entries_[(index - 1) / Arity].priority_)) {
+      siftUp(index);
+    }
+    else {
+      siftDown(index);
+    }
+  }
+
+  // Both sifts carry the moving entry in a hole and write it once at the end.
+  void siftUp(size_t index) {
+    Entry moving = std::move(entries_[index]);
+
+    while (index > 0) {
+      size_t parent = (index - 1) / Arity;
+      if (!before(moving.priority_, entries_[parent].priority_)) {
+        break;
+      }
+      place(index, std::move(entries_[parent]));
+      index = parent;
+    }
+
+    place(index, std::move(moving));
   }
 
-  size_t leftChildIndex(size_t index) const {
-    return ((index * 2) + 1);
+  void siftDown(size_t index) {
+    Entry moving = std::move(entries_[index]);
+
+    while (true) {
+      size_t first = (index * Arity) + 1;
+      if (first >= count_) {
+        break;
+      }
+
+      size_t last = std::min(first + Arity, count_);
+      size_t best = first;
+
+      for (size_t child = first + 1; child < last; ++child) {
+        if (before(entries_[child].priority_, entries_[best].priority_)) {
+          best = child;
+        }
+      }
+
+      if (!before(entries_[best].priority_, moving.priority_)) {
+        break;
+      }
+      place(index, std::move(entries_[best]));
+      index = best;
+    }
+
+    place(index, std::move(moving));
   }
+};
+
+// Monotone min-heap for unsigned integer keys: no key may be inserted below the
+// last key popped, which holds for Dijkstra with non-negative integer weights
+// and for event simulation. Bucket b holds keys whose highest bit differing
+// from the last popped key is bit b - 1, so bucket 0 holds keys equal to it. A
+// pop that finds bucket 0 empty redistributes the next non-empty bucket around
+// its minimum; every key only ever moves to a lower bucket, so operations are
+// amortized O(log C) for key range C, with no comparisons between stored
+// entries beyond that redistribution. The minimum's slot is kept up to date, so
+// Peek is O(1): inserts compare against it, and a Pop that empties bucket 0
+// finds it in the bucket the next Pop redistributes.
+template <class Key, class Value>
+class RadixHeap {
+  static_assert(std::is_unsigned<Key>::value && std::numeric_limits<Key>::digits <= 64,
+    "RadixHeap keys must be unsigned integers of at most 64 bits");
+
+public:
+  using Entry = std::pair<Key, Value>;
+
+  RadixHeap()
+      : size_(0),
+        last_(0),
+        minBucket_(0),
+        minIndex_(0),
+        buckets_() {
 
-  size_t rightChildIndex(size_t index) const {
-    return ((index * 2) + 2);
   }
 
-  T parent(size_t index) const {
-    return elements_[parentIndex(index)];
+  bool isEmpty() const {
+    return size_ == 0;
   }
 
-  bool hasLeft(size_t index) {
-    return leftChildIndex(index) < count_;
+  size_t Size() const {
+    return size_;
   }
 
-  bool hasRight(size_t index) {
-    return rightChildIndex(index) < count_;
+  void Insert(Key key, Value value) {
+    assert(key >= last_);
+
+    size_t b = bucketIndex(key);
+    buckets_[b].Append(Entry(key, std::move(value)));
+
+    // Equal keys share a bucket, and the last of them appended is the one a
+    // redistribution leaves at the back of bucket 0, where Pop takes it.
+    if (size_ == 0 || key <= buckets_[minBucket_][minIndex_].first) {
+      minBucket_ = b;
+      minIndex_ = buckets_[b].Size() - 1;
+    }
+    ++size_;
   }
 
-  T leftChild(size_t index) const {
-    return elements_[leftChildIndex(index)];
+  // The smallest key and its value, the entry Pop would return.
+  Entry Peek() const {
+    check_bounds(0, size_);
+    return buckets_[minBucket_][minIndex_];
   }
 
-  T rightChild(size_t index) const {
-    return elements_[rightChildIndex(index)];
+  Entry Pop() {
+    check_bounds(0, size_);
+    if (buckets_[0].isEmpty()) {
+      refill();
+    }
+
+    auto& bucket = buckets_[0];
+    Entry top = bucket.Remove(bucket.Size() - 1);
+    --size_;
+
+    if (size_ > 0) {
+      if (bucket.isEmpty()) {
+        findMin();
+      }
+      else {
+        minBucket_ = 0;
+        minIndex_ = bucket.Size() - 1;
+      }
+    }
+    return top;
   }
 
-  size_t fixUp(size_t index) {
-    size_t current = index;
+private:
+  static constexpr size_t BUCKETS = std::numeric_limits<Key>::digits + 1;
 
-    while (current != 0 && compare(current, parentIndex(current))) {
-      std::swap(elements_[current], elements_[parentIndex(current)]);
-      current = parentIndex(current);
+  size_t size_;
+  Key last_;
+  size_t minBucket_;
+  size_t minIndex_;
+  std::array<ArrayList<Entry>, BUCKETS> buckets_;
+
+  size_t bucketIndex(Key key) const {
+    return key == last_ ? 0 : 1 + _::highest_bit_(static_cast<uint64_t>(key ^ last_));
+  }
+
+  size_t firstBucket() const {
+    size_t b = 0;
+    while (buckets_[b].isEmpty()) {
+      ++b;
+    }
+    return b;
+  }
+
+  // Points the minimum's slot at the last of the smallest keys in the first
+  // non-empty bucket. The next Pop redistributes that bucket anyway, so the
+  // scan adds at most a constant factor to it.
+  void findMin() {
+    minBucket_ = firstBucket();
+    auto& bucket = buckets_[minBucket_];
+
+    minIndex_ = 0;
+    for (size_t i = 1; i < bucket.Size(); ++i) {
+      if (bucket[i].first <= bucket[minIndex_].first) {
+        minIndex_ = i;
+      }
+    }
+  }
+
+  // Moves the first non-empty bucket down around its minimum, which then
+  // lands in bucket 0.
+  void refill() {
+    ArrayList<Entry> moving(std::move(buckets_[firstBucket()]));
+
+    last_ = moving.begin()[0].first;
+    for (size_t i = 1; i < moving.Size(); ++i) {
+      last_ = std::min(last_, moving.begin()[i].first);
     }
 
-    return current;
+    for (auto& entry : moving) {
+      buckets_[bucketIndex(entry.first)].Append(std::move(entry));
+    }
   }
+};
 
-  void heapify(size_t current) {
-    size_t priority = current;
+// Pairing heap: a heap-ordered multiway tree with O(1) Insert, Meld and
+// DecreaseKey and O(log n) amortized Pop. Each node links to its first child
+// and next sibling, and back to its left sibling (or parent, for a first
+// child) so DecreaseKey can cut it out. Insert returns a Handle that stays
+// valid until that value is popped.
+template <class T, class Compare = MinHeap>
+class PairingHeap : private _::heap_compare_<Compare> {
+
+  struct Node {
+    T value_;
+    Node* child_;
+    Node* next_;
+    Node* prev_;
+
+    Node(T&& value)
+        : value_(std::move(value)),
+          child_(nullptr),
+          next_(nullptr),
+          prev_(nullptr) {
 
-    if (hasLeft(current)) {
-      priority = compare(priority, leftChildIndex(current)) ? priority : leftChildIndex(current);
     }
+  }; // struct Node
+
+public:
+  using HeapType = Compare;
+  using Handle = Node*;
 
-    if (hasRight(current)) {
-      priority = compare(priority, rightChildIndex(current)) ? priority : rightChildIndex(current);
+  PairingHeap(Compare compare = Compare())
+      : _::heap_compare_<Compare>(compare),
+        root_(nullptr),
+        count_(0) {
+
+  }
+
+  PairingHeap(const PairingHeap& other) = delete;
+  PairingHeap& operator=(const PairingHeap& other) = delete;
+
+  PairingHeap(PairingHeap&& other) noexcept
+      : _::heap_compare_<Compare>(other.comparator()),
+        root_(other.root_),
+        count_(other.count_) {
+    other.root_ = nullptr;
+    other.count_ = 0;
+  }
+
+  ~PairingHeap() {
+    // Walk the tree through a pending list rather than recursing, since a
+    // pairing heap can be a single long chain.
+    Node* pending = root_;
+
+    while (pending) {
+      Node* node = pending;
+      pending = node->next_;
+
+      if (node->child_) {
+        Node* tail = node->child_;
+        while (tail->next_) {
+          tail = tail->next_;
+        }
+        tail->next_ = pending;
+        pending = node->child_;
+      }
+
+      delete node;
     }
+  }
 
-    if (priority != current) {
-      std::swap(elements_[current], elements_[priority]);
-      heapify(priority);
+  bool isEmpty() const {
+    return count_ == 0;
+  }
+
+  size_t Size() const {
+    return count_;
+  }
+
+  Handle Insert(T val) {
+    Node* node = new Node(std::move(val));
+    root_ = link(root_, node);
+    ++count_;
+    return node;
+  }
+
+  const T& Top() const {
+    check_bounds(0, count_);
+    return root_->value_;
+  }
+
+  T Peek() const {
+    return Top();
+  }
+
+  T Pop() {
+    check_bounds(0, count_);
+
+    Node* top = root_;
+    root_ = mergePairs(top->child_);
+    --count_;
+
+    T val = std::move(top->value_);
+    delete top;
+    return val;
+  }
+
+  // Moves a queued value towards the top. val must not be ordered after the
+  // value it replaces.
+  void DecreaseKey(Handle handle, T val) {
+    assert(!compare(handle->value_, val));
+    handle->value_ = std::move(val);
+
+    if (handle != root_) {
+      cut(handle);
+      root_ = link(root_, handle);
     }
   }
+
+  // Takes every value from other in O(1). Handles into other stay valid and
+  // now refer to this heap.
+  void Meld(PairingHeap& other) {
+    root_ = link(root_, other.root_);
+    count_ += other.count_;
+    other.root_ = nullptr;
+    other.count_ = 0;
+  }
+
+private:
+  Node* root_;
+  size_t count_;
+
+  bool compare(const T& lhs, const T& rhs) const {
+    return this->comparator()(lhs, rhs);
+  }
+
+  // Joins two detached trees; the loser becomes the winner's first child.
+  Node* link(Node* a, Node* b) {
+    if (!a) return b;
+    if (!b) return a;
+
+    if (compare(b->value_, a->value_)) {
+      std::swap(a, b);
+    }
+
+    b->next_ = a->child_;
+    if (a->child_) {
+      a->child_->prev_ = b;
+    }
+    b->prev_ = a;
+    a->child_ = b;
+    return a;
+  }
+
+  // Detaches node and its subtree from its parent's child list.
+  void cut(Node* node) {
+    if (node->prev_->child_ == node) {
+      node->prev_->child_ = node->next_;
+    }
+    else {
+      node->prev_->next_ = node->next_;
+    }
+
+    if (node->next_) {
+      node->next_->prev_ = node->prev_;
+    }
+
+    node->next_ = nullptr;
+    node->prev_ = nullptr;
+  }
+
+  // Standard two-pass pairing: link siblings in pairs left to right, then
+  // fold the pairs together right to left.
+  Node* mergePairs(Node* first) {
+    Node* pairs = nullptr;
+
+    while (first) {
+      Node* a = first;
+      Node* b = a->next_;
+      first = b ? b->next_ : nullptr;
+
+      a->next_ = a->prev_ = nullptr;
+      if (b) {
+        b->next_ = b->prev_ = nullptr;
+      }
+
+      Node* pair = link(a, b);
+      pair->next_ = pairs;
+      pairs = pair;
+    }
+
+    Node* root = nullptr;
+
+    while (pairs) {
+      Node* next = pairs->next_;
+      pairs->next_ = nullptr;
+      root = link(root, pairs);
+      pairs = next;
+    }
+
+    return root;
+  }
+};
+
+namespace _ {
+
+// Per-thread xorshift generator for picking shards.
+inline size_t random_index_(size_t n) {
+  thread_local uint64_t state = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+  return static_cast<size_t>(xorshift_(state) % n);
+}
+
+} // namespace _
+
+// Relaxed concurrent priority queue (MultiQueue): the values are spread over
+// a number of independently locked BinHeap shards. Push goes to a random
+// shard; TryPop looks at the tops of two random shards and pops the better.
+// Pops are not strictly in priority order, but the expected rank error is
+// O(shards), and threads rarely contend for the same lock. Use about twice
+// as many shards as threads.
+template <class T, class Compare = MinHeap, size_t Arity = 4>
+class MultiQueue {
+public:
+  MultiQueue(size_t shards = 2 * std::max(1u, std::thread::hardware_concurrency()), Compare compare = Compare())
+      : compare_(compare),
+        shard_count_(std::max<size_t>(1, shards)),
+        shards_(new Shard[shard_count_]),
+        size_(0) {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      shards_[i].heap_ = std::make_unique<BinHeap<T, Compare, Arity>>(compare);
+    }
+  }
+
+  MultiQueue(const MultiQueue& other) = delete;
+  MultiQueue& operator=(const MultiQueue& other) = delete;
+
+  // Approximate while other threads are pushing or popping.
+  size_t Size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool isEmpty() const {
+    return Size() == 0;
+  }
+
+  size_t ShardCount() const {
+    return shard_count_;
+  }
+
+  void Push(T val) {
+    while (true) {
+      Shard& shard = shards_[_::random_index_(shard_count_)];
+      std::unique_lock<std::mutex> lock(shard.lock_, std::try_to_lock);
+
+      if (lock) {
+        shard.heap_->Insert(std::move(val));
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  // Pops a value near the top, or returns nullopt if every shard was empty
+  // when it was checked.
+  std::optional<T> TryPop() {
+    for (size_t attempt = 0; attempt < shard_count_ && !isEmpty(); ++attempt) {
+      size_t a = _::random_index_(shard_count_);
+      size_t b = (a + 1 + _::random_index_(shard_count_)) % shard_count_;
+
+      std::unique_lock<std::mutex> lockA(shards_[a].lock_, std::try_to_lock);
+      if (!lockA) {
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lockB;
+      if (b != a) {
+        lockB = std::unique_lock<std::mutex>(shards_[b].lock_, std::try_to_lock);
+      }
+      auto& heapA = *shards_[a].heap_;
+
+      if (lockB) {
+        auto& heapB = *shards_[b].heap_;
+
+        if (!heapB.isEmpty() && (heapA.isEmpty() || compare_(heapB.Top(), heapA.Top()))) {
+          return pop(heapB);
+        }
+      }
+
+      if (!heapA.isEmpty()) {
+        return pop(heapA);
+      }
+    }
+
+    // Sampling kept missing; sweep every shard before reporting empty.
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].lock_);
+
+      if (!shards_[i].heap_->isEmpty()) {
+        return pop(*shards_[i].heap_);
+      }
+    }
+
+    return {};
+  }
+
+private:
+  // Padded to a cache line so neighbouring shards' locks do not share one.
+  struct alignas(64) Shard {
+    std::mutex lock_;
+    std::unique_ptr<BinHeap<T, Compare, Arity>> heap_;
+  };
+
+  Compare compare_;
+  size_t shard_count_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> size_;
+
+  T pop(BinHeap<T, Compare, Arity>& heap) {
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return heap.Pop();
+  }
 };
 
 } // namespace ds
\ No newline at end of file
@@ -92,6 +92,7 @@ public:
     other.count_ = 0;
     other.capacity_ = 0;
     other.elements_.reset();
+    return *this;
   }
   
   bool operator==(const ArrayList<T>& rhs) const {
@@ -118,6 +119,26 @@ public:
     return capacity_;
   }
 
+  // Empties the list but keeps its capacity, for buffers refilled in a loop.
+  void Clear() {
+    std::fill(begin(), end(), T());
+    count_ = 0;
+  }
+
+  // Grows the capacity to at least capacity without changing the contents.
+  // Appends keep it; removals may give it back.
+  void Reserve(size_t capacity) {
+    capacity = std::min(MAX_CAPACITY, capacity);
+    if (capacity <= capacity_) {
+      return;
+    }
+
+    auto newArray = std::make_unique<T[]>(capacity);
+    std::move(this->begin(), this->end(), newArray.get());
+    elements_ = std::move(newArray);
+    capacity_ = capacity;
+  }
+
   T Get(size_t index) const {
     check_bounds(index, count_);
     return elements_[index];
@@ -227,7 +248,7 @@ private:
         capacity_ = std::max((size_t)1, capacity_ * 2);
       }
     }
-    else if (count_ < capacity_ / 2) {
+    else if (diff < 0 && count_ < capacity_ / 2) {
       capacity_ /= 2;
     }
     else {
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "bitset.h"
+#include "graph.h"
+#include "heap.h"
+#include "list.h"
+#include "thread-pool.h"
+
+namespace ds {
+
+// Distances from a batch of sources, one row per source in batch order and one
+// column per node. Unreached nodes hold UNREACHED.
+struct DistanceMatrix {
+  static constexpr double UNREACHED = std::numeric_limits<double>::max();
+
+  size_t rows_;
+  size_t columns_;
+  ArrayList<double> values_;
+
+  double At(size_t row, size_t node) const {
+    check_bounds(row, rows_);
+    check_bounds(node, columns_);
+    return values_.begin()[row * columns_ + node];
+  }
+
+  const double* Row(size_t row) const {
+    check_bounds(row, rows_);
+    return values_.begin() + row * columns_;
+  }
+};
+
+// Shortest-path distances from many sources of one graph, AdjacencyListGraph
+// or CSRGraph. Sources are spread over a ThreadPool, and each thread keeps its
+// heap and arrays between sources and between calls instead of rebuilding
+// them per search. When every edge has the same weight the searches are
+// breadth-first and bit-parallel: one sweep carries 64 sources at once, a bit
+// per source in a word per node, so a node reached from many of them is
+// expanded once rather than 64 times.
+template <class Graph>
+class MultiSourceShortestPaths {
+public:
+  static constexpr size_t BATCH = 64;
+
+  MultiSourceShortestPaths(const Graph& graph, ThreadPool& pool)
+      : graph_(graph),
+        pool_(pool),
+        unit_(1),
+        unweighted_(true),
+        nodes_(0),
+        workspaces_() {
+    scanWeights();
+  }
+
+  // True if every edge weighs the same, so searches are bit-parallel BFS. The
+  // graph may change between calls; this reflects it as of the last one.
+  bool isUnweighted() const {
+    return unweighted_;
+  }
+
+  // Calls f(i, distances) once per source i, with distances from sources[i]
+  // to every node as an ArrayList<double>. Calls come from the pool's threads,
+  // several at once and in no set order; distances is only valid during the
+  // call. Bit-parallel searches buffer BATCH rows per thread.
+  template <class Func>
+  void ForEach(const ArrayList<size_t>& sources, Func&& f) {
+    run(sources, [&f](size_t i, workspace_& ws, size_t slot) {
+      f(i, static_cast<const ArrayList<double>&>(ws.rows_[slot]));
+    });
+  }
+
+  // Every distance at once, written straight into the matrix.
+  DistanceMatrix Matrix(const ArrayList<size_t>& sources) {
+    size_t n = graph_.NodeCount();
+    DistanceMatrix matrix{ sources.Size(), n, ArrayList<double>(sources.Size() * n, DistanceMatrix::UNREACHED) };
+    double* values = matrix.values_.begin();
+
+    run(sources, [](size_t, workspace_&, size_t) {}, [values, n](size_t i) { return values + i * n; });
+    return matrix;
+  }
+
+private:
+  // One thread's search state. Every array is left as it was found, all
+  // clear, after each search.
+  struct workspace_ {
+    IndexedHeap<double, MinHeap> queue_;
+    ArrayList<ArrayList<double>> rows_;
+
+    // Bit-parallel BFS: per node, the sources that have reached it, reached
+    // it in the last level, and reach it in the next.
+    ArrayList<uint64_t> seen_;
+    ArrayList<uint64_t> frontier_;
+    ArrayList<uint64_t> next_;
+    ArrayList<size_t> active_;
+    ArrayList<size_t> nextActive_;
+    ArrayList<size_t> touched_;
+
+    workspace_(size_t nodes, bool unweighted)
+        : queue_(unweighted ? 0 : nodes),
+          rows_(),
+          seen_(unweighted ? nodes : 0, 0),
+          frontier_(unweighted ? nodes : 0, 0),
+          next_(unweighted ? nodes : 0, 0),
+          active_(),
+          nextActive_(),
+          touched_() {
+
+    }
+  };
+
+  const Graph& graph_;
+  ThreadPool& pool_;
+  double unit_;
+  bool unweighted_;
+  size_t nodes_;
+  ArrayList<std::unique_ptr<workspace_>> workspaces_;
+
+  // Sets unit_ and unweighted_ from the graph's current edges.
+  void scanWeights() {
+    bool first = true;
+    unit_ = 1;
+    unweighted_ = true;
+
+    for (size_t n = 0; n < graph_.NodeCount(); ++n) {
+      graph_.ForEachEdge(n, [this, &first](size_t, double weight) {
+        if (first) {
+          unit_ = weight;
+          first = false;
+        }
+        unweighted_ = unweighted_ && weight == unit_;
+      });
+    }
+  }
+
+  template <class Emit>
+  void run(const ArrayList<size_t>& sources, Emit&& emit) {
+    run(sources, emit, nullptr);
+  }
+
+  // Fills row(i) for each source i, or a workspace row if row is null, then
+  // calls emit(i, workspace, slot) with the workspace row it used.
+  template <class Emit, class Row>
+  void run(const ArrayList<size_t>& sources, Emit&& emit, Row&& row) {
+    size_t n = graph_.NodeCount();
+    for (auto source : sources) {
+      check_bounds(source, n);
+    }
+
+    // The graph may have gained nodes or edges since the last call. The scan
+    // costs one pass over the edges, less than a single search; workspaces
+    // built for another node count or search kind are rebuilt.
+    bool unweighted = unweighted_;
+    scanWeights();
+    if (n != nodes_ || unweighted != unweighted_) {
+      workspaces_ = ArrayList<std::unique_ptr<workspace_>>();
+      nodes_ = n;
+    }
+
+    while (workspaces_.Size() < pool_.Size()) {
+      workspaces_.Append(std::make_unique<workspace_>(n, unweighted_));
+    }
+
+    constexpr bool buffered = std::is_same<typename std::decay<Row>::type, std::nullptr_t>::value;
+    size_t width = unweighted_ ? BATCH : 1;
+    size_t batches = (sources.Size() + width - 1) / width;
+
+    pool_.ParallelFor(0, batches, 1, [&](size_t lo, size_t hi, size_t worker) {
+      workspace_& ws = *workspaces_[worker];
+      double* rows[BATCH];
+
+      for (size_t batch = lo; batch < hi; ++batch) {
+        size_t first = batch * width;
+        size_t count = std::min(width, sources.Size() - first);
+
+        for (size_t j = 0; j < count; ++j) {
+          if constexpr (buffered) {
+            while (ws.rows_.Size() <= j) {
+              ws.rows_.Append(ArrayList<double>(n, DistanceMatrix::UNREACHED));
+            }
+            rows[j] = ws.rows_[j].begin();
+          }
+          else {
+            rows[j] = row(first + j);
+          }
+        }
+
+        if (unweighted_) {
+          breadthFirst(ws, sources.begin() + first, count, rows);
+        }
+        else {
+          dijkstra(ws, sources.begin()[first], rows[0]);
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+          emit(first + j, ws, j);
+          if constexpr (buffered) {
+            std::fill(rows[j], rows[j] + n, DistanceMatrix::UNREACHED);
+          }
+        }
+      }
+    });
+  }
+
+  // Full Dijkstra into distance, which starts all UNREACHED. Settled nodes are
+  // never improved on, so no visited set is needed.
+  void dijkstra(workspace_& ws, size_t source, double* distance) {
+    distance[source] = 0;
+    ws.queue_.Insert(source, 0);
+
+    while (!ws.queue_.isEmpty()) {
+      auto top = ws.queue_.Pop();
+      size_t u = top.first;
+      double du = top.second;
+
+      graph_.ForEachEdge(u, [&](size_t v, double weight) {
+        double d = du + weight;
+        if (d < distance[v]) {
+          if (distance[v] == DistanceMatrix::UNREACHED) {
+            ws.queue_.Insert(v, d);
+          }
+          else {
+            ws.queue_.DecreaseKey(v, d);
+          }
+          distance[v] = d;
+        }
+      });
+    }
+  }
+
+  // BFS from up to BATCH sources at once, bit j standing for sources[j]. Each
+  // level pushes a node's new bits along its edges, then keeps at every
+  // target only the bits that have not reached it before. Only nodes with
+  // new bits are visited, so sparse frontiers on long paths stay cheap.
+  void breadthFirst(workspace_& ws, const size_t* sources, size_t count, double* const* rows) {
+    uint64_t* seen = ws.seen_.begin();
+    uint64_t* frontier = ws.frontier_.begin();
+    uint64_t* next = ws.next_.begin();
+
+    for (size_t j = 0; j < count; ++j) {
+      size_t s = sources[j];
+      uint64_t bit = uint64_t(1) << j;
+
+      if (!seen[s]) {
+        ws.touched_.Append(s);
+        ws.active_.Append(s);
+      }
+      seen[s] |= bit;
+      frontier[s] |= bit;
+      rows[j][s] = 0;
+    }
+
+    for (double distance = unit_; !ws.active_.isEmpty(); distance += unit_) {
+      for (auto u : ws.active_) {
+        uint64_t bits = frontier[u];
+        frontier[u] = 0;
+
+        graph_.ForEachEdge(u, [&](size_t v, double) {
+          uint64_t fresh = bits & ~seen[v];
+          if (fresh) {
+            if (!next[v]) {
+              ws.nextActive_.Append(v);
+            }
+            next[v] |= fresh;
+          }
+        });
+      }
+
+      ws.active_.Clear();
+
+      for (auto v : ws.nextActive_) {
+        uint64_t fresh = next[v];
+        next[v] = 0;
+
+        if (!seen[v]) {
+          ws.touched_.Append(v);
+        }
+        seen[v] |= fresh;
+        frontier[v] = fresh;
+
+        for (; fresh; fresh &= fresh - 1) {
+          rows[_::lowest_bit_(fresh)][v] = distance;
+        }
+      }
+
+      std::swap(ws.active_, ws.nextActive_);
+    }
+
+    for (auto v : ws.touched_) {
+      seen[v] = 0;
+    }
+    ws.touched_.Clear();
+  }
+};
+
+} // namespace ds
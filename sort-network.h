@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Bitonic sorting-network and merge kernels for small blocks of primitive
+// values. sort.h dispatches to these for int32_t, float and uint64_t when the
+// matching instruction set is enabled at compile time (/arch:AVX2 or
+// /arch:AVX512, -mavx2 or -mavx512f); otherwise simd_<T>::LANES is 1 and the
+// scalar code in sort.h is used unchanged. The x64 project configurations
+// build with /arch:AVX2; Win32 keeps the scalar path.
+
+namespace ds {
+
+namespace _ {
+
+constexpr size_t SIMD_BLOCK = 64;
+
+// Register traits: LANES values per register, lane-wise min/max, a lane
+// permutation that pairs lane i with lane i ^ J, and a blend that takes lane i
+// from the second argument when bit i of M is set.
+template <class T>
+struct simd_ {
+  static constexpr size_t LANES = 1;
+};
+
+#if defined(__AVX2__)
+
+template <>
+struct simd_<int32_t> {
+  using reg = __m256i;
+  static constexpr size_t LANES = 8;
+
+  static reg load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+  static void store(int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+  static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+  static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+
+  template <int J>
+  static reg pair(reg v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+  }
+
+  static reg reverse(reg v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  }
+
+  template <int M>
+  static reg blend(reg a, reg b) { return _mm256_blend_epi32(a, b, M); }
+};
+
+template <>
+struct simd_<float> {
+  using reg = __m256;
+  static constexpr size_t LANES = 8;
+
+  static reg load(const float* p) { return _mm256_loadu_ps(p); }
+  static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+  static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+  static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+
+  template <int J>
+  static reg pair(reg v) {
+    return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+  }
+
+  static reg reverse(reg v) {
+    return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  }
+
+  template <int M>
+  static reg blend(reg a, reg b) { return _mm256_blend_ps(a, b, M); }
+};
+
+#endif // __AVX2__
+
+#if defined(__AVX512F__)
+
+// AVX2 has no unsigned 64-bit min/max, so uint64_t needs AVX-512.
+template <>
+struct simd_<uint64_t> {
+  using reg = __m512i;
+  static constexpr size_t LANES = 8;
+
+  static reg load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+  static void store(uint64_t* p, reg v) { _mm512_storeu_si512(p, v); }
+  static reg min(reg a, reg b) { return _mm512_min_epu64(a, b); }
+  static reg max(reg a, reg b) { return _mm512_max_epu64(a, b); }
+
+  template <int J>
+  static reg pair(reg v) {
+    return _mm512_permutexvar_epi64(_mm512_set_epi64(7 ^ J, 6 ^ J, 5 ^ J, 4 ^ J, 3 ^ J, 2 ^ J, 1 ^ J, 0 ^ J), v);
+  }
+
+  static reg reverse(reg v) {
+    return _mm512_permutexvar_epi64(_mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7), v);
+  }
+
+  template <int M>
+  static reg blend(reg a, reg b) { return _mm512_mask_blend_epi64(static_cast<__mmask8>(M), a, b); }
+};
+
+#endif // __AVX512F__
+
+// Lanes that keep the larger (for ascending order) value of a compare-exchange
+// between lanes i and i ^ j inside a bitonic block of size k.
+constexpr int upper_lanes_(size_t lanes, size_t j, size_t k) {
+  int mask = 0;
+  for (size_t i = 0; i < lanes; ++i) {
+    if (((i & j) != 0) != ((i & k) != 0)) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+}
+
+template <class S, bool Ascending, size_t J, size_t K>
+typename S::reg exchange_(typename S::reg v) {
+  auto other = S::template pair<J>(v);
+  auto lo = Ascending ? S::min(v, other) : S::max(v, other);
+  auto hi = Ascending ? S::max(v, other) : S::min(v, other);
+  return S::template blend<upper_lanes_(S::LANES, J, K)>(lo, hi);
+}
+
+// Sorts the lanes of one register.
+template <class S, bool Ascending>
+typename S::reg sort_register_(typename S::reg v) {
+  static_assert(S::LANES == 8, "sorting network is laid out for 8 lanes");
+
+  v = exchange_<S, Ascending, 1, 2>(v);
+  v = exchange_<S, Ascending, 2, 4>(v);
+  v = exchange_<S, Ascending, 1, 4>(v);
+  v = exchange_<S, Ascending, 4, 8>(v);
+  v = exchange_<S, Ascending, 2, 8>(v);
+  v = exchange_<S, Ascending, 1, 8>(v);
+  return v;
+}
+
+// Merges two sorted registers: a receives the first LANES values, b the rest.
+template <class S, bool Ascending>
+void merge_registers_(typename S::reg& a, typename S::reg& b) {
+  auto r = S::reverse(b);
+  auto lo = Ascending ? S::min(a, r) : S::max(a, r);
+  auto hi = Ascending ? S::max(a, r) : S::min(a, r);
+
+  lo = exchange_<S, Ascending, 4, 8>(lo);
+  lo = exchange_<S, Ascending, 2, 8>(lo);
+  a = exchange_<S, Ascending, 1, 8>(lo);
+
+  hi = exchange_<S, Ascending, 4, 8>(hi);
+  hi = exchange_<S, Ascending, 2, 8>(hi);
+  b = exchange_<S, Ascending, 1, 8>(hi);
+}
+
+template <class T, bool Ascending>
+constexpr bool before_(T lhs, T rhs) {
+  return Ascending ? lhs < rhs : rhs < lhs;
+}
+
+// Merges sorted runs a[0, na) and b[0, nb) into out, which must not overlap
+// either run. Whole registers are merged while both runs can supply one; the
+// remainder is finished with a scalar three-way merge of the carried register
+// and both tails.
+template <class T, bool Ascending>
+void simd_merge(const T* a, size_t na, const T* b, size_t nb, T* out) {
+  using S = simd_<T>;
+  constexpr size_t W = S::LANES;
+
+  size_t ia = 0;
+  size_t ib = 0;
+  size_t o = 0;
+
+  T carry[W];
+  size_t ic = W;
+
+  if (na >= W && nb >= W) {
+    auto lo = S::load(a);
+    auto hi = S::load(b);
+    ia = ib = W;
+
+    merge_registers_<S, Ascending>(lo, hi);
+    S::store(out, lo);
+    o = W;
+
+    while (ia + W <= na && ib + W <= nb) {
+      if (before_<T, Ascending>(b[ib], a[ia])) {
+        lo = S::load(b + ib);
+        ib += W;
+      }
+      else {
+        lo = S::load(a + ia);
+        ia += W;
+      }
+      merge_registers_<S, Ascending>(lo, hi);
+      S::store(out + o, lo);
+      o += W;
+    }
+
+    S::store(carry, hi);
+    ic = 0;
+  }
+
+  while (o < na + nb) {
+    const T* pick = nullptr;
+    size_t* from = nullptr;
+
+    if (ic < W) {
+      pick = &carry[ic];
+      from = &ic;
+    }
+    if (ia < na && (!pick || before_<T, Ascending>(a[ia], *pick))) {
+      pick = &a[ia];
+      from = &ia;
+    }
+    if (ib < nb && (!pick || before_<T, Ascending>(b[ib], *pick))) {
+      pick = &b[ib];
+      from = &ib;
+    }
+
+    out[o++] = *pick;
+    ++(*from);
+  }
+}
+
+// Sorts up to SIMD_BLOCK values in place: the block is padded with a sentinel
+// to a power-of-two number of registers, each register is sorted by the
+// network, and the sorted registers are merged pairwise.
+template <class T, bool Ascending>
+void simd_sort_block(T* p, size_t n) {
+  using S = simd_<T>;
+  constexpr size_t W = S::LANES;
+
+  if (n < 2) {
+    return;
+  }
+
+  alignas(64) T bufA[SIMD_BLOCK];
+  alignas(64) T bufB[SIMD_BLOCK];
+
+  size_t regs = 1;
+  while (regs * W < n) {
+    regs *= 2;
+  }
+  size_t padded = regs * W;
+
+  T sentinel = Ascending
+    ? (std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max())
+    : (std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest());
+
+  std::copy(p, p + n, bufA);
+  std::fill(bufA + n, bufA + padded, sentinel);
+
+  for (size_t r = 0; r < padded; r += W) {
+    S::store(bufA + r, sort_register_<S, Ascending>(S::load(bufA + r)));
+  }
+
+  T* src = bufA;
+  T* dst = bufB;
+
+  for (size_t run = W; run < padded; run *= 2) {
+    for (size_t off = 0; off < padded; off += 2 * run) {
+      simd_merge<T, Ascending>(src + off, run, src + off + run, run, dst + off);
+    }
+    std::swap(src, dst);
+  }
+
+  std::copy(src, src + n, p);
+}
+
+} // namespace _
+
+} // namespace ds
@@ -1,35 +1,108 @@
 #pragma once
 
+#include <functional>
 #include <iterator>
+#include <type_traits>
 #include "list.h"
+#include "compare.h"
+#include "heap.h"
+#include "sort-network.h"
 
 namespace ds {
 
 namespace _ {
 
-template <class T = void>
-struct ascending_ {
-  template <class T>
-  constexpr bool operator()(T&& lhs, T&& rhs) const {
-    return lhs < rhs;
+template <typename RandomAccessIterator, typename Func>
+constexpr bool branchless_v = std::is_arithmetic<typename std::iterator_traits<RandomAccessIterator>::value_type>::value
+  && is_branchless_<std::decay_t<Func>>::value;
+
+// Orders *a and *b so that *b is not before *a. Equal values stay put.
+template <typename RandomAccessIterator, typename Func>
+void compare_swap(RandomAccessIterator a, RandomAccessIterator b, Func& op) {
+  if constexpr (branchless_v<RandomAccessIterator, Func>) {
+    auto x = *a;
+    auto y = *b;
+    bool swap = op(y, x);
+    *a = swap ? y : x;
+    *b = swap ? x : y;
+  }
+  else {
+    if (op(*b, *a)) {
+      std::swap(*a, *b);
+    }
+  }
+}
+
+// Puts the value that op orders last on top of a heap.
+template <typename Func>
+struct reversed_ {
+  Func op_;
+
+  template <class L, class R>
+  bool operator()(const L& lhs, const R& rhs) const {
+    return op_(rhs, lhs);
   }
 };
 
-template <class T = void>
-struct descending_ {
-  template <class T>
-  constexpr bool operator()(T&& lhs, T&& rhs) const {
-    return lhs >= rhs;
+template <typename RandomAccessIterator, typename Func>
+void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Func& op) {
+  for (auto it = first + 1; it < last; ++it) {
+    auto val = std::move(*it);
+    auto hole = it;
+
+    while (hole != first && op(val, *(hole - 1))) {
+      *hole = std::move(*(hole - 1));
+      --hole;
+    }
+    *hole = std::move(val);
   }
+}
+
+// Moves the median of the first, middle and last elements to the front and
+// partitions the rest around it. Returns the pivot's final position.
+template <typename RandomAccessIterator, typename Func>
+RandomAccessIterator partition_pivot(RandomAccessIterator first, RandomAccessIterator last, Func& op) {
+  auto mid = first + (last - first) / 2;
+  auto back = last - 1;
+
+  compare_swap(first, mid, op);
+  compare_swap(mid, back, op);
+  compare_swap(first, mid, op);
+  std::swap(*first, *mid);
+
+  auto i = first + 1;
+  auto j = back;
+
+  while (true) {
+    while (i <= j && op(*i, *first)) ++i;
+    while (i <= j && op(*first, *j)) --j;
+    if (i >= j) break;
+    std::swap(*i, *j);
+    ++i;
+    --j;
+  }
+
+  std::swap(*first, *j);
+  return j;
+}
+
+// Pointer ranges of int32_t, float or uint64_t sorted with the stock
+// comparators can use the sort-network.h kernels when the target has them.
+template <typename RandomAccessIterator, typename Func>
+struct simd_sortable_ {
+  using value_type = std::remove_cv_t<std::remove_pointer_t<RandomAccessIterator>>;
+
+  static constexpr bool ascending = std::is_same<std::decay_t<Func>, ascending_<>>::value;
+  static constexpr bool descending = std::is_same<std::decay_t<Func>, descending_<>>::value;
+  static constexpr bool value = std::is_pointer<RandomAccessIterator>::value
+    && simd_<value_type>::LANES > 1
+    && (ascending || descending);
 };
 
 } // namespace _
 
-static auto ascending = _::ascending_<>{};
-static auto descending = _::descending_<>{};
-
 template <typename RandomAccessIterator, typename Func>
-void merge_sort(RandomAccessIterator first, RandomAccessIterator last, Func& op) {
+void merge_sort(RandomAccessIterator first, RandomAccessIterator last, Func&& op) {
   size_t distance = std::distance(first, last);
   size_t mid = distance / 2;
 
@@ -37,27 +110,51 @@ void merge_sort(RandomAccessIterator first, RandomAccessIterator last, Func& op)
     return;
   }
 
-  if (distance == 2) {
-    if (!op(*first, *(last - 1))) {
-      std::swap(*first, *(last - 1));
+  using simd = _::simd_sortable_<RandomAccessIterator, Func>;
+
+  if constexpr (simd::value) {
+    if (distance <= _::SIMD_BLOCK) {
+      _::simd_sort_block<typename simd::value_type, simd::ascending>(first, distance);
+      return;
     }
+  }
+
+  if (distance == 2) {
+    _::compare_swap(first, last - 1, op);
     return;
   }
 
   merge_sort(first, first + mid, op);
   merge_sort(first + mid, last, op);
 
-  auto la = ArrayList<std::remove_reference<decltype(*first)>::type>(distance);
+  auto la = ArrayList<typename std::iterator_traits<RandomAccessIterator>::value_type>(distance);
 
   la.Add(0, first, last);
   auto it = first;
 
+  if constexpr (simd::value) {
+    _::simd_merge<typename simd::value_type, simd::ascending>(la.begin(), mid, la.begin() + mid, distance - mid, first);
+    return;
+  }
+
   size_t i = 0;
   size_t j = mid;
   size_t k = 0;
 
-  while (i < mid && j < distance) {
-    it[k++] = op(la[i], la[j]) ? std::move(la[i++]) : std::move(la[j++]);
+  // Take from the right run only when it is strictly first, so equal values
+  // keep their order.
+  if constexpr (_::branchless_v<RandomAccessIterator, Func>) {
+    while (i < mid && j < distance) {
+      bool right = op(la[j], la[i]);
+      it[k++] = right ? la[j] : la[i];
+      j += right;
+      i += !right;
+    }
+  }
+  else {
+    while (i < mid && j < distance) {
+      it[k++] = op(la[j], la[i]) ? std::move(la[j++]) : std::move(la[i++]);
+    }
   }
 
   while (i < mid) {
@@ -75,22 +172,46 @@ void merge_sort(RandomAccessIterator first, RandomAccessIterator last) {
 }
 
 template <typename RandomAccessIterator, typename Func>
-void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Func& op) {
+void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Func&& op) {
   size_t distance = std::distance(first, last);
 
   if (distance < 2) return;
 
+  using simd = _::simd_sortable_<RandomAccessIterator, Func>;
+
+  if constexpr (simd::value) {
+    if (distance <= _::SIMD_BLOCK) {
+      _::simd_sort_block<typename simd::value_type, simd::ascending>(first, distance);
+      return;
+    }
+  }
+
   auto pivot = last - 1;
 
   RandomAccessIterator left = first - 1;
   RandomAccessIterator right = first;
 
-  while (right < pivot) {
-    if (op(*right, *pivot)) {
-      ++left;
-      std::swap(*left, *right);
+  if constexpr (_::branchless_v<RandomAccessIterator, Func>) {
+    // Always swap, advance conditionally: [first, left] stays before the
+    // pivot and (left, right) does not.
+    auto p = *pivot;
+    while (right < pivot) {
+      bool before = op(*right, p);
+      auto val = *right;
+      *right = *(left + 1);
+      *(left + 1) = val;
+      left += before;
+      ++right;
+    }
+  }
+  else {
+    while (right < pivot) {
+      if (op(*right, *pivot)) {
+        ++left;
+        std::swap(*left, *right);
+      }
+      ++right;
     }
-    ++right;
   }
 
   std::swap(*pivot, *(left + 1));
@@ -104,4 +225,135 @@ void quick_sort(RandomAccessIterator first, RandomAccessIterator last) {
   quick_sort(first, last, ascending);
 }
 
+// Rearranges [first, last) so that *nth is the element that would be there if
+// the whole range were sorted, with nothing after it ordered before it and
+// nothing before it ordered after it. Introselect: quickselect on a
+// median-of-three pivot, falling back to merge_sort once the recursion depth
+// passes 2*log2(n), so O(n) expected and O(n log n) worst case.
+template <typename RandomAccessIterator, typename Func>
+void nth_element(RandomAccessIterator first, RandomAccessIterator nth, RandomAccessIterator last, Func&& op) {
+  constexpr ptrdiff_t INSERTION_THRESHOLD = 16;
+
+  if (nth == last) {
+    return;
+  }
+
+  size_t depth = 2 * c_log2(std::distance(first, last));
+
+  while (last - first > INSERTION_THRESHOLD) {
+    if (depth-- == 0) {
+      merge_sort(first, last, op);
+      return;
+    }
+
+    auto cut = _::partition_pivot(first, last, op);
+
+    if (cut == nth) {
+      return;
+    }
+
+    if (nth < cut) {
+      last = cut;
+    }
+    else {
+      first = cut + 1;
+    }
+  }
+
+  if (first < last) {
+    _::insertion_sort(first, last, op);
+  }
+}
+
+template <typename RandomAccessIterator>
+void nth_element(RandomAccessIterator first, RandomAccessIterator nth, RandomAccessIterator last) {
+  ds::nth_element(first, nth, last, ascending);
+}
+
+// Sorts [first, middle) with the smallest elements of [first, last) under op.
+// The order of [middle, last) is unspecified. O(n + k log k) expected.
+template <typename RandomAccessIterator, typename Func>
+void partial_sort(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Func&& op) {
+  if (first == middle) {
+    return;
+  }
+
+  ds::nth_element(first, middle - 1, last, op);
+  merge_sort(first, middle, op);
+}
+
+template <typename RandomAccessIterator>
+void partial_sort(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last) {
+  ds::partial_sort(first, middle, last, ascending);
+}
+
+// Keeps the k values that come first under op among all those pushed, in O(k)
+// memory and O(log k) per Push. The heap's top is the worst value kept so
+// far, so anything that does not beat it is rejected with a single
+// comparison. Result() drains the heap, leaving the TopK empty.
+template <class T, typename Func = _::ascending_<>>
+class TopK {
+public:
+  TopK(size_t k, Func op = Func())
+      : k_(k),
+        op_(op),
+        heap_(k, _::reversed_<Func>{ op }) {
+
+  }
+
+  size_t Size() const {
+    return heap_.Size();
+  }
+
+  void Push(const T& val) {
+    if (k_ == 0) {
+      return;
+    }
+
+    if (heap_.Size() < k_) {
+      heap_.Insert(val);
+      return;
+    }
+
+    if (op_(val, heap_.Top())) {
+      heap_.Replace(val);
+    }
+  }
+
+  // Drains the kept values, ordered by op.
+  ArrayList<T> Result() {
+    ArrayList<T> out(heap_.Size());
+
+    while (!heap_.isEmpty()) {
+      out.Append(heap_.Pop());
+    }
+    std::reverse(out.begin(), out.end());
+
+    return out;
+  }
+
+private:
+  size_t k_;
+  Func op_;
+  BinHeap<T, _::reversed_<Func>> heap_;
+};
+
+template <typename InputIterator, typename Func>
+auto top_k(InputIterator first, InputIterator last, size_t k, Func&& op) {
+  using T = typename std::iterator_traits<InputIterator>::value_type;
+
+  TopK<T, std::decay_t<Func>> selector(k, std::forward<Func>(op));
+
+  for (; first != last; ++first) {
+    selector.Push(*first);
+  }
+
+  return selector.Result();
+}
+
+template <typename InputIterator>
+auto top_k(InputIterator first, InputIterator last, size_t k) {
+  return top_k(first, last, k, ascending);
+}
+
 } // namespace ds
\ No newline at end of file
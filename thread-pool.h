@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "list.h"
+
+namespace ds {
+
+// Fixed set of worker threads for fork-join loops. Run hands one job to every
+// thread, the caller included as worker 0, and returns once all of them have
+// finished it, so a level-synchronous algorithm pays a wake-up per step rather
+// than a thread start. One thread at a time may call Run or ParallelFor.
+class ThreadPool {
+public:
+  // threads == 0 uses one per hardware thread.
+  explicit ThreadPool(size_t threads = 0)
+      : stop_(false),
+        generation_(0),
+        pending_(0),
+        workers_() {
+    size_t n = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < n; ++i) {
+      workers_.Append(std::thread([this, i]() { run(i); }));
+    }
+  }
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Number of threads taking part in a job, the caller included.
+  size_t Size() const {
+    return workers_.Size() + 1;
+  }
+
+  // Calls f(worker) once on each thread, worker in [0, Size()).
+  template <class Func>
+  void Run(Func&& f) {
+    if (workers_.isEmpty()) {
+      f(size_t(0));
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      job_ = [&f](size_t worker) { f(worker); };
+      pending_ = workers_.Size();
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    f(size_t(0));
+
+    std::unique_lock<std::mutex> lock(lock_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+  }
+
+  // Splits [begin, end) into chunks of grain and calls f(lo, hi, worker) for
+  // each; threads take the next chunk as they finish, which balances skewed
+  // work such as high-degree nodes.
+  template <class Func>
+  void ParallelFor(size_t begin, size_t end, size_t grain, Func&& f) {
+    std::atomic<size_t> next(begin);
+    grain = std::max<size_t>(grain, 1);
+
+    Run([&](size_t worker) {
+      while (true) {
+        size_t lo = next.fetch_add(grain, std::memory_order_relaxed);
+        if (lo >= end) {
+          break;
+        }
+        f(lo, std::min(lo + grain, end), worker);
+      }
+    });
+  }
+
+private:
+  std::mutex lock_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_;
+  size_t generation_;
+  size_t pending_;
+  std::function<void(size_t)> job_;
+  ArrayList<std::thread> workers_;
+
+  void run(size_t worker) {
+    size_t seen = 0;
+
+    while (true) {
+      std::function<void(size_t)> job;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        wake_.wait(lock, [this, seen]() { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+        job = job_;
+      }
+
+      job(worker);
+
+      std::lock_guard<std::mutex> lock(lock_);
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+};
+
+} // namespace ds
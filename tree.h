@@ -6,6 +6,7 @@
 #include <map>
 #include <unordered_map>
 #include "common.h"
+#include "list.h"
 
 namespace ds {
 
@@ -331,6 +332,870 @@ private:
 
 };
 
+namespace _ {
+
+// The parent link a FlatAVLTree node carries when it keeps them; empty, and
+// so free in the node's layout, when it does not.
+template <class Index, bool Parent>
+struct avl_parent_ {
+  Index parent_;
+};
+
+template <class Index>
+struct avl_parent_<Index, false> {
+};
+
+} // namespace _
+
+// AVL tree whose nodes live in one contiguous pool and refer to each other by
+// Index, so a node is its value, two child indices and a byte of height, with
+// no allocation or refcount per node. Removed nodes go on a free list threaded
+// through left_ and are reused by later inserts. Updates rebalance on the way
+// back up the search path, so parent links are only kept, in one more Index
+// per node, when ParentLinks asks for them. A node handle stays valid until
+// its value is removed; values are compared with operator<.
+template <class T, class Index = uint32_t, bool ParentLinks = false>
+class FlatAVLTree {
+  static_assert(std::is_unsigned<Index>::value, "node indices must be unsigned");
+
+  struct Node : _::avl_parent_<Index, ParentLinks> {
+    T value_;
+    Index left_;
+    Index right_;
+    uint8_t height_;
+  };
+
+public:
+  static constexpr Index NIL = std::numeric_limits<Index>::max();
+  static constexpr size_t NODE_SIZE = sizeof(Node);
+
+  FlatAVLTree()
+      : nodes_(),
+        root_(NIL),
+        free_(NIL),
+        count_(0) {
+
+  }
+
+  static FlatAVLTree FromList(std::initializer_list<T>&& list) {
+    FlatAVLTree tree;
+    tree.Reserve(list.size());
+    for (auto& value : list) {
+      tree.Insert(value);
+    }
+    return tree;
+  }
+
+  size_t Size() const {
+    return count_;
+  }
+
+  bool isEmpty() const {
+    return count_ == 0;
+  }
+
+  size_t Height() const {
+    return height(root_);
+  }
+
+  // Makes room for capacity nodes in the pool.
+  void Reserve(size_t capacity) {
+    assert(capacity < NIL);
+    nodes_.Reserve(capacity);
+  }
+
+  void Clear() {
+    nodes_.Clear();
+    root_ = NIL;
+    free_ = NIL;
+    count_ = 0;
+  }
+
+  std::optional<Index> Root() const {
+    return handle(root_);
+  }
+
+  const T& Value(Index node) const {
+    check_bounds(node, nodes_.Size());
+    return nodes_.begin()[node].value_;
+  }
+
+  std::optional<Index> Parent(Index node) const {
+    static_assert(ParentLinks, "the tree keeps no parent links");
+    check_bounds(node, nodes_.Size());
+    return handle(nodes_.begin()[node].parent_);
+  }
+
+  // Returns false if an equal value was already there.
+  template <class U>
+  bool Insert(U&& value) {
+    bool inserted = false;
+    bool grew = false;
+    root_ = insert(root_, std::forward<U>(value), inserted, grew);
+    unparent(root_);
+    return inserted;
+  }
+
+  std::optional<Index> Find(const T& value) const {
+    const Node* nodes = nodes_.begin();
+    Index n = root_;
+
+    while (n != NIL) {
+      if (value < nodes[n].value_) {
+        n = nodes[n].left_;
+      }
+      else if (nodes[n].value_ < value) {
+        n = nodes[n].right_;
+      }
+      else {
+        return n;
+      }
+    }
+
+    return {};
+  }
+
+  std::optional<Index> FindMin() const {
+    if (root_ == NIL) {
+      return {};
+    }
+
+    const Node* nodes = nodes_.begin();
+    Index n = root_;
+    while (nodes[n].left_ != NIL) {
+      n = nodes[n].left_;
+    }
+    return n;
+  }
+
+  // Returns false if no value was equal.
+  bool Remove(const T& value) {
+    bool removed = false;
+    root_ = remove(root_, value, removed);
+    unparent(root_);
+    return removed;
+  }
+
+  template <typename Func>
+  void PreorderTraversal(Func& f) const {
+    preorder(root_, f);
+  }
+
+  template <typename Func>
+  void InorderTraversal(Func& f) const {
+    inorder(root_, f);
+  }
+
+  template <typename Func>
+  void PostorderTraversal(Func& f) const {
+    postorder(root_, f);
+  }
+
+private:
+  ArrayList<Node> nodes_;
+  Index root_;
+  Index free_;
+  size_t count_;
+
+  static std::optional<Index> handle(Index n) {
+    if (n == NIL) {
+      return {};
+    }
+    return n;
+  }
+
+  size_t height(Index n) const {
+    return n == NIL ? 0 : nodes_.begin()[n].height_;
+  }
+
+  void unparent(Index n) {
+    if constexpr (ParentLinks) {
+      if (n != NIL) {
+        nodes_[n].parent_ = NIL;
+      }
+    }
+  }
+
+  // Pool growth may move the nodes, so callers hold indices, not references,
+  // across a call.
+  template <class U>
+  Index allocate(U&& value) {
+    Index n = free_;
+    if (n != NIL) {
+      free_ = nodes_[n].left_;
+    }
+    else {
+      assert(nodes_.Size() < NIL);
+      n = static_cast<Index>(nodes_.Size());
+      nodes_.Append(Node());
+    }
+
+    Node& node = nodes_[n];
+    node.value_ = std::forward<U>(value);
+    node.left_ = NIL;
+    node.right_ = NIL;
+    node.height_ = 1;
+    ++count_;
+    return n;
+  }
+
+  void release(Index n) {
+    nodes_[n].value_ = T();
+    nodes_[n].left_ = free_;
+    free_ = n;
+    --count_;
+  }
+
+  // Recomputes n's height from its children, and points them back at it.
+  void update(Index n) {
+    Node& node = nodes_[n];
+    node.height_ = static_cast<uint8_t>(1 + std::max(height(node.left_), height(node.right_)));
+
+    if constexpr (ParentLinks) {
+      if (node.left_ != NIL) {
+        nodes_[node.left_].parent_ = n;
+      }
+      if (node.right_ != NIL) {
+        nodes_[node.right_].parent_ = n;
+      }
+    }
+  }
+
+  Index rotateRight(Index n) {
+    Index l = nodes_[n].left_;
+    nodes_[n].left_ = nodes_[l].right_;
+    nodes_[l].right_ = n;
+    update(n);
+    update(l);
+    return l;
+  }
+
+  Index rotateLeft(Index n) {
+    Index r = nodes_[n].right_;
+    nodes_[n].right_ = nodes_[r].left_;
+    nodes_[r].left_ = n;
+    update(n);
+    update(r);
+    return r;
+  }
+
+  // Restores the AVL property at n, whose subtrees differ in height by at
+  // most two, and returns the subtree's new root.
+  Index balance(Index n) {
+    Index l = nodes_[n].left_;
+    Index r = nodes_[n].right_;
+    size_t lh = height(l);
+    size_t rh = height(r);
+
+    if (lh > rh + 1) {
+      if (height(nodes_[l].left_) < height(nodes_[l].right_)) {
+        nodes_[n].left_ = rotateLeft(l);
+      }
+      return rotateRight(n);
+    }
+    if (rh > lh + 1) {
+      if (height(nodes_[r].right_) < height(nodes_[r].left_)) {
+        nodes_[n].right_ = rotateRight(r);
+      }
+      return rotateLeft(n);
+    }
+
+    update(n);
+    return n;
+  }
+
+  // grew reports whether the subtree got taller; once one doesn't, nothing
+  // above it changes, so the rest of the path is left alone.
+  template <class U>
+  Index insert(Index n, U&& value, bool& inserted, bool& grew) {
+    if (n == NIL) {
+      inserted = true;
+      grew = true;
+      return allocate(std::forward<U>(value));
+    }
+
+    Index child;
+    if (value < nodes_[n].value_) {
+      child = insert(nodes_[n].left_, std::forward<U>(value), inserted, grew);
+      nodes_[n].left_ = child;
+    }
+    else if (nodes_[n].value_ < value) {
+      child = insert(nodes_[n].right_, std::forward<U>(value), inserted, grew);
+      nodes_[n].right_ = child;
+    }
+    else {
+      return n;
+    }
+
+    if (!grew) {
+      // The child may be a new subtree root from a rotation.
+      if constexpr (ParentLinks) {
+        nodes_[child].parent_ = n;
+      }
+      return n;
+    }
+
+    size_t before = nodes_[n].height_;
+    n = balance(n);
+    grew = nodes_[n].height_ > before;
+    return n;
+  }
+
+  // Unlinks the leftmost node under n into min.
+  Index removeMin(Index n, Index& min) {
+    if (nodes_[n].left_ == NIL) {
+      min = n;
+      return nodes_[n].right_;
+    }
+
+    nodes_[n].left_ = removeMin(nodes_[n].left_, min);
+    return balance(n);
+  }
+
+  Index remove(Index n, const T& value, bool& removed) {
+    if (n == NIL) {
+      return NIL;
+    }
+
+    if (value < nodes_[n].value_) {
+      nodes_[n].left_ = remove(nodes_[n].left_, value, removed);
+    }
+    else if (nodes_[n].value_ < value) {
+      nodes_[n].right_ = remove(nodes_[n].right_, value, removed);
+    }
+    else {
+      removed = true;
+      Index l = nodes_[n].left_;
+      Index r = nodes_[n].right_;
+      release(n);
+
+      if (l == NIL || r == NIL) {
+        return l != NIL ? l : r;
+      }
+
+      // The successor takes the removed node's place.
+      Index successor;
+      r = removeMin(r, successor);
+      nodes_[successor].left_ = l;
+      nodes_[successor].right_ = r;
+      n = successor;
+    }
+
+    return removed ? balance(n) : n;
+  }
+
+  template <typename Func>
+  void preorder(Index n, Func& f) const {
+    if (n != NIL) {
+      const Node& node = nodes_.begin()[n];
+      f(node.value_);
+      preorder(node.left_, f);
+      preorder(node.right_, f);
+    }
+  }
+
+  template <typename Func>
+  void inorder(Index n, Func& f) const {
+    if (n != NIL) {
+      const Node& node = nodes_.begin()[n];
+      inorder(node.left_, f);
+      f(node.value_);
+      inorder(node.right_, f);
+    }
+  }
+
+  template <typename Func>
+  void postorder(Index n, Func& f) const {
+    if (n != NIL) {
+      const Node& node = nodes_.begin()[n];
+      postorder(node.left_, f);
+      postorder(node.right_, f);
+      f(node.value_);
+    }
+  }
+};
+
+// Ordered map from K to V in nodes of about NodeBytes, so a lookup takes one
+// cache miss per level of a shallow tree instead of one per binary level.
+// Keys and values live in leaves, linked in key order for range scans; inner
+// nodes hold only separator keys and child indices. Both kinds of node sit
+// in flat pools addressed by 32-bit index, as in FlatAVLTree. Keys are
+// compared with operator<, scanned linearly within a node when they are
+// arithmetic and binary searched otherwise. Remove is lazy: it never merges
+// nodes, so a leaf may be left underfull or empty, and iteration steps over
+// empty leaves.
+template <class K, class V, size_t NodeBytes = 256>
+class BPlusTree {
+  using Index = uint32_t;
+
+public:
+  static constexpr Index NIL = std::numeric_limits<Index>::max();
+  static constexpr size_t LEAF_KEYS = std::max<size_t>(3, (NodeBytes - 2 * sizeof(Index)) / (sizeof(K) + sizeof(V)));
+  static constexpr size_t INNER_KEYS = std::max<size_t>(3, (NodeBytes - 2 * sizeof(Index)) / (sizeof(K) + sizeof(Index)));
+
+private:
+  struct alignas(64) Leaf {
+    Index count_;
+    Index next_;
+    K keys_[LEAF_KEYS];
+    V values_[LEAF_KEYS];
+  };
+
+  // children_[i] holds the keys below keys_[i], and children_[count_] the
+  // rest; each separator is the smallest key of the child to its right.
+  struct alignas(64) Inner {
+    Index count_;
+    K keys_[INNER_KEYS];
+    Index children_[INNER_KEYS + 1];
+  };
+
+  // Deep enough for 2^32 nodes at the minimum fanout of two.
+  static constexpr size_t MAX_DEPTH = 33;
+
+public:
+  // A position in the leaf chain; the end is past the last leaf.
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<const K&, const V&>;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    Iterator(const BPlusTree* tree, Index leaf, Index slot)
+        : tree_(tree),
+          leaf_(leaf),
+          slot_(slot) {
+
+    }
+
+    const K& Key() const {
+      return tree_->leaves_.begin()[leaf_].keys_[slot_];
+    }
+
+    const V& Value() const {
+      return tree_->leaves_.begin()[leaf_].values_[slot_];
+    }
+
+    value_type operator*() const {
+      return { Key(), Value() };
+    }
+
+    Iterator& operator++() {
+      const Leaf& leaf = tree_->leaves_.begin()[leaf_];
+      if (++slot_ == leaf.count_) {
+        leaf_ = tree_->nonEmpty(leaf.next_);
+        slot_ = 0;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator temp = *this;
+      ++(*this);
+      return temp;
+    }
+
+    bool operator==(const Iterator& rhs) const {
+      return leaf_ == rhs.leaf_ && slot_ == rhs.slot_;
+    }
+
+    bool operator!=(const Iterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+  private:
+    friend class BPlusTree;
+
+    const BPlusTree* tree_;
+    Index leaf_;
+    Index slot_;
+  };
+
+  BPlusTree()
+      : leaves_(),
+        inners_(),
+        root_(NIL),
+        first_(NIL),
+        depth_(0),
+        count_(0) {
+
+  }
+
+  // Builds the tree bottom up from pairs sorted by strictly increasing key,
+  // e.g. the output of merge_sort, with every node as full as an even split
+  // allows: O(n) and no search or split on the way.
+  template <class ForwardIterator>
+  static BPlusTree FromSorted(ForwardIterator first, ForwardIterator last) {
+    BPlusTree tree;
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) {
+      return tree;
+    }
+
+    size_t leafCount = (n + LEAF_KEYS - 1) / LEAF_KEYS;
+    assert(leafCount < NIL);
+    tree.leaves_.Reserve(leafCount);
+
+    // The level being built, as the smallest key and index of each node.
+    ArrayList<std::pair<K, Index>> level(leafCount);
+    const K* previous = nullptr;
+    for (size_t l = 0; l < leafCount; ++l) {
+      size_t size = n / leafCount + (l < n % leafCount);
+      Index index = tree.allocateLeaf();
+      Leaf& leaf = tree.leaves_[index];
+      for (size_t i = 0; i < size; ++i, ++first) {
+        assert(!previous || *previous < first->first);
+        leaf.keys_[i] = first->first;
+        leaf.values_[i] = first->second;
+        previous = &leaf.keys_[i];
+      }
+      leaf.count_ = static_cast<Index>(size);
+      leaf.next_ = l + 1 < leafCount ? index + 1 : NIL;
+      level.Append(std::make_pair(leaf.keys_[0], index));
+    }
+    tree.count_ = n;
+    tree.first_ = 0;
+
+    while (level.Size() > 1) {
+      size_t nodes = (level.Size() + INNER_KEYS) / (INNER_KEYS + 1);
+      ArrayList<std::pair<K, Index>> above(nodes);
+      size_t child = 0;
+
+      for (size_t m = 0; m < nodes; ++m) {
+        size_t size = level.Size() / nodes + (m < level.Size() % nodes);
+        Index index = tree.allocateInner();
+        Inner& inner = tree.inners_[index];
+        inner.count_ = static_cast<Index>(size - 1);
+        for (size_t i = 0; i < size; ++i, ++child) {
+          if (i > 0) {
+            inner.keys_[i - 1] = level.begin()[child].first;
+          }
+          inner.children_[i] = level.begin()[child].second;
+        }
+        above.Append(std::make_pair(level.begin()[child - size].first, index));
+      }
+
+      level = std::move(above);
+      ++tree.depth_;
+    }
+
+    tree.root_ = level.begin()[0].second;
+    return tree;
+  }
+
+  size_t Size() const {
+    return count_;
+  }
+
+  bool isEmpty() const {
+    return count_ == 0;
+  }
+
+  // Levels of inner nodes above the leaves.
+  size_t Depth() const {
+    return depth_;
+  }
+
+  void Clear() {
+    leaves_.Clear();
+    inners_.Clear();
+    root_ = NIL;
+    first_ = NIL;
+    depth_ = 0;
+    count_ = 0;
+  }
+
+  // Sets key's value. Returns true if the key is new.
+  bool Insert(const K& key, V value) {
+    if (root_ == NIL) {
+      root_ = first_ = allocateLeaf();
+      Leaf& leaf = leaves_[root_];
+      leaf.next_ = NIL;
+      leaf.count_ = 1;
+      leaf.keys_[0] = key;
+      leaf.values_[0] = std::move(value);
+      count_ = 1;
+      return true;
+    }
+
+    // The inner nodes passed on the way down and the child taken from each.
+    std::pair<Index, Index> path[MAX_DEPTH];
+    Index n = root_;
+    for (size_t level = 0; level < depth_; ++level) {
+      const Inner& inner = inners_.begin()[n];
+      Index child = upper(inner.keys_, inner.count_, key);
+      path[level] = { n, child };
+      n = inner.children_[child];
+    }
+
+    Leaf& leaf = leaves_[n];
+    Index slot = lower(leaf.keys_, leaf.count_, key);
+    if (slot < leaf.count_ && !(key < leaf.keys_[slot])) {
+      leaf.values_[slot] = std::move(value);
+      return false;
+    }
+    ++count_;
+
+    if (leaf.count_ < LEAF_KEYS) {
+      insertAt(leaf.keys_, leaf.count_, slot, key);
+      insertAt(leaf.values_, leaf.count_, slot, std::move(value));
+      ++leaf.count_;
+      return true;
+    }
+
+    // Split the full leaf, then push the right half's first key up until a
+    // node has room for it, growing a new root if none does.
+    Index right = splitLeaf(n, slot, key, std::move(value));
+    K separator = leaves_.begin()[right].keys_[0];
+
+    for (size_t level = depth_; level-- > 0;) {
+      Index parent = path[level].first;
+      Index at = path[level].second;
+      Inner& inner = inners_[parent];
+      if (inner.count_ < INNER_KEYS) {
+        insertAt(inner.keys_, inner.count_, at, separator);
+        insertAt(inner.children_, inner.count_ + 1, at + 1, right);
+        ++inner.count_;
+        return true;
+      }
+      right = splitInner(parent, at, separator, right);
+    }
+
+    Index root = allocateInner();
+    Inner& inner = inners_[root];
+    inner.count_ = 1;
+    inner.keys_[0] = separator;
+    inner.children_[0] = root_;
+    inner.children_[1] = right;
+    root_ = root;
+    ++depth_;
+    return true;
+  }
+
+  // The value stored for key, or nullptr.
+  V* Find(const K& key) {
+    return const_cast<V*>(static_cast<const BPlusTree*>(this)->Find(key));
+  }
+
+  const V* Find(const K& key) const {
+    Iterator it = LowerBound(key);
+    if (it == end() || key < it.Key()) {
+      return nullptr;
+    }
+    return &it.Value();
+  }
+
+  bool Contains(const K& key) const {
+    return Find(key) != nullptr;
+  }
+
+  // Removes key. Returns true if it was there. The leaf is not merged with a
+  // neighbour however few entries it keeps; separators above it stay valid
+  // bounds, so later searches and inserts are unaffected.
+  bool Remove(const K& key) {
+    if (root_ == NIL) {
+      return false;
+    }
+
+    Leaf& leaf = leaves_[descend(key)];
+    Index slot = lower(leaf.keys_, leaf.count_, key);
+    if (slot == leaf.count_ || key < leaf.keys_[slot]) {
+      return false;
+    }
+
+    std::move(leaf.keys_ + slot + 1, leaf.keys_ + leaf.count_, leaf.keys_ + slot);
+    std::move(leaf.values_ + slot + 1, leaf.values_ + leaf.count_, leaf.values_ + slot);
+    --leaf.count_;
+    leaf.keys_[leaf.count_] = K();
+    leaf.values_[leaf.count_] = V();
+
+    if (--count_ == 0) {
+      Clear();
+    }
+    return true;
+  }
+
+  // The first entry whose key is not less than key.
+  Iterator LowerBound(const K& key) const {
+    if (root_ == NIL) {
+      return end();
+    }
+
+    const Leaf& leaf = leaves_.begin()[descend(key)];
+    Index slot = lower(leaf.keys_, leaf.count_, key);
+    return slot < leaf.count_ ? Iterator(this, static_cast<Index>(&leaf - leaves_.begin()), slot)
+                              : Iterator(this, nonEmpty(leaf.next_), 0);
+  }
+
+  // The first entry whose key is greater than key.
+  Iterator UpperBound(const K& key) const {
+    if (root_ == NIL) {
+      return end();
+    }
+
+    const Leaf& leaf = leaves_.begin()[descend(key)];
+    Index slot = upper(leaf.keys_, leaf.count_, key);
+    return slot < leaf.count_ ? Iterator(this, static_cast<Index>(&leaf - leaves_.begin()), slot)
+                              : Iterator(this, nonEmpty(leaf.next_), 0);
+  }
+
+  // Calls f(key, value) for each entry with lo <= key < hi, in key order,
+  // walking the leaf chain from one descent.
+  template <class Func>
+  void Range(const K& lo, const K& hi, Func&& f) const {
+    Iterator it = LowerBound(lo);
+    const Leaf* leaves = leaves_.begin();
+
+    for (Index l = it.leaf_, slot = it.slot_; l != NIL; l = leaves[l].next_, slot = 0) {
+      const Leaf& leaf = leaves[l];
+      for (; slot < leaf.count_; ++slot) {
+        if (!(leaf.keys_[slot] < hi)) {
+          return;
+        }
+        f(leaf.keys_[slot], leaf.values_[slot]);
+      }
+    }
+  }
+
+  Iterator begin() const {
+    return Iterator(this, nonEmpty(first_), 0);
+  }
+
+  Iterator end() const {
+    return Iterator(this, NIL, 0);
+  }
+
+private:
+  ArrayList<Leaf> leaves_;
+  ArrayList<Inner> inners_;
+  Index root_;
+  Index first_;
+  size_t depth_;
+  size_t count_;
+
+  // Number of keys less than key: the slot key belongs in.
+  static Index lower(const K* keys, Index count, const K& key) {
+    if constexpr (std::is_arithmetic<K>::value) {
+      Index n = 0;
+      for (Index i = 0; i < count; ++i) {
+        n += keys[i] < key;
+      }
+      return n;
+    }
+    else {
+      return static_cast<Index>(std::lower_bound(keys, keys + count, key) - keys);
+    }
+  }
+
+  // Number of keys not greater than key: the child key belongs under.
+  static Index upper(const K* keys, Index count, const K& key) {
+    if constexpr (std::is_arithmetic<K>::value) {
+      Index n = 0;
+      for (Index i = 0; i < count; ++i) {
+        n += !(key < keys[i]);
+      }
+      return n;
+    }
+    else {
+      return static_cast<Index>(std::upper_bound(keys, keys + count, key) - keys);
+    }
+  }
+
+  // Shifts [at, count) of a node array right by one and puts value at at.
+  template <class U>
+  static void insertAt(U* array, size_t count, size_t at, U value) {
+    std::move_backward(array + at, array + count, array + count + 1);
+    array[at] = std::move(value);
+  }
+
+  // The first leaf from leaf on in the chain that has entries, or NIL.
+  Index nonEmpty(Index leaf) const {
+    while (leaf != NIL && leaves_.begin()[leaf].count_ == 0) {
+      leaf = leaves_.begin()[leaf].next_;
+    }
+    return leaf;
+  }
+
+  // The leaf that holds key, or would.
+  Index descend(const K& key) const {
+    const Inner* inners = inners_.begin();
+    Index n = root_;
+    for (size_t level = 0; level < depth_; ++level) {
+      const Inner& inner = inners[n];
+      n = inner.children_[upper(inner.keys_, inner.count_, key)];
+    }
+    return n;
+  }
+
+  // Pool growth may move the nodes, so references are taken after these.
+  Index allocateLeaf() {
+    assert(leaves_.Size() < NIL);
+    leaves_.Append(Leaf());
+    return static_cast<Index>(leaves_.Size() - 1);
+  }
+
+  Index allocateInner() {
+    assert(inners_.Size() < NIL);
+    inners_.Append(Inner());
+    return static_cast<Index>(inners_.Size() - 1);
+  }
+
+  // Splits the full leaf n around a new entry at slot, linking the new
+  // right half after it, and returns the right half.
+  Index splitLeaf(Index n, Index slot, const K& key, V&& value) {
+    Index right = allocateLeaf();
+    Leaf& l = leaves_[n];
+    Leaf& r = leaves_[right];
+
+    constexpr Index LEFT = static_cast<Index>((LEAF_KEYS + 1) / 2);
+    Index from = slot < LEFT ? LEFT - 1 : LEFT;
+    r.count_ = static_cast<Index>(LEAF_KEYS - from);
+    std::move(l.keys_ + from, l.keys_ + LEAF_KEYS, r.keys_);
+    std::move(l.values_ + from, l.values_ + LEAF_KEYS, r.values_);
+    l.count_ = from;
+
+    Leaf& target = slot < LEFT ? l : r;
+    Index at = slot < LEFT ? slot : slot - LEFT;
+    insertAt(target.keys_, target.count_, at, key);
+    insertAt(target.values_, target.count_, at, std::move(value));
+    ++target.count_;
+
+    r.next_ = l.next_;
+    l.next_ = right;
+    return right;
+  }
+
+  // Splits the full inner node n around a new separator at slot at, with
+  // child to its right, and returns the right half. separator becomes the
+  // key the parent needs to tell the halves apart.
+  Index splitInner(Index n, Index at, K& separator, Index child) {
+    Index right = allocateInner();
+    Inner& l = inners_[n];
+    Inner& r = inners_[right];
+
+    K keys[INNER_KEYS + 1];
+    Index children[INNER_KEYS + 2];
+    std::move(l.keys_, l.keys_ + INNER_KEYS, keys);
+    std::copy(l.children_, l.children_ + INNER_KEYS + 1, children);
+    insertAt(keys, INNER_KEYS, at, separator);
+    insertAt(children, INNER_KEYS + 1, at + 1, child);
+
+    // The middle key moves up rather than staying in either half.
+    constexpr size_t LEFT = (INNER_KEYS + 1) / 2;
+    l.count_ = static_cast<Index>(LEFT);
+    std::move(keys, keys + LEFT, l.keys_);
+    std::copy(children, children + LEFT + 1, l.children_);
+
+    r.count_ = static_cast<Index>(INNER_KEYS - LEFT);
+    std::move(keys + LEFT + 1, keys + INNER_KEYS + 1, r.keys_);
+    std::copy(children + LEFT + 1, children + INNER_KEYS + 2, r.children_);
+
+    separator = std::move(keys[LEFT]);
+    return right;
+  }
+};
+
 
 const char TERM = '*';
 